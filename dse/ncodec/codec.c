@@ -2,6 +2,8 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <stdlib.h>
+#include <string.h>
 #include "codec.h"  // NOLINT
 
 
@@ -95,6 +97,62 @@ NULL
 extern NCODEC* ncodec_create(const char* mime_type);
 
 
+/**
+ncodec_compile
+==============
+
+> Implemented in Codec library (optional).
+
+Compile a MIMEtype into a descriptor. Descriptors are interned by the codec
+library, compiling the same MIMEtype again returns the same descriptor.
+Descriptors are immutable and remain valid for the lifetime of the process,
+compile only the MIMEtypes which are shared by many codec objects (i.e. without
+per-instance parameters such as `node_id`). A codec library may also intern
+the MIMEtype passed to `ncodec_create`, without its per-instance parameters.
+
+Parameters
+----------
+mime_type (const char*)
+: The MIMEtype specifier.
+
+Returns
+-------
+NCodecDescriptor (pointer)
+: A descriptor which can be used with `ncodec_create_from_descriptor`.
+
+NULL
+: This codec library does not support the specified MIMEtype.
+*/
+extern const NCodecDescriptor* ncodec_compile(const char* mime_type);
+
+
+/**
+ncodec_create_from_descriptor
+=============================
+
+> Implemented in Codec library (optional).
+
+Create a Network Codec object from a descriptor without parsing its MIMEtype,
+the cost of creating many codec objects of the same MIMEtype is then limited
+to the allocation of each object.
+
+Parameters
+----------
+descriptor (const NCodecDescriptor*)
+: A descriptor returned by `ncodec_compile`.
+
+Returns
+-------
+NCODEC (pointer)
+: The Network Codec object (without a connected stream).
+
+NULL
+: The descriptor was not valid.
+*/
+extern NCODEC* ncodec_create_from_descriptor(
+    const NCodecDescriptor* descriptor);
+
+
 /**
 ncodec_config
 =============
@@ -195,6 +253,184 @@ inline int32_t ncodec_write(NCODEC* nc, NCodecMessage* msg)
 }
 
 
+/**
+ncodec_write_batch
+==================
+
+Write an array of messages to the Network Codec object in a single call. The
+codec implementation may use this call to encode all messages in one pass
+(e.g. reserving space for all messages up front).
+
+The caller owns the message buffer/memory, the same conditions as for
+`ncodec_write` apply. Trace functions are called (by the codec
+implementation) for each message written.
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object.
+
+msgs (NCodecMessage*)
+: Array of messages to write to the Network Codec. Caller owns the
+  message buffer/memory. Message type is defined by the codec implementation.
+
+count (size_t)
+: The number of messages in the `msgs` array.
+
+Returns
+-------
++VE (int32_t)
+: The number of messages written to the Network Codec. Will be identical to
+  the value provided in `count`, unless memory for all messages could not be
+  allocated, in which case only the first (returned number of) messages were
+  written.
+
+-ENOMEM (-12)
+: No message could be written (memory allocation failed).
+
+-ENOSTR (-60)
+: The object represented by `nc` does not represent a valid stream.
+
+-ENOSR (-63)
+: No stream resource has been configured.
+
+-ENOSYS (-38)
+: The Network Codec does not support batch operations.
+
+-EINVAL (-22)
+: Bad `msgs` argument.
+*/
+inline int32_t ncodec_write_batch(
+    NCODEC* nc, NCodecMessage* msgs, size_t count)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->codec.write_batch) {
+        return _nc->codec.write_batch(nc, msgs, count);
+    } else {
+        return -ENOSYS;
+    }
+}
+
+
+/**
+ncodec_write_reserve
+====================
+
+Reserve space for the payload of a message directly in the internal buffers of
+the Network Codec object. The caller may then serialize the payload directly
+into the returned buffer (avoiding an intermediate copy) and complete the
+message with a call to `ncodec_write_commit`.
+
+The message header (e.g. `NCodecCanMessage` or `NCodecPdu`) is encoded during
+this call, its buffer/payload fields are ignored. No other calls should be
+made on the Network Codec object until the message is committed. Trace
+functions are called (by the codec implementation) when the message is
+committed.
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object.
+
+msg (NCodecMessage*)
+: The message header to write to the Network Codec. Message type is defined
+  by the codec implementation.
+
+len (size_t)
+: The number of bytes to reserve for the message payload.
+
+Returns
+-------
+uint8_t*
+: Pointer to the reserved payload buffer (owned by the Network Codec). The
+  buffer is valid until the call to `ncodec_write_commit`.
+
+NULL
+: The payload could not be reserved. Inspect `errno` for more details.
+
+Error Conditions
+----------------
+
+Available by inspection of `errno`.
+
+ENOSTR
+: The object represented by `nc` does not represent a valid stream.
+
+ENOSR
+: No stream resource has been configured.
+
+ENOSYS
+: The Network Codec does not support reserve/commit operations.
+
+EINVAL
+: Bad `msg` argument.
+
+EBUSY
+: A reserved message has not yet been committed.
+*/
+inline uint8_t* ncodec_write_reserve(
+    NCODEC* nc, NCodecMessage* msg, size_t len)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) {
+        errno = ENOSTR;
+        return NULL;
+    }
+    if (_nc->codec.write_reserve) {
+        return _nc->codec.write_reserve(nc, msg, len);
+    } else {
+        errno = ENOSYS;
+        return NULL;
+    }
+}
+
+
+/**
+ncodec_write_commit
+===================
+
+Complete a message previously reserved with `ncodec_write_reserve`.
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object.
+
+len (size_t)
+: The number of payload bytes actually written to the reserved buffer, may be
+  less than (but not more than) the reserved length.
+
+Returns
+-------
++VE (int32_t)
+: The number of bytes written to the Network Codec. Will be identical to the
+  value provided in `len`.
+
+-ENOSTR (-60)
+: The object represented by `nc` does not represent a valid stream.
+
+-ENOSR (-63)
+: No stream resource has been configured.
+
+-ENOSYS (-38)
+: The Network Codec does not support reserve/commit operations.
+
+-EINVAL (-22)
+: No message was reserved, or `len` exceeds the reserved length.
+*/
+inline int32_t ncodec_write_commit(NCODEC* nc, size_t len)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->codec.write_commit) {
+        return _nc->codec.write_commit(nc, len);
+    } else {
+        return -ENOSYS;
+    }
+}
+
+
 /**
 ncodec_read
 ===========
@@ -250,6 +486,109 @@ inline int32_t ncodec_read(NCODEC* nc, NCodecMessage* msg)
 }
 
 
+/**
+ncodec_read_batch
+=================
+
+Read several messages from a Network Codec in a single call. The messages are
+returned in a batch container (e.g. `NCodecCanMessageBatch`) which holds
+caller provided arrays, one element per message.
+
+The codec owns the message buffer/memory referenced by the batch, the same
+conditions as for `ncodec_read` apply. Repeat calls to `ncodec_read_batch`
+until -ENOMSG is returned. Trace functions are called (by the codec
+implementation) for each message returned in the batch.
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object.
+
+batch (NCodecMessage*)
+: (in/out) The batch container. Caller owns the container and its arrays.
+  Batch type is defined by the codec implementation.
+
+Returns
+-------
++VE (int32_t)
+: The number of messages returned in the batch (`batch.count`).
+
+-ENOMSG (-42)
+: No message is available from the Network Codec.
+
+-ENOSTR (-60)
+: The object represented by `nc` does not represent a valid stream.
+
+-ENOSR (-63)
+: No stream resource has been configured.
+
+-ENOSYS (-38)
+: The Network Codec does not support batch operations.
+
+-EINVAL (-22)
+: Bad `batch` argument.
+*/
+inline int32_t ncodec_read_batch(NCODEC* nc, NCodecMessage* batch)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->codec.read_batch) {
+        return _nc->codec.read_batch(nc, batch);
+    } else {
+        return -ENOSYS;
+    }
+}
+
+
+/**
+ncodec_pdu_transport
+====================
+
+Decode the transport metadata of the PDU most recently returned by
+`ncodec_read`. Codecs configured to read PDUs without their transport
+metadata (e.g. `metadata=lazy`) only return the id, payload and sender
+properties of a PDU, consumers which require the transport metadata call this
+function after `ncodec_read`.
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object.
+
+pdu (NCodecPdu*)
+: (out) The PDU previously returned by `ncodec_read`, the `transport_type`
+  and `transport` fields are set by this call.
+
+Returns
+-------
+0
+: The transport metadata was decoded (`transport_type` is
+  `NCodecPduTransportTypeNone` if the PDU has no transport metadata).
+
+-ENOMSG (-42)
+: No PDU was returned by the previous call to `ncodec_read`.
+
+-ENOSTR (-60)
+: The object represented by `nc` does not represent a valid stream.
+
+-ENOSYS (-38)
+: The Network Codec does not support on demand PDU metadata.
+
+-EINVAL (-22)
+: Bad `pdu` argument.
+*/
+inline int32_t ncodec_pdu_transport(NCODEC* nc, NCodecPdu* pdu)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->codec.pdu_transport) {
+        return _nc->codec.pdu_transport(nc, (NCodecMessage*)pdu);
+    } else {
+        return -ENOSYS;
+    }
+}
+
+
 /**
 ncodec_flush
 ============
@@ -263,6 +602,9 @@ Returns
 -------
 0
 : The Network Codec internal buffers were flushed to the connected stream.
+  Codecs which flush asynchronously (e.g. `flush=async`) return 0 when the
+  flush is started, before the data is written to the connected stream, call
+  `ncodec_sync` to wait until the data is written.
 
 -ENOSTR
 : The object represented by `nc` does not represent a valid stream.
@@ -281,6 +623,41 @@ inline int32_t ncodec_flush(NCODEC* nc)
 }
 
 
+/**
+ncodec_sync
+===========
+
+Wait for any asynchronous flush operations of the Network Codec to complete.
+Codecs which flush asynchronously (e.g. `flush=async`) write to the connected
+stream from a worker thread, the stream should only be accessed directly
+(i.e. not via the Network Codec API) after calling this function.
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object.
+
+Returns
+-------
+0
+: All flush operations are complete (or the Network Codec flushes
+  synchronously).
+
+-ENOSTR
+: The object represented by `nc` does not represent a valid stream.
+*/
+inline int32_t ncodec_sync(NCODEC* nc)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->codec.sync) {
+        return _nc->codec.sync(nc);
+    } else {
+        return 0;
+    }
+}
+
+
 /**
 ncodec_truncate
 ===============
@@ -342,6 +719,7 @@ inline int64_t ncodec_seek(NCODEC* nc, size_t pos, int32_t op)
 {
     NCodecInstance* _nc = (NCodecInstance*)nc;
     if (_nc && _nc->stream && _nc->stream->seek) {
+        if (_nc->codec.sync) _nc->codec.sync(nc);
         return _nc->stream->seek((NCODEC*)nc, pos, op);
     } else {
         return -ENOSTR;
@@ -373,6 +751,7 @@ inline int64_t ncodec_tell(NCODEC* nc)
 {
     NCodecInstance* _nc = (NCodecInstance*)nc;
     if (_nc && _nc->stream && _nc->stream->tell) {
+        if (_nc->codec.sync) _nc->codec.sync(nc);
         return _nc->stream->tell((NCODEC*)nc);
     } else {
         return -ENOSTR;
@@ -380,6 +759,47 @@ inline int64_t ncodec_tell(NCODEC* nc)
 }
 
 
+/**
+ncodec_reset
+============
+
+Reset a Network Codec object to the state it had when created, as if it were
+closed and opened again with the same MIMEtype. Parameters set with calls to
+`ncodec_config` are restored to the values of the MIMEtype, internal buffers
+are discarded and the connected stream is truncated. The stream, trace and
+private references of the Network Codec object are retained.
+
+Codecs may retain the memory of internal buffers so that the Network Codec
+object can be reused without further allocations.
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object.
+
+Returns
+-------
+0
+: The Network Codec object was reset.
+
+-ENOSTR (-60)
+: The object represented by `nc` does not represent a valid stream.
+
+-ENOSYS (-38)
+: The Network Codec does not support reset operations.
+*/
+inline int32_t ncodec_reset(NCODEC* nc)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->codec.reset) {
+        return _nc->codec.reset(nc);
+    } else {
+        return -ENOSYS;
+    }
+}
+
+
 /**
 ncodec_close
 ============
@@ -396,3 +816,207 @@ inline void ncodec_close(NCODEC* nc)
         _nc->codec.close(nc);
     }
 }
+
+
+/* Allocator interface. */
+
+static void* _libc_realloc(void* context, void* ptr, size_t size)
+{
+    (void)context;
+    return realloc(ptr, size);
+}
+
+static void _libc_free(void* context, void* ptr)
+{
+    (void)context;
+    free(ptr);
+}
+
+static NCodecAllocatorVTable __libc_allocator = {
+    .realloc = _libc_realloc,
+    .free = _libc_free,
+};
+static NCodecAllocatorVTable* __allocator = &__libc_allocator;
+static uint64_t               __alloc_count;
+
+
+/**
+ncodec_set_allocator
+====================
+
+Set the allocator used by Network Codec objects created after this call
+(typically with `ncodec_open`). Codecs use the allocator for all memory of a
+Network Codec object, including its internal buffers, and continue to use
+that allocator until the object is closed. Therefore, an allocator can be
+set for an individual object by setting the allocator, opening the object,
+and then restoring the previous allocator.
+
+A Codec library may keep closed objects for reuse while their allocator is
+set, those objects are released (with their allocator) once the allocator is
+replaced and another object is opened or closed. A Codec may also allocate
+from a worker thread (e.g. `flush=async`), the allocator must then be thread
+safe.
+
+Parameters
+----------
+allocator (NCodecAllocatorVTable*)
+: The allocator. When NULL the default allocator (libc) is restored.
+
+Returns
+-------
+NCodecAllocatorVTable (pointer)
+: The previous allocator.
+*/
+NCodecAllocatorVTable* ncodec_set_allocator(NCodecAllocatorVTable* allocator)
+{
+    NCodecAllocatorVTable* previous = __allocator;
+    __allocator = allocator ? allocator : &__libc_allocator;
+    return previous;
+}
+
+
+/**
+ncodec_allocator
+================
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object (optional).
+
+Returns
+-------
+NCodecAllocatorVTable (pointer)
+: The allocator of the Network Codec object, or if `nc` is NULL (or the
+  object has no allocator) the allocator set by `ncodec_set_allocator`.
+*/
+NCodecAllocatorVTable* ncodec_allocator(NCODEC* nc)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc && _nc->allocator) return _nc->allocator;
+    return __allocator;
+}
+
+
+/**
+ncodec_alloc
+============
+
+Allocate zeroed memory with the allocator of a Network Codec object (see
+`ncodec_allocator`).
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object (optional).
+
+size (size_t)
+: Size of the allocation.
+
+Returns
+-------
+void* (pointer)
+: The allocated memory, release with `ncodec_free`. On failure NULL is
+  returned and `errno` is set.
+*/
+void* ncodec_alloc(NCODEC* nc, size_t size)
+{
+    void* ptr = ncodec_realloc(nc, NULL, size);
+    if (ptr) memset(ptr, 0, size);
+    return ptr;
+}
+
+
+/**
+ncodec_realloc
+==============
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object (optional).
+
+ptr (void*)
+: Memory previously allocated with the same allocator, or NULL.
+
+size (size_t)
+: New size of the allocation.
+
+Returns
+-------
+void* (pointer)
+: The reallocated memory. On failure NULL is returned (`ptr` remains
+  allocated) and `errno` is set.
+*/
+void* ncodec_realloc(NCODEC* nc, void* ptr, size_t size)
+{
+    NCodecAllocatorVTable* allocator = ncodec_allocator(nc);
+    __atomic_add_fetch(&__alloc_count, 1, __ATOMIC_RELAXED);
+    return allocator->realloc(allocator->context, ptr, size);
+}
+
+
+/**
+ncodec_free
+===========
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object (optional).
+
+ptr (void*)
+: Memory previously allocated with the same allocator, or NULL.
+*/
+void ncodec_free(NCODEC* nc, void* ptr)
+{
+    if (ptr == NULL) return;
+    NCodecAllocatorVTable* allocator = ncodec_allocator(nc);
+    allocator->free(allocator->context, ptr);
+}
+
+
+/**
+ncodec_strdup
+=============
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object (optional).
+
+s (const char*)
+: String to duplicate.
+
+Returns
+-------
+char* (pointer)
+: The duplicated string, release with `ncodec_free`. On failure NULL is
+  returned and `errno` is set.
+*/
+char* ncodec_strdup(NCODEC* nc, const char* s)
+{
+    if (s == NULL) return NULL;
+    size_t len = strlen(s) + 1;
+    char*  _s = ncodec_realloc(nc, NULL, len);
+    if (_s) memcpy(_s, s, len);
+    return _s;
+}
+
+
+/**
+ncodec_alloc_count
+==================
+
+Returns
+-------
+uint64_t
+: The number of allocations (including reallocations) made with
+  `ncodec_alloc`, `ncodec_realloc` and `ncodec_strdup` since the process
+  started, regardless of the allocator used. Tests can compare this counter
+  before and after an operation to assert that no allocations were made.
+*/
+uint64_t ncodec_alloc_count(void)
+{
+    return __atomic_load_n(&__alloc_count, __ATOMIC_RELAXED);
+}
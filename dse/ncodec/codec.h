@@ -121,6 +121,8 @@ typedef int64_t (*NCodecStreamSeek)(NCODEC* nc, size_t pos, int32_t op);
 typedef int64_t (*NCodecStreamTell)(NCODEC* nc);
 typedef int32_t (*NCodecStreamEof)(NCODEC* nc);
 typedef int32_t (*NCodecStreamClose)(NCODEC* nc);
+typedef uint8_t* (*NCodecStreamReserve)(NCODEC* nc, size_t len);
+typedef int32_t (*NCodecStreamCommit)(NCODEC* nc, size_t len);
 
 typedef struct NCodecStreamVTable {
     NCodecStreamRead  read;
@@ -129,6 +131,11 @@ typedef struct NCodecStreamVTable {
     NCodecStreamTell  tell;
     NCodecStreamEof   eof;
     NCodecStreamClose close;
+    /* Reserve/commit interface (optional). Reserve returns a pointer to `len`
+       bytes of stream memory at the current position (or NULL), commit then
+       advances the stream by `len` bytes, as if written by `write`. */
+    NCodecStreamReserve reserve;
+    NCodecStreamCommit  commit;
 } NCodecStreamVTable;
 
 
@@ -139,12 +146,15 @@ typedef struct NCodecConfigItem {
     const char* value;
 } NCodecConfigItem;
 
-typedef void NCodecMessage; /* Generic message container. */
+typedef void NCodecMessage;    /* Generic message container. */
+typedef void NCodecDescriptor; /* Compiled MIME type, defined by the codec. */
 
 
 typedef int32_t NCodecLoad(const char* filename, const char* hint);
 typedef NCODEC* NCodecOpen(const char* mime_type, NCodecStreamVTable* stream);
 typedef NCODEC* NCodecCreate(const char* mime_type);
+typedef const NCodecDescriptor* NCodecCompile(const char* mime_type);
+typedef NCODEC* NCodecCreateFromDescriptor(const NCodecDescriptor* descriptor);
 
 typedef int32_t (*NCodecConfig)(NCODEC* nc, NCodecConfigItem item);
 typedef NCodecConfigItem (*NCodecStat)(NCODEC* nc, int32_t* index);
@@ -153,6 +163,15 @@ typedef int32_t (*NCodecRead)(NCODEC* nc, NCodecMessage* msg);
 typedef int32_t (*NCodecFlush)(NCODEC* nc);
 typedef int32_t (*NCodecTruncate)(NCODEC* nc);
 typedef void (*NCodecClose)(NCODEC* nc);
+typedef int32_t (*NCodecReadBatch)(NCODEC* nc, NCodecMessage* batch);
+typedef int32_t (*NCodecWriteBatch)(
+    NCODEC* nc, NCodecMessage* msgs, size_t count);
+typedef uint8_t* (*NCodecWriteReserve)(
+    NCODEC* nc, NCodecMessage* msg, size_t len);
+typedef int32_t (*NCodecWriteCommit)(NCODEC* nc, size_t len);
+typedef int32_t (*NCodecSync)(NCODEC* nc);
+typedef int32_t (*NCodecPduTransport)(NCODEC* nc, NCodecMessage* pdu);
+typedef int32_t (*NCodecReset)(NCODEC* nc);
 
 typedef struct NCodecVTable {
     NCodecConfig   config;
@@ -162,6 +181,18 @@ typedef struct NCodecVTable {
     NCodecFlush    flush;
     NCodecTruncate truncate;
     NCodecClose    close;
+    /* Batch interface (optional). */
+    NCodecReadBatch  read_batch;
+    NCodecWriteBatch write_batch;
+    /* Reserve/commit interface (optional). */
+    NCodecWriteReserve write_reserve;
+    NCodecWriteCommit  write_commit;
+    /* Asynchronous flush barrier (optional). */
+    NCodecSync sync;
+    /* On demand PDU metadata interface (optional). */
+    NCodecPduTransport pdu_transport;
+    /* Reset interface (optional). */
+    NCodecReset reset;
 } NCodecVTable;
 
 typedef void (*NCodecTraceWrite)(NCODEC* nc, NCodecMessage* msg);
@@ -170,8 +201,20 @@ typedef void (*NCodecTraceRead)(NCODEC* nc, NCodecMessage* msg);
 typedef struct NCodecTraceVTable {
     NCodecTraceWrite write;
     NCodecTraceRead  read;
+    /* Private reference data from trace implementation (optional). */
+    void* private;
 } NCodecTraceVTable;
 
+typedef void* (*NCodecAllocatorRealloc)(void* context, void* ptr, size_t size);
+typedef void (*NCodecAllocatorFree)(void* context, void* ptr);
+
+typedef struct NCodecAllocatorVTable {
+    NCodecAllocatorRealloc realloc;
+    NCodecAllocatorFree    free;
+    /* Private reference data from allocator implementation (optional). */
+    void* context;
+} NCodecAllocatorVTable;
+
 
 typedef struct NCodecInstance {
     const char*         mime_type;
@@ -181,6 +224,8 @@ typedef struct NCodecInstance {
     NCodecTraceVTable   trace;
     /* Private reference data from API user (optional). */
     void* private;
+    /* Allocator of this object (optional), set by the Codec on create. */
+    NCodecAllocatorVTable* allocator;
 } NCodecInstance;
 
 
@@ -228,6 +273,27 @@ typedef struct NCodecCanMessage {
 } NCodecCanMessage;
 
 
+/* Structure-of-arrays container for batch read operations. Arrays are
+   provided by the caller and each must hold `capacity` elements. The
+   `frame_type` and `sender` arrays are optional (set to NULL to skip). */
+typedef struct NCodecCanMessageBatch {
+    size_t capacity;
+    size_t count; /* Number of messages returned. */
+
+    uint32_t*           frame_id;
+    uint8_t**           buffer;
+    size_t*             len;
+    NCodecCanFrameType* frame_type;
+
+    /* Sender metadata (optional). */
+    struct {
+        uint8_t* bus_id;
+        uint8_t* node_id;
+        uint8_t* interface_id;
+    } sender;
+} NCodecCanMessageBatch;
+
+
 /** NCODEC API - PDU/Stream
     =======================
 
@@ -378,6 +444,10 @@ typedef struct NCodecPdu {
 /* Implemented by Codec. */
 DLL_PUBLIC NCodecCreate ncodec_create;
 
+/* Implemented by Codec (optional). */
+DLL_PUBLIC NCodecCompile              ncodec_compile;
+DLL_PUBLIC NCodecCreateFromDescriptor ncodec_create_from_descriptor;
+
 /* Implemented by integrator. */
 DLL_PUBLIC int32_t ncodec_load(const char* filename, const char* hint);
 DLL_PUBLIC NCODEC* ncodec_open(
@@ -388,10 +458,30 @@ DLL_PUBLIC void             ncodec_config(NCODEC* nc, NCodecConfigItem item);
 DLL_PUBLIC NCodecConfigItem ncodec_stat(NCODEC* nc, int32_t* index);
 DLL_PUBLIC int32_t          ncodec_write(NCODEC* nc, NCodecMessage* msg);
 DLL_PUBLIC int32_t          ncodec_read(NCODEC* nc, NCodecMessage* msg);
+DLL_PUBLIC int32_t          ncodec_read_batch(NCODEC* nc, NCodecMessage* batch);
+DLL_PUBLIC int32_t          ncodec_pdu_transport(NCODEC* nc, NCodecPdu* pdu);
+DLL_PUBLIC int32_t          ncodec_write_batch(
+    NCODEC* nc, NCodecMessage* msgs, size_t count);
+DLL_PUBLIC uint8_t*         ncodec_write_reserve(
+    NCODEC* nc, NCodecMessage* msg, size_t len);
+DLL_PUBLIC int32_t          ncodec_write_commit(NCODEC* nc, size_t len);
 DLL_PUBLIC int32_t          ncodec_flush(NCODEC* nc);
+DLL_PUBLIC int32_t          ncodec_sync(NCODEC* nc);
 DLL_PUBLIC int32_t          ncodec_truncate(NCODEC* nc);
+DLL_PUBLIC int32_t          ncodec_reset(NCODEC* nc);
 DLL_PUBLIC void             ncodec_close(NCODEC* nc);
 DLL_PUBLIC int64_t          ncodec_seek(NCODEC* nc, size_t pos, int32_t op);
 DLL_PUBLIC int64_t          ncodec_tell(NCODEC* nc);
 
+/* Allocator interface, provided by codec.c (in this package). */
+DLL_PUBLIC NCodecAllocatorVTable* ncodec_set_allocator(
+    NCodecAllocatorVTable* allocator);
+DLL_PUBLIC NCodecAllocatorVTable* ncodec_allocator(NCODEC* nc);
+DLL_PUBLIC void*                  ncodec_alloc(NCODEC* nc, size_t size);
+DLL_PUBLIC void*                  ncodec_realloc(
+    NCODEC* nc, void* ptr, size_t size);
+DLL_PUBLIC void                   ncodec_free(NCODEC* nc, void* ptr);
+DLL_PUBLIC char*                  ncodec_strdup(NCODEC* nc, const char* s);
+DLL_PUBLIC uint64_t               ncodec_alloc_count(void);
+
 #endif  // DSE_NCODEC_CODEC_H_
@@ -2,56 +2,211 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <ctype.h>
 #include <dlfcn.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <dse/ncodec/codec.h>
 
 
-#define UNUSED(x) ((void)x)
+#define UNUSED(x)          ((void)x)
+#define REGISTRY_MIME_SIZE 64 /* Initial size, power of 2. */
 
 
-static void* __handle = NULL;
+/* Codec libraries, opened (dlopen) once on first use by ncodec_open(). */
+typedef struct CodecLibrary {
+    char*         path;
+    bool          opened; /* Open was attempted. */
+    void*         handle;
+    NCodecCreate* create_func; /* NULL, library not opened or has no
+                                  ncodec_create. */
+} CodecLibrary;
 
+/* Cache of resolved MIME types (base type -> ncodec_create). */
+typedef struct MimeEntry {
+    char*         key;
+    NCodecCreate* create_func;
+} MimeEntry;
 
-int32_t ncodec_load(const char* filename, const char* hint)
+static struct {
+    CodecLibrary* lib;
+    size_t        lib_count;
+    MimeEntry*    mime;
+    size_t        mime_size;
+    size_t        mime_count;
+} __registry;
+
+
+static uint32_t _hash(const char* s, size_t len)
 {
-    UNUSED(hint);
+    /* FNV-1a. */
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+static size_t _mime_base(const char* mime_type, const char** base)
+{
+    /* The base type is the part of the MIMEtype before any parameters. */
+    while (*mime_type && isspace(*mime_type))
+        mime_type++;
+    size_t len = strcspn(mime_type, ";");
+    while (len && isspace(mime_type[len - 1]))
+        len--;
+    *base = mime_type;
+    return len;
+}
+
+
+static MimeEntry* _mime_slot(
+    MimeEntry* table, size_t size, const char* key, size_t len)
+{
+    /* Open addressing, linear probe (table is never full). */
+    size_t i = _hash(key, len) & (size - 1);
+    while (table[i].key) {
+        if (strncmp(table[i].key, key, len) == 0 && table[i].key[len] == '\0') {
+            break;
+        }
+        i = (i + 1) & (size - 1);
+    }
+    return &table[i];
+}
+
+
+static int _mime_cache(const char* key, size_t len, NCodecCreate* create_func)
+{
+    /* Keep the load factor below 0.5. */
+    if ((__registry.mime_count + 1) * 2 > __registry.mime_size) {
+        size_t     size = __registry.mime_size ? __registry.mime_size * 2
+                                               : REGISTRY_MIME_SIZE;
+        MimeEntry* table = calloc(size, sizeof(MimeEntry));
+        if (table == NULL) return -ENOMEM;
+        for (size_t i = 0; i < __registry.mime_size; i++) {
+            MimeEntry* e = &__registry.mime[i];
+            if (e->key == NULL) continue;
+            *_mime_slot(table, size, e->key, strlen(e->key)) = *e;
+        }
+        free(__registry.mime);
+        __registry.mime = table;
+        __registry.mime_size = size;
+    }
+
+    MimeEntry* e = _mime_slot(__registry.mime, __registry.mime_size, key, len);
+    if (e->key == NULL) {
+        e->key = strndup(key, len);
+        if (e->key == NULL) return -ENOMEM;
+        __registry.mime_count++;
+    }
+    e->create_func = create_func;
+    return 0;
+}
+
 
-    __handle = dlopen(filename, RTLD_NOW | RTLD_LOCAL);
-    if (__handle == NULL) {
+static NCodecCreate* _library_create_func(CodecLibrary* lib)
+{
+    if (lib->opened) return lib->create_func;
+
+    lib->opened = true;
+    lib->handle = dlopen(lib->path, RTLD_NOW | RTLD_LOCAL);
+    if (lib->handle == NULL) {
         printf("Error opening library: %s\n", dlerror());
+        return NULL;
+    }
+    lib->create_func = dlsym(lib->handle, "ncodec_create");
+    return lib->create_func;
+}
+
+
+int32_t ncodec_load(const char* filename, const char* hint)
+{
+    if (filename == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Build the library path (hint is an optional directory). */
+    size_t len = strlen(filename) + 1;
+    if (hint) len += strlen(hint) + 1;
+    char* path = malloc(len);
+    if (path == NULL) return -1;
+    if (hint) {
+        snprintf(path, len, "%s/%s", hint, filename);
+    } else {
+        snprintf(path, len, "%s", filename);
+    }
+
+    /* Libraries are only registered once, and opened when first used. */
+    for (size_t i = 0; i < __registry.lib_count; i++) {
+        if (strcmp(__registry.lib[i].path, path) == 0) {
+            free(path);
+            return 0;
+        }
+    }
+    CodecLibrary* lib = realloc(
+        __registry.lib, (__registry.lib_count + 1) * sizeof(CodecLibrary));
+    if (lib == NULL) {
+        free(path);
         return -1;
     }
+    __registry.lib = lib;
+    __registry.lib[__registry.lib_count++] = (CodecLibrary){ .path = path };
     return 0;
 }
 
 
 NCODEC* ncodec_open(const char* mime_type, NCodecStreamVTable* stream)
 {
-    if (__handle == NULL) {
+    if (__registry.lib_count == 0) {
         errno = ELIBACC;
         return NULL;
     }
-    if (stream == NULL) {
+    if (stream == NULL || mime_type == NULL) {
         errno = EINVAL;
         return NULL;
     }
 
+    const char* base;
+    size_t      base_len = _mime_base(mime_type, &base);
+    NCODEC*     nc = NULL;
     errno = 0;
-    NCodecCreate* create_func = dlsym(__handle, "ncodec_create");
-    if (create_func) {
-        NCODEC* nc = create_func(mime_type);
+
+    /* Resolve via the MIMEtype cache. */
+    if (__registry.mime_size) {
+        MimeEntry* e = _mime_slot(
+            __registry.mime, __registry.mime_size, base, base_len);
+        if (e->key) {
+            nc = e->create_func(mime_type);
+            if (nc == NULL && errno == 0) errno = ENODATA;
+            goto open_complete;
+        }
+    }
+
+    /* Otherwise probe each library (opening it on first use), and cache the
+       resolved create function. */
+    bool found_create = false;
+    for (size_t i = 0; i < __registry.lib_count; i++) {
+        NCodecCreate* create_func = _library_create_func(&__registry.lib[i]);
+        if (create_func == NULL) continue;
+        found_create = true;
+        nc = create_func(mime_type);
         if (nc) {
-            NCodecInstance* _nc = (NCodecInstance*)nc;
-            _nc->stream = stream;
-            return nc;
-        } else {
-            if (errno == 0) errno = ENODATA;
+            _mime_cache(base, base_len, create_func);
+            break;
         }
-    } else {
-        if (errno == 0) errno = ENOENT;
     }
+    if (nc == NULL && errno == 0) errno = found_create ? ENODATA : ENOENT;
 
-    return NULL;
+open_complete:
+    if (nc) {
+        NCodecInstance* _nc = (NCodecInstance*)nc;
+        _nc->stream = stream;
+    }
+    return nc;
 }
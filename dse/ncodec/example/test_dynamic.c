@@ -0,0 +1,87 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <dse/ncodec/codec.h>
+
+
+#define MIMETYPE "application/x-codec-example"
+#define CHECK(x)                                                               \
+    do {                                                                       \
+        if (!(x)) {                                                            \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x);      \
+            return 1;                                                          \
+        }                                                                      \
+    } while (0)
+
+
+extern NCodecStreamVTable example_stream;
+
+
+/* Test the codec registry (and MIMEtype cache) of the dynamic loader. */
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        printf("Usage: %s <codec library>\n", argv[0]);
+        return 1;
+    }
+    const char* library = argv[1];
+
+    /* No library loaded. */
+    errno = 0;
+    CHECK(ncodec_open(MIMETYPE, &example_stream) == NULL);
+    CHECK(errno == ELIBACC);
+
+    /* Libraries are opened on first use, those which cannot be opened are
+       then skipped. */
+    CHECK(ncodec_load("missing.so", NULL) == 0);
+    CHECK(ncodec_load(library, "missing") == 0);
+    const char* not_library = "./test_dynamic_not_a_library.so";
+    FILE*       f = fopen(not_library, "w");
+    CHECK(f != NULL);
+    fputs("not a library", f);
+    fclose(f);
+    CHECK(ncodec_load(not_library, NULL) == 0);
+    errno = 0;
+    CHECK(ncodec_open(MIMETYPE, &example_stream) == NULL);
+    CHECK(errno == ENOENT);
+    remove(not_library);
+
+    /* Load the library, a repeated load is ignored. */
+    CHECK(ncodec_load(library, NULL) == 0);
+    CHECK(ncodec_load(library, NULL) == 0);
+
+    /* Open, first via the registry, then via the MIMEtype cache (same base
+       type, with or without parameters). */
+    for (int i = 0; i < 3; i++) {
+        NCODEC* nc = ncodec_open(MIMETYPE "; name=foo", &example_stream);
+        CHECK(nc != NULL);
+        CHECK(((NCodecInstance*)nc)->stream == &example_stream);
+        ncodec_close(nc);
+        nc = ncodec_open(MIMETYPE, &example_stream);
+        CHECK(nc != NULL);
+        ncodec_close(nc);
+    }
+
+    /* Unsupported MIMEtype (a miss), repeated. */
+    for (int i = 0; i < 2; i++) {
+        errno = 0;
+        CHECK(ncodec_open("application/x-codec-unknown", &example_stream) ==
+              NULL);
+        CHECK(errno == ENODATA);
+    }
+
+    /* Bad arguments. */
+    errno = 0;
+    CHECK(ncodec_open(MIMETYPE, NULL) == NULL);
+    CHECK(errno == EINVAL);
+    errno = 0;
+    CHECK(ncodec_load(NULL, NULL) == -1);
+    CHECK(errno == EINVAL);
+
+    printf("OK\n");
+    return 0;
+}
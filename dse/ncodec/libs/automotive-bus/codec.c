@@ -2,29 +2,89 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
 #include <dse/ncodec/codec.h>
 #include <automotive-bus/codec.h>
 
 
-#define UNUSED(x) ((void)x)
-#define CODEC     "application/x-automotive-bus"
+#define UNUSED(x)          ((void)x)
+#define CODEC              "application/x-automotive-bus"
+#define DESCRIPTOR_BUCKETS 64
+#define POOL_SIZE          64
+#define INFLATE_BLOCK_LEN  4096
+
+
+/* Parameters of an instance are owned by its descriptor (if any) until they
+   are reconfigured. */
+#define FREE_PARAM(nc, field)                                                  \
+    do {                                                                       \
+        if ((nc)->field == NULL) break;                                        \
+        if ((nc)->descriptor &&                                                \
+            (nc)->field == (nc)->descriptor->instance.field)                   \
+            break;                                                             \
+        ncodec_free((NCODEC*)(nc), (nc)->field);                               \
+    } while (0)
 
 
 /* interface=stream; type=frame; bus=can; schema=fbs */
 extern int32_t can_write(NCODEC* nc, NCodecMessage* msg);
 extern int32_t can_read(NCODEC* nc, NCodecMessage* msg);
+extern int32_t can_read_batch(NCODEC* nc, NCodecMessage* batch);
+extern int32_t can_write_batch(NCODEC* nc, NCodecMessage* msgs, size_t count);
+extern uint8_t* can_write_reserve(NCODEC* nc, NCodecMessage* msg, size_t len);
+extern int32_t can_write_commit(NCODEC* nc, size_t len);
 extern int32_t can_flush(NCODEC* nc);
 extern int32_t can_truncate(NCODEC* nc);
 
+/* interface=stream; type=frame; bus=can; schema=raw */
+extern int32_t can_raw_write(NCODEC* nc, NCodecMessage* msg);
+extern int32_t can_raw_read(NCODEC* nc, NCodecMessage* msg);
+extern int32_t can_raw_read_batch(NCODEC* nc, NCodecMessage* batch);
+extern int32_t can_raw_write_batch(
+    NCODEC* nc, NCodecMessage* msgs, size_t count);
+extern uint8_t* can_raw_write_reserve(
+    NCODEC* nc, NCodecMessage* msg, size_t len);
+extern int32_t can_raw_write_commit(NCODEC* nc, size_t len);
+extern int32_t can_raw_flush(NCODEC* nc);
+extern int32_t can_raw_truncate(NCODEC* nc);
+
 /* interface=stream; type=pdu; schema=fbs */
 extern int32_t pdu_write(NCODEC* nc, NCodecMessage* msg);
 extern int32_t pdu_read(NCODEC* nc, NCodecMessage* msg);
+extern int32_t pdu_write_batch(NCODEC* nc, NCodecMessage* msgs, size_t count);
+extern uint8_t* pdu_write_reserve(NCODEC* nc, NCodecMessage* msg, size_t len);
+extern int32_t pdu_write_commit(NCODEC* nc, size_t len);
 extern int32_t pdu_flush(NCODEC* nc);
 extern int32_t pdu_truncate(NCODEC* nc);
+extern int32_t pdu_transport(NCODEC* nc, NCodecMessage* pdu);
+
+/* interface=stream; type=pdu; schema=columnar */
+extern int32_t pdu_columnar_write(NCODEC* nc, NCodecMessage* msg);
+extern int32_t pdu_columnar_read(NCODEC* nc, NCodecMessage* msg);
+extern int32_t pdu_columnar_write_batch(
+    NCODEC* nc, NCodecMessage* msgs, size_t count);
+extern uint8_t* pdu_columnar_write_reserve(
+    NCODEC* nc, NCodecMessage* msg, size_t len);
+extern int32_t pdu_columnar_write_commit(NCODEC* nc, size_t len);
+extern int32_t pdu_columnar_flush(NCODEC* nc);
+extern int32_t pdu_columnar_truncate(NCODEC* nc);
+
+/* compression=lz4 (compress.c) */
+extern size_t  codec_lz4_bound(size_t len);
+extern size_t  codec_lz4_compress(
+    const uint8_t* src, size_t len, uint8_t* dst, size_t dst_len);
+extern int32_t codec_lz4_decompress(
+    const uint8_t* src, size_t len, uint8_t* dst, size_t dst_len);
+
+int32_t codec_reset(NCODEC* nc);
 
 
 char* trim(char* s)
@@ -41,20 +101,622 @@ char* trim(char* s)
 }
 
 
+static void _inflate_free(ABCodecInstance* nc)
+{
+    ABCodecInflateBlock* b = nc->compress.inflate;
+    while (b) {
+        ABCodecInflateBlock* next = b->next;
+        ncodec_free((NCODEC*)nc, b);
+        b = next;
+    }
+    nc->compress.inflate = NULL;
+}
+
+
+static void release_codec(ABCodecInstance* _nc)
+{
+    if (_nc->async.running) {
+        /* Stop the flush worker, any pending flush is completed first. */
+        pthread_mutex_lock(&_nc->async.mutex);
+        _nc->async.exit = true;
+        pthread_cond_broadcast(&_nc->async.cond);
+        pthread_mutex_unlock(&_nc->async.mutex);
+        pthread_join(_nc->async.thread, NULL);
+        pthread_cond_destroy(&_nc->async.cond);
+        pthread_mutex_destroy(&_nc->async.mutex);
+        _nc->async.running = false;
+    }
+    FREE_PARAM(_nc, interface);
+    FREE_PARAM(_nc, type);
+    FREE_PARAM(_nc, bus);
+    FREE_PARAM(_nc, schema);
+    FREE_PARAM(_nc, bus_id_str);
+    FREE_PARAM(_nc, node_id_str);
+    FREE_PARAM(_nc, interface_id_str);
+    FREE_PARAM(_nc, swc_id_str);
+    FREE_PARAM(_nc, ecu_id_str);
+    FREE_PARAM(_nc, flush_str);
+    FREE_PARAM(_nc, subscribe_str);
+    FREE_PARAM(_nc, metadata_str);
+    FREE_PARAM(_nc, coalesce_str);
+    FREE_PARAM(_nc, compression_str);
+    FREE_PARAM(_nc, stats_param_str);
+    FREE_PARAM(_nc, subscription.keys);
+    for (size_t i = 0; i < _nc->coalesce.capacity; i++) {
+        ncodec_free((NCODEC*)_nc, _nc->coalesce.slots[i].payload);
+    }
+    ncodec_free((NCODEC*)_nc, _nc->coalesce.slots);
+    ncodec_free((NCODEC*)_nc, _nc->coalesce.index);
+    _nc->coalesce = (ABCodecCoalesce){};
+    ncodec_free((NCODEC*)_nc, _nc->compress.buffer);
+    _inflate_free(_nc);
+    memset(&_nc->compress, 0, sizeof(_nc->compress));
+    ncodec_free((NCODEC*)_nc, _nc->raw.buffer);
+    memset(&_nc->raw, 0, sizeof(_nc->raw));
+    ncodec_free((NCODEC*)_nc, _nc->columns.id);
+    ncodec_free((NCODEC*)_nc, _nc->columns.swc_id);
+    ncodec_free((NCODEC*)_nc, _nc->columns.ecu_id);
+    ncodec_free((NCODEC*)_nc, _nc->columns.offset);
+    ncodec_free((NCODEC*)_nc, _nc->columns.payload);
+    ncodec_free((NCODEC*)_nc, _nc->columns.buffer);
+    _nc->columns = (ABCodecColumns){};
+}
+
+
 void free_codec(ABCodecInstance* _nc)
 {
     if (_nc == NULL) return;
 
-    if (_nc->interface) free(_nc->interface);
-    if (_nc->type) free(_nc->type);
-    if (_nc->bus) free(_nc->bus);
-    if (_nc->schema) free(_nc->schema);
-    if (_nc->bus_id_str) free(_nc->bus_id_str);
-    if (_nc->node_id_str) free(_nc->node_id_str);
-    if (_nc->interface_id_str) free(_nc->interface_id_str);
-    if (_nc->swc_id_str) free(_nc->swc_id_str);
-    if (_nc->ecu_id_str) free(_nc->ecu_id_str);
-    if (_nc->fbs_builder_initalized) flatcc_builder_clear(&_nc->fbs_builder);
+    release_codec(_nc);
+    if (_nc->fbs_builder_initalized) {
+        flatcc_builder_clear(&_nc->fbs_builders[0]);
+        flatcc_builder_clear(&_nc->fbs_builders[1]);
+    }
+}
+
+
+static void* _libc_realloc(void* context, void* ptr, size_t size)
+{
+    UNUSED(context);
+    return realloc(ptr, size);
+}
+
+
+static void _libc_free(void* context, void* ptr)
+{
+    UNUSED(context);
+    free(ptr);
+}
+
+
+/* Allocator of descriptors (and their template instance). */
+static NCodecAllocatorVTable descriptor_allocator = {
+    .realloc = _libc_realloc,
+    .free = _libc_free,
+};
+
+
+static void _descriptor_free(ABCodecDescriptor* _d)
+{
+    if (_d == NULL) return;
+
+    free_codec(&_d->instance);
+    free(_d->mime_type);
+    free(_d);
+}
+
+
+static uint64_t codec_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+
+/* Clock of the timing counters (write_ns etc.), which are only measured with
+   stats=timing (otherwise the clock is 0). */
+uint64_t codec_clock_ns(ABCodecInstance* nc)
+{
+    return nc->stats_timing ? codec_now_ns() : 0;
+}
+
+
+static int32_t _buffer_extend(
+    ABCodecInstance* nc, uint8_t** buffer, size_t* buffer_len, size_t len)
+{
+    if (len <= *buffer_len) return 0;
+    uint8_t* _buffer = ncodec_realloc((NCODEC*)nc, *buffer, len);
+    if (_buffer == NULL) return -ENOMEM;
+    *buffer = _buffer;
+    *buffer_len = len;
+    return 0;
+}
+
+
+static inline void _write_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+
+static inline uint32_t _read_u32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+/* Write to the stream, returns the length written or (as for the stream
+   write method) a negative errno cast to size_t (e.g. -EMSGSIZE). */
+static size_t _stream_write(ABCodecInstance* nc, uint8_t* data, size_t len)
+{
+    NCodecStreamVTable* stream = nc->c.stream;
+    if (stream->reserve && stream->commit) {
+        uint8_t* buffer = stream->reserve((NCODEC*)nc, len);
+        if (buffer) {
+            memcpy(buffer, data, len);
+            int32_t rc = stream->commit((NCODEC*)nc, len);
+            return rc < 0 ? (size_t)rc : len;
+        }
+    }
+    return stream->write((NCODEC*)nc, data, len);
+}
+
+
+/* Extend the codec compression buffer to hold `offset` bytes followed by a
+   compressed message of a `length` buffer. */
+static uint8_t* _compress_buffer(
+    ABCodecInstance* nc, size_t offset, size_t length)
+{
+    size_t msg_len = 4 + AB_CODEC_LZ4_HEADER_LEN + codec_lz4_bound(length);
+    if (_buffer_extend(nc, &nc->compress.buffer, &nc->compress.buffer_len,
+            offset + msg_len)) {
+        return NULL;
+    }
+    return nc->compress.buffer;
+}
+
+
+/* Compress the finalized buffer `src` (compression=lz4) into `msg` and write
+   it to the stream as a size prefixed message with a distinct file
+   identifier (readers which do not support compression skip the message).
+   The buffer is written uncompressed if compression would not reduce its
+   length. The capacity of `msg` is the compressed message bound. */
+static size_t _flush_compressed(
+    ABCodecInstance* nc, uint8_t* src, size_t length, uint8_t* msg)
+{
+    size_t block_len = codec_lz4_compress(src, length,
+        msg + 4 + AB_CODEC_LZ4_HEADER_LEN, codec_lz4_bound(length));
+    size_t msg_len = AB_CODEC_LZ4_HEADER_LEN + block_len;
+    if (block_len == 0 || (msg_len + 4) >= length) {
+        return _stream_write(nc, src, length);
+    }
+    _write_u32(msg, msg_len);
+    _write_u32(msg + 4, length);
+    memcpy(msg + 8, AB_CODEC_LZ4_IDENTIFIER, 4);
+    return _stream_write(nc, msg, msg_len + 4);
+}
+
+
+/* Allocate `len` bytes from the inflate blocks, blocks are never moved. */
+static uint8_t* _inflate_alloc(ABCodecInstance* nc, size_t len)
+{
+    ABCodecInflateBlock* b = nc->compress.inflate;
+    len = (len + 7) & ~(size_t)7;
+    if (b == NULL || (b->len - b->used) < len) {
+        size_t block_len = b ? b->len * 2 : INFLATE_BLOCK_LEN;
+        while (block_len < len) {
+            block_len *= 2;
+        }
+        ABCodecInflateBlock* _b = ncodec_realloc(
+            (NCODEC*)nc, NULL, sizeof(ABCodecInflateBlock) + block_len);
+        if (_b == NULL) return NULL;
+        _b->next = b;
+        _b->len = block_len;
+        _b->used = 0;
+        nc->compress.inflate = _b;
+        b = _b;
+    }
+    uint8_t* p = b->data + b->used;
+    b->used += len;
+    return p;
+}
+
+
+/* Release the decompressed messages, only the current (largest) block is
+   retained. Called when the stream is truncated or read from its start. */
+void codec_inflate_reset(ABCodecInstance* nc)
+{
+    ABCodecInflateBlock* b = nc->compress.inflate;
+    if (b == NULL) return;
+    ABCodecInflateBlock* next = b->next;
+    b->next = NULL;
+    b->used = 0;
+    while (next) {
+        ABCodecInflateBlock* _next = next->next;
+        ncodec_free((NCODEC*)nc, next);
+        next = _next;
+    }
+}
+
+
+/* Decompress a message (compression=lz4) into the inflate blocks of the
+   codec, and update msg_ptr/msg_len to reference the decompressed message.
+   Other messages are not modified. Decompressed messages remain valid until
+   the stream is truncated or read again from its start (see
+   codec_inflate_reset()). */
+int32_t codec_decompress(
+    ABCodecInstance* nc, uint8_t** msg_ptr, size_t* msg_len)
+{
+    uint8_t* msg = *msg_ptr;
+    if (*msg_len < AB_CODEC_LZ4_HEADER_LEN) return 0;
+    if (!flatbuffers_has_identifier(msg, AB_CODEC_LZ4_IDENTIFIER)) return 0;
+
+    /* An LZ4 block expands at most 255 times, longer lengths are rejected
+       before allocating. */
+    size_t length = _read_u32(msg);
+    size_t block_len = *msg_len - AB_CODEC_LZ4_HEADER_LEN;
+    if (length < 4 || length > INT32_MAX) return -EPROTO;
+    if (length > block_len * 255) return -EPROTO;
+    uint8_t* inflate = _inflate_alloc(nc, length);
+    if (inflate == NULL) return -ENOMEM;
+    int32_t rc = codec_lz4_decompress(
+        msg + AB_CODEC_LZ4_HEADER_LEN, block_len, inflate, length);
+    if (rc != (int32_t)length) return -EPROTO;
+
+    /* The decompressed stream is also size prefixed. */
+    size_t inflate_len = _read_u32(inflate);
+    if (inflate_len == 0 || inflate_len > length - 4) return -EPROTO;
+    *msg_ptr = inflate + 4;
+    *msg_len = inflate_len;
+    return 0;
+}
+
+
+static size_t _flush_builder(ABCodecInstance* nc, flatcc_builder_t* B)
+{
+    NCodecStreamVTable* stream = nc->c.stream;
+    size_t              length = flatcc_builder_get_buffer_size(B);
+    if (length == 0) return 0;
+
+    /* Compress, via the codec buffer (finalized buffer then message). */
+    if (nc->compression_lz4) {
+        uint8_t* src = _compress_buffer(nc, length, length);
+        if (src && flatcc_builder_copy_buffer(B, src, length)) {
+            return _flush_compressed(nc, src, length, src + length);
+        }
+    }
+
+    /* Copy the finalized buffer directly into stream memory. */
+    if (stream->reserve && stream->commit) {
+        uint8_t* buffer = stream->reserve((NCODEC*)nc, length);
+        if (buffer && flatcc_builder_copy_buffer(B, buffer, length)) {
+            int32_t rc = stream->commit((NCODEC*)nc, length);
+            return rc < 0 ? (size_t)rc : length;
+        }
+    }
+
+    /* Otherwise, via an intermediate buffer. */
+    uint8_t* buffer = ncodec_alloc((NCODEC*)nc, length);
+    if (buffer == NULL) return (size_t)-ENOMEM;
+    if (flatcc_builder_copy_buffer(B, buffer, length)) {
+        length = stream->write((NCODEC*)nc, buffer, length);
+    } else {
+        length = 0;
+    }
+    ncodec_free((NCODEC*)nc, buffer);
+    return length;
+}
+
+
+size_t codec_flush_builder(ABCodecInstance* nc, flatcc_builder_t* B)
+{
+    size_t length = flatcc_builder_get_buffer_size(B);
+    if (length > nc->stats.builder_hwm) nc->stats.builder_hwm = length;
+    return _flush_builder(nc, B);
+}
+
+
+/* Write a finalized (size prefixed) buffer of the codec to the stream. */
+size_t codec_flush_buffer(ABCodecInstance* nc, uint8_t* buffer, size_t length)
+{
+    if (length == 0) return 0;
+    if (length > nc->stats.builder_hwm) nc->stats.builder_hwm = length;
+
+    if (nc->compression_lz4) {
+        uint8_t* msg = _compress_buffer(nc, 0, length);
+        if (msg) return _flush_compressed(nc, buffer, length, msg);
+    }
+    return _stream_write(nc, buffer, length);
+}
+
+
+/* Trace each message of a write batch (elements of `size` bytes). */
+void codec_trace_write_batch(
+    ABCodecInstance* nc, NCodecMessage* msgs, size_t size, size_t count)
+{
+    NCodecTraceWrite write = nc->c.trace.write;
+    if (write == NULL) return;
+    for (size_t i = 0; i < count; i++) {
+        write((NCODEC*)nc, (uint8_t*)msgs + i * size);
+    }
+}
+
+
+/* Trace each message of a (CAN) read batch. */
+void codec_trace_read_batch(ABCodecInstance* nc, NCodecCanMessageBatch* b)
+{
+    NCodecTraceRead read = nc->c.trace.read;
+    if (read == NULL) return;
+    for (size_t i = 0; i < b->count; i++) {
+        NCodecCanMessage msg = {
+            .frame_id = b->frame_id[i],
+            .buffer = b->buffer[i],
+            .len = b->len[i],
+            .frame_type = b->frame_type ? b->frame_type[i] : CAN_BASE_FRAME,
+        };
+        if (b->sender.bus_id) msg.sender.bus_id = b->sender.bus_id[i];
+        if (b->sender.node_id) msg.sender.node_id = b->sender.node_id[i];
+        if (b->sender.interface_id) {
+            msg.sender.interface_id = b->sender.interface_id[i];
+        }
+        read((NCODEC*)nc, &msg);
+    }
+}
+
+
+static void* _flush_worker(void* arg)
+{
+    ABCodecInstance* nc = arg;
+
+    pthread_mutex_lock(&nc->async.mutex);
+    while (1) {
+        while (nc->async.pending == NULL && nc->async.exit == false) {
+            pthread_cond_wait(&nc->async.cond, &nc->async.mutex);
+        }
+        if (nc->async.pending == NULL) break;
+
+        /* Only this thread touches the pending builder (and the stream)
+           until pending is cleared. Allocations (builder and compression)
+           are made with the allocator of the codec, which must therefore be
+           thread safe. Counters are updated with the mutex held. */
+        flatcc_builder_t* B = nc->async.pending;
+        pthread_mutex_unlock(&nc->async.mutex);
+        nc->async.end_stream(B);
+        size_t length = flatcc_builder_get_buffer_size(B);
+        int32_t rc = (int32_t)_flush_builder(nc, B);
+        flatcc_builder_reset(B);
+        pthread_mutex_lock(&nc->async.mutex);
+
+        if (length > nc->stats.builder_hwm) nc->stats.builder_hwm = length;
+        if (rc < 0) nc->async.rc = rc;
+        nc->async.pending = NULL;
+        pthread_cond_broadcast(&nc->async.cond);
+    }
+    pthread_mutex_unlock(&nc->async.mutex);
+
+    return NULL;
+}
+
+
+/* Wait for the flush worker (flush=async) to complete a pending flush. */
+void codec_sync_wait(ABCodecInstance* nc)
+{
+    if (nc->async.running == false) return;
+
+    pthread_mutex_lock(&nc->async.mutex);
+    while (nc->async.pending) {
+        pthread_cond_wait(&nc->async.cond, &nc->async.mutex);
+    }
+    pthread_mutex_unlock(&nc->async.mutex);
+}
+
+
+/* Wait for the flush worker, then return (and clear) any error of a flush
+   made by the worker (e.g. -EMSGSIZE when the stream refused the write). */
+int32_t codec_sync(NCODEC* nc)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->async.running == false) return 0;
+
+    codec_sync_wait(_nc);
+    pthread_mutex_lock(&_nc->async.mutex);
+    int32_t rc = _nc->async.rc;
+    _nc->async.rc = 0;
+    pthread_mutex_unlock(&_nc->async.mutex);
+    return rc;
+}
+
+
+int32_t codec_flush_async(
+    ABCodecInstance* nc, void (*end_stream)(flatcc_builder_t* B))
+{
+    if (nc->async.running == false) {
+        /* Start the worker on first use. */
+        pthread_mutex_init(&nc->async.mutex, NULL);
+        pthread_cond_init(&nc->async.cond, NULL);
+        nc->async.pending = NULL;
+        nc->async.exit = false;
+        nc->async.rc = 0;
+        int rc = pthread_create(&nc->async.thread, NULL, _flush_worker, nc);
+        if (rc) {
+            pthread_cond_destroy(&nc->async.cond);
+            pthread_mutex_destroy(&nc->async.mutex);
+            return -rc;
+        }
+        nc->async.running = true;
+    }
+
+    /* Wait for the previous flush, then hand over the active builder and
+       continue on the other builder. */
+    pthread_mutex_lock(&nc->async.mutex);
+    while (nc->async.pending) {
+        pthread_cond_wait(&nc->async.cond, &nc->async.mutex);
+    }
+    nc->async.pending = nc->fbs_builder;
+    nc->async.end_stream = end_stream;
+    pthread_cond_broadcast(&nc->async.cond);
+    pthread_mutex_unlock(&nc->async.mutex);
+
+    if (nc->fbs_builder == &nc->fbs_builders[0]) {
+        nc->fbs_builder = &nc->fbs_builders[1];
+    } else {
+        nc->fbs_builder = &nc->fbs_builders[0];
+    }
+    return 0;
+}
+
+
+#define SUBSCRIBE_KEY_ID(id) ((1ULL << 32) | (uint32_t)(id))
+#define SUBSCRIBE_KEY_NODE(ecu_id, swc_id)                                     \
+    (((uint64_t)(uint32_t)(ecu_id) << 32) | (uint32_t)(swc_id))
+
+
+static inline size_t _subscribe_hash(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key;
+}
+
+
+static inline bool _subscribe_contains(
+    const uint64_t* keys, size_t mask, uint64_t key)
+{
+    for (size_t i = _subscribe_hash(key) & mask;; i = (i + 1) & mask) {
+        if (keys[i] == key) return true;
+        if (keys[i] == 0) return false;
+    }
+}
+
+
+static void _subscribe_insert(
+    ABCodecSubscription* s, uint64_t* keys, uint64_t key)
+{
+    size_t i = _subscribe_hash(key) & s->mask;
+    while (keys[i] && keys[i] != key) {
+        i = (i + 1) & s->mask;
+    }
+    if (keys[i] == 0) {
+        keys[i] = key;
+        s->count++;
+    }
+}
+
+
+static int32_t _subscribe_parse(
+    NCODEC* nc, ABCodecSubscription* s, const char* value)
+{
+    /* Size the set for a load factor of (at most) 0.5. */
+    size_t entries = 1;
+    for (const char* p = value; *p; p++) {
+        if (*p == ',') entries++;
+    }
+    size_t capacity = 8;
+    while (capacity < entries * 2) {
+        capacity <<= 1;
+    }
+    *s = (ABCodecSubscription){
+        .keys = ncodec_alloc(nc, 2 * capacity * sizeof(uint64_t)),
+        .mask = capacity - 1,
+    };
+    if (s->keys == NULL) return -ENOMEM;
+    uint64_t* nodes = s->keys + capacity;
+
+    /* Entries: "id" or "ecu_id:swc_id", separated by ",". */
+    int32_t rc = 0;
+    char*   _buf = ncodec_strdup(nc, value);
+    char*   _pos = NULL;
+    char*   _item;
+    if (_buf == NULL) {
+        ncodec_free(nc, s->keys);
+        *s = (ABCodecSubscription){};
+        return -ENOMEM;
+    }
+    for (_item = strtok_r(_buf, ",", &_pos); _item;
+         _item = strtok_r(NULL, ",", &_pos)) {
+        char* item = trim(_item);
+        if (*item == '\0') continue;
+
+        char*         end = NULL;
+        unsigned long a = strtoul(item, &end, 10);
+        if (end == item) {
+            rc = -EINVAL;
+            break;
+        }
+        if (*end == ':') {
+            char*         swc = end + 1;
+            unsigned long b = strtoul(swc, &end, 10);
+            if (end == swc || *end || a > UINT32_MAX || b > UINT32_MAX) {
+                rc = -EINVAL;
+                break;
+            }
+            uint64_t key = SUBSCRIBE_KEY_NODE(a, b);
+            if (key) {
+                _subscribe_insert(s, nodes, key);
+            } else if (s->node_zero == false) {
+                s->node_zero = true;
+                s->count++;
+            }
+            s->has_node = true;
+        } else if (*end == '\0' && a <= UINT32_MAX) {
+            _subscribe_insert(s, s->keys, SUBSCRIBE_KEY_ID(a));
+            s->has_id = true;
+        } else {
+            rc = -EINVAL;
+            break;
+        }
+    }
+    ncodec_free(nc, _buf);
+
+    if (rc) {
+        ncodec_free(nc, s->keys);
+        *s = (ABCodecSubscription){};
+    }
+    return rc;
+}
+
+
+bool codec_subscribed(
+    ABCodecInstance* nc, uint32_t id, uint32_t ecu_id, uint32_t swc_id)
+{
+    ABCodecSubscription* s = &nc->subscription;
+    if (s->count == 0) return true;
+
+    if (s->has_id &&
+        _subscribe_contains(s->keys, s->mask, SUBSCRIBE_KEY_ID(id))) {
+        return true;
+    }
+    uint64_t key = SUBSCRIBE_KEY_NODE(ecu_id, swc_id);
+    if (key == 0) return s->node_zero;
+    if (s->has_node &&
+        _subscribe_contains(s->keys + s->mask + 1, s->mask, key)) {
+        return true;
+    }
+    return false;
+}
+
+
+/* The raw and columnar schemas are encoded without a builder, and are
+   therefore always flushed synchronously. */
+static bool _flush_async_supported(ABCodecInstance* nc)
+{
+    if (nc->schema == NULL) return true;
+    return strcmp(nc->schema, "raw") && strcmp(nc->schema, "columnar");
+}
+
+
+/* Frames are coalesced in the builder of the FBS schema, the raw schema
+   encodes each write directly to its record. */
+static bool _coalesce_supported(ABCodecInstance* nc)
+{
+    if (nc->schema == NULL) return true;
+    return strcmp(nc->schema, "raw");
 }
 
 
@@ -65,62 +727,149 @@ int32_t codec_config(NCODEC* nc, NCodecConfigItem item)
 
     /* Selectors. */
     if (strcmp(item.name, "interface") == 0) {
-        if (_nc->interface) free(_nc->interface);
-        _nc->interface = strdup(item.value);
+        FREE_PARAM(_nc, interface);
+        _nc->interface = ncodec_strdup(nc, item.value);
         return 0;
     }
     if (strcmp(item.name, "type") == 0) {
-        if (_nc->type) free(_nc->type);
-        _nc->type = strdup(item.value);
+        FREE_PARAM(_nc, type);
+        _nc->type = ncodec_strdup(nc, item.value);
         return 0;
     }
     if (strcmp(item.name, "bus") == 0) {
-        if (_nc->bus) free(_nc->bus);
-        _nc->bus = strdup(item.value);
+        FREE_PARAM(_nc, bus);
+        _nc->bus = ncodec_strdup(nc, item.value);
         return 0;
     }
     if (strcmp(item.name, "schema") == 0) {
-        if (_nc->schema) free(_nc->schema);
-        _nc->schema = strdup(item.value);
+        FREE_PARAM(_nc, schema);
+        _nc->schema = ncodec_strdup(nc, item.value);
         return 0;
     }
 
     /* Parameters. */
     if (strcmp(item.name, "bus_id") == 0) {
-        if (_nc->bus_id_str) free(_nc->bus_id_str);
-        _nc->bus_id_str = strdup(item.value);
+        FREE_PARAM(_nc, bus_id_str);
+        _nc->bus_id_str = ncodec_strdup(nc, item.value);
         _nc->bus_id = strtoul(item.value, NULL, 10);
         return 0;
     }
     if (strcmp(item.name, "node_id") == 0) {
-        if (_nc->node_id_str) free(_nc->node_id_str);
-        _nc->node_id_str = strdup(item.value);
+        FREE_PARAM(_nc, node_id_str);
+        _nc->node_id_str = ncodec_strdup(nc, item.value);
         _nc->node_id = strtoul(item.value, NULL, 10);
         return 0;
     }
     if (strcmp(item.name, "interface_id") == 0) {
-        if (_nc->interface_id_str) free(_nc->interface_id_str);
-        _nc->interface_id_str = strdup(item.value);
+        FREE_PARAM(_nc, interface_id_str);
+        _nc->interface_id_str = ncodec_strdup(nc, item.value);
         _nc->interface_id = strtoul(item.value, NULL, 10);
         return 0;
     }
     if (strcmp(item.name, "swc_id") == 0) {
-        if (_nc->swc_id_str) free(_nc->swc_id_str);
-        _nc->swc_id_str = strdup(item.value);
+        FREE_PARAM(_nc, swc_id_str);
+        _nc->swc_id_str = ncodec_strdup(nc, item.value);
         _nc->swc_id = strtoul(item.value, NULL, 10);
         return 0;
     }
     if (strcmp(item.name, "ecu_id") == 0) {
-        if (_nc->ecu_id_str) free(_nc->ecu_id_str);
-        _nc->ecu_id_str = strdup(item.value);
+        FREE_PARAM(_nc, ecu_id_str);
+        _nc->ecu_id_str = ncodec_strdup(nc, item.value);
         _nc->ecu_id = strtoul(item.value, NULL, 10);
         return 0;
     }
+    if (strcmp(item.name, "flush") == 0) {
+        if (strcmp(item.value, "async") && strcmp(item.value, "sync")) {
+            return -EINVAL;
+        }
+        /* While the MIME type is parsed (no codec yet) the schema may not be
+           known, the combination is then rejected when the codec is created. */
+        if (strcmp(item.value, "async") == 0 && _nc->c.codec.config &&
+            _flush_async_supported(_nc) == false) {
+            return -ENOTSUP;
+        }
+        FREE_PARAM(_nc, flush_str);
+        _nc->flush_str = ncodec_strdup(nc, item.value);
+        _nc->flush_async = (strcmp(item.value, "async") == 0);
+        return 0;
+    }
+    if (strcmp(item.name, "subscribe") == 0) {
+        ABCodecSubscription subscription;
+        int32_t             rc =
+            _subscribe_parse(nc, &subscription, item.value);
+        if (rc) return rc;
+        FREE_PARAM(_nc, subscription.keys);
+        _nc->subscription = subscription;
+        FREE_PARAM(_nc, subscribe_str);
+        _nc->subscribe_str = ncodec_strdup(nc, item.value);
+        return 0;
+    }
+    if (strcmp(item.name, "metadata") == 0) {
+        if (strcmp(item.value, "lazy") && strcmp(item.value, "eager")) {
+            return -EINVAL;
+        }
+        FREE_PARAM(_nc, metadata_str);
+        _nc->metadata_str = ncodec_strdup(nc, item.value);
+        _nc->metadata_lazy = (strcmp(item.value, "lazy") == 0);
+        return 0;
+    }
+    if (strcmp(item.name, "coalesce") == 0) {
+        if (strcmp(item.value, "last") && strcmp(item.value, "none")) {
+            return -EINVAL;
+        }
+        /* As for flush=async, checked when the codec is created. */
+        if (strcmp(item.value, "last") == 0 && _nc->c.codec.config &&
+            _coalesce_supported(_nc) == false) {
+            return -ENOTSUP;
+        }
+        if (_nc->fbs_reserved) return -EBUSY;
+        FREE_PARAM(_nc, coalesce_str);
+        _nc->coalesce_str = ncodec_strdup(nc, item.value);
+        _nc->coalesce_last = (strcmp(item.value, "last") == 0);
+        return 0;
+    }
+    if (strcmp(item.name, "compression") == 0) {
+        if (strcmp(item.value, "lz4") && strcmp(item.value, "none")) {
+            return -EINVAL;
+        }
+        FREE_PARAM(_nc, compression_str);
+        _nc->compression_str = ncodec_strdup(nc, item.value);
+        _nc->compression_lz4 = (strcmp(item.value, "lz4") == 0);
+        return 0;
+    }
+    if (strcmp(item.name, "stats") == 0) {
+        if (strcmp(item.value, "timing") && strcmp(item.value, "counters")) {
+            return -EINVAL;
+        }
+        FREE_PARAM(_nc, stats_param_str);
+        _nc->stats_param_str = ncodec_strdup(nc, item.value);
+        _nc->stats_timing = (strcmp(item.value, "timing") == 0);
+        return 0;
+    }
 
     return -EINVAL;
 }
 
 
+static const struct {
+    const char* name;
+    size_t      offset;
+} stats_items[AB_CODEC_STATS_COUNT] = {
+    { "write_count", offsetof(ABCodecStats, write_count) },
+    { "write_bytes", offsetof(ABCodecStats, write_bytes) },
+    { "read_count", offsetof(ABCodecStats, read_count) },
+    { "read_bytes", offsetof(ABCodecStats, read_bytes) },
+    { "flush_count", offsetof(ABCodecStats, flush_count) },
+    { "filter_count", offsetof(ABCodecStats, filter_count) },
+    { "builder_hwm", offsetof(ABCodecStats, builder_hwm) },
+    { "write_ns", offsetof(ABCodecStats, write_ns) },
+    { "read_ns", offsetof(ABCodecStats, read_ns) },
+    { "flush_ns", offsetof(ABCodecStats, flush_ns) },
+};
+
+#define PARAM_COUNT 15 /* Parameters are index 0 .. PARAM_COUNT - 1. */
+
+
 NCodecConfigItem codec_stat(NCODEC* nc, int32_t* index)
 {
     ABCodecInstance* _nc = (ABCodecInstance*)nc;
@@ -128,6 +877,11 @@ NCodecConfigItem codec_stat(NCODEC* nc, int32_t* index)
         return (struct NCodecConfigItem){};
     }
 
+    /* Parameters are followed by the performance counters. */
+    if ((*index >= PARAM_COUNT) && (*index < AB_CODEC_STATS_INDEX)) {
+        *index = AB_CODEC_STATS_INDEX;
+    }
+
     const char* name = NULL;
     const char* value = NULL;
     switch (*index) {
@@ -167,8 +921,45 @@ NCodecConfigItem codec_stat(NCODEC* nc, int32_t* index)
         name = "ecu_id";
         value = _nc->ecu_id_str;
         break;
+    case 9:
+        name = "flush";
+        value = _nc->flush_str;
+        break;
+    case 10:
+        name = "subscribe";
+        value = _nc->subscribe_str;
+        break;
+    case 11:
+        name = "metadata";
+        value = _nc->metadata_str;
+        break;
+    case 12:
+        name = "coalesce";
+        value = _nc->coalesce_str;
+        break;
+    case 13:
+        name = "compression";
+        value = _nc->compression_str;
+        break;
+    case 14:
+        name = "stats";
+        value = _nc->stats_param_str;
+        break;
     default:
-        *index = -1;
+        if ((*index >= AB_CODEC_STATS_INDEX) &&
+            (*index < AB_CODEC_STATS_INDEX + (int32_t)AB_CODEC_STATS_COUNT)) {
+            /* Performance counters, formatted on request. Counters are also
+               updated by the flush worker (flush=async), wait for it. */
+            codec_sync_wait(_nc);
+            size_t   i = *index - AB_CODEC_STATS_INDEX;
+            uint64_t v =
+                *(uint64_t*)((char*)&_nc->stats + stats_items[i].offset);
+            snprintf(_nc->stats_str[i], AB_CODEC_STATS_STR_LEN, "%" PRIu64, v);
+            name = stats_items[i].name;
+            value = _nc->stats_str[i];
+        } else {
+            *index = -1;
+        }
     }
 
     return (struct NCodecConfigItem){
@@ -178,30 +969,243 @@ NCodecConfigItem codec_stat(NCODEC* nc, int32_t* index)
 }
 
 
+/* Closed instances are pooled (up to POOL_SIZE), keeping the memory of their
+   builders for the next instance created. Only instances of the current
+   allocator are pooled, the pool is drained when the allocator is replaced
+   (before releasing a replaced allocator call codec_pool_drain()). */
+static ABCodecInstance*       pool_head;
+static size_t                 pool_count;
+static NCodecAllocatorVTable* pool_allocator;
+static pthread_mutex_t        pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void _instance_free(ABCodecInstance* _nc)
+{
+    if (_nc->fbs_builder_initalized) {
+        flatcc_builder_clear(&_nc->fbs_builders[0]);
+        flatcc_builder_clear(&_nc->fbs_builders[1]);
+    }
+    ncodec_free((NCODEC*)_nc, _nc);
+}
+
+
+static void _pool_release(ABCodecInstance* _nc)
+{
+    while (_nc) {
+        ABCodecInstance* next = _nc->pool_next;
+        _instance_free(_nc);
+        _nc = next;
+    }
+}
+
+
+/* Detach the pooled instances when the allocator was replaced, the caller
+   holds pool_lock and releases them with _pool_release(). */
+static ABCodecInstance* _pool_replace(NCodecAllocatorVTable* allocator)
+{
+    if (pool_allocator == allocator) return NULL;
+
+    ABCodecInstance* _nc = pool_head;
+    pool_head = NULL;
+    pool_count = 0;
+    pool_allocator = allocator;
+    return _nc;
+}
+
+
+static bool _pool_put(ABCodecInstance* _nc)
+{
+    if (_nc->fbs_builder_initalized == false) return false;
+    NCodecAllocatorVTable* allocator = ncodec_allocator(NULL);
+    if (_nc->c.allocator != allocator) return false;
+
+    pthread_mutex_lock(&pool_lock);
+    ABCodecInstance* replaced = _pool_replace(allocator);
+    bool             pooled = (pool_count < POOL_SIZE);
+    if (pooled) {
+        _nc->pool_next = pool_head;
+        pool_head = _nc;
+        pool_count++;
+    }
+    pthread_mutex_unlock(&pool_lock);
+    _pool_release(replaced);
+    return pooled;
+}
+
+
+static ABCodecInstance* _pool_get(NCodecAllocatorVTable* allocator)
+{
+    pthread_mutex_lock(&pool_lock);
+    ABCodecInstance* replaced = _pool_replace(allocator);
+    ABCodecInstance* _nc = pool_head;
+    if (_nc) {
+        pool_head = _nc->pool_next;
+        pool_count--;
+    }
+    pthread_mutex_unlock(&pool_lock);
+    _pool_release(replaced);
+    return _nc;
+}
+
+
 void codec_close(NCODEC* nc)
 {
     if (nc == NULL) return;
 
-    free_codec((ABCodecInstance*)nc);
-    free(nc);
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    release_codec(_nc);
+    _nc->descriptor = NULL;
+    if (_pool_put(_nc)) return;
+    _instance_free(_nc);
 }
 
 
-NCODEC* ncodec_create(const char* mime_type)
+/* Release the pooled instances (and their builders). Called when the codec
+   library is unloaded, or by an application to return the pooled memory. */
+void codec_pool_drain(void)
+{
+    pthread_mutex_lock(&pool_lock);
+    ABCodecInstance* _nc = pool_head;
+    pool_head = NULL;
+    pool_count = 0;
+    pthread_mutex_unlock(&pool_lock);
+    _pool_release(_nc);
+}
+
+
+__attribute__((destructor)) static void _pool_destructor(void)
+{
+    codec_pool_drain();
+}
+
+
+/* Interned descriptors, keyed by MIME type. Descriptors are immutable once
+   compiled and remain for the lifetime of the process. The table grows as
+   descriptors are interned (load factor of 1). */
+static ABCodecDescriptor** descriptor_table;
+static size_t              descriptor_buckets;
+static size_t              descriptor_count;
+static pthread_mutex_t     descriptor_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static uint32_t _descriptor_hash(const char* s)
 {
-    char*            _buf = strdup(mime_type);
-    char*            _pos = NULL;
-    ABCodecInstance* _nc = NULL;
+    uint32_t h = 2166136261u; /* FNV-1a */
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+/* Parameters of a MIME type, separated by ";" and/or " ". Returns the next
+   parameter (and its length), or NULL at the end of the MIME type. */
+static const char* _mime_param(const char* s, size_t* len)
+{
+    s += strspn(s, "; ");
+    *len = strcspn(s, "; ");
+    return *len ? s : NULL;
+}
+
+
+/* Instance ids, which are carried by the MIME type of an instance but are not
+   part of its shape (the interned descriptor). */
+static bool _mime_param_is_id(const char* param, size_t len)
+{
+    static const char* ids[] = {
+        "bus_id",
+        "node_id",
+        "interface_id",
+        "swc_id",
+        "ecu_id",
+        NULL,
+    };
+    size_t name_len = strcspn(param, "=");
+    if (name_len >= len) return false;
+    for (size_t i = 0; ids[i]; i++) {
+        if (strlen(ids[i]) == name_len &&
+            strncmp(param, ids[i], name_len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/* Write the shape of a MIME type (without the instance ids) to buf, returns
+   the length of the shape. The content of buf is only valid when the length
+   is less than len (similar to snprintf()). */
+static size_t _mime_shape(const char* mime_type, char* buf, size_t len)
+{
+    size_t      shape_len = 0;
+    size_t      param_len;
+    const char* param = mime_type;
+    while ((param = _mime_param(param, &param_len)) != NULL) {
+        if (_mime_param_is_id(param, param_len) == false) {
+            if (shape_len) {
+                if (shape_len + 2 < len) memcpy(buf + shape_len, "; ", 2);
+                shape_len += 2;
+            }
+            if (shape_len + param_len < len) {
+                memcpy(buf + shape_len, param, param_len);
+            }
+            shape_len += param_len;
+        }
+        param += param_len;
+    }
+    if (shape_len < len) buf[shape_len] = '\0';
+    return shape_len;
+}
+
+
+/* Configure an instance with the instance ids of a MIME type. */
+static void _mime_apply_ids(NCODEC* nc, const char* mime_type)
+{
+    size_t      param_len;
+    const char* param = mime_type;
+    while ((param = _mime_param(param, &param_len)) != NULL) {
+        char item[64];
+        if (_mime_param_is_id(param, param_len) && param_len < sizeof(item)) {
+            memcpy(item, param, param_len);
+            item[param_len] = '\0';
+            char* value = strchr(item, '=');
+            *value++ = '\0';
+            codec_config(nc, (struct NCodecConfigItem){
+                                 .name = item,
+                                 .value = value,
+                             });
+        }
+        param += param_len;
+    }
+}
+
+
+static ABCodecDescriptor* _descriptor_parse(const char* mime_type)
+{
+    char*              _buf = strdup(mime_type);
+    char*              _pos = NULL;
+    ABCodecDescriptor* _d = NULL;
+    ABCodecInstance*   _nc = NULL;
+    if (_buf == NULL) return NULL;
 
     /* Check the MIMEtype is correct. */
     char* _codec_name = strtok_r(_buf, "; ", &_pos);
-    if (strncmp(_codec_name, CODEC, strlen(CODEC)) != 0) {
+    if (_codec_name == NULL ||
+        strncmp(_codec_name, CODEC, strlen(CODEC)) != 0) {
         goto create_fail;
     }
 
-    /* Allocate the codec object. */
-    _nc = calloc(1, sizeof(ABCodecInstance));
-    _nc->c.mime_type = mime_type;
+    /* Allocate the descriptor, and its template codec object. Descriptors
+       outlive the allocator set when they are compiled, and are therefore
+       always allocated with libc (including the template parameters). */
+    _d = calloc(1, sizeof(ABCodecDescriptor));
+    if (_d == NULL) goto create_fail;
+    _d->mime_type = strdup(mime_type);
+    if (_d->mime_type == NULL) goto create_fail;
+    _nc = &_d->instance;
+    _nc->c.mime_type = _d->mime_type;
+    _nc->c.allocator = &descriptor_allocator;
 
     /* Parse out the remaining parameters from the MIMEtype. */
     char* _param;
@@ -236,12 +1240,42 @@ NCODEC* ncodec_create(const char* mime_type)
             goto create_fail;
         }
     }
-    if (_nc->schema == NULL || strcmp(_nc->schema, "fbs")) {
+    if (_nc->schema == NULL) {
+        goto create_fail;
+    } else if (strcmp(_nc->schema, "raw") == 0) {
+        /* Only for CAN frames. */
+        if (strcmp(_nc->type, "frame")) goto create_fail;
+    } else if (strcmp(_nc->schema, "columnar") == 0) {
+        /* Only for PDUs. */
+        if (strcmp(_nc->type, "pdu")) goto create_fail;
+    } else if (strcmp(_nc->schema, "fbs")) {
+        goto create_fail;
+    }
+    if (_nc->flush_async && _flush_async_supported(_nc) == false) {
+        goto create_fail;
+    }
+    if (_nc->coalesce_last && _coalesce_supported(_nc) == false) {
         goto create_fail;
     }
 
     /* Determine which codec implementation to use. */
-    if (strcmp(_nc->type, "frame") == 0 && strcmp(_nc->bus, "can") == 0) {
+    if (strcmp(_nc->type, "frame") == 0 && strcmp(_nc->schema, "raw") == 0) {
+        _nc->c.codec = (struct NCodecVTable){
+            .config = codec_config,
+            .stat = codec_stat,
+            .write = can_raw_write,
+            .read = can_raw_read,
+            .flush = can_raw_flush,
+            .truncate = can_raw_truncate,
+            .close = codec_close,
+            .read_batch = can_raw_read_batch,
+            .write_batch = can_raw_write_batch,
+            .write_reserve = can_raw_write_reserve,
+            .write_commit = can_raw_write_commit,
+            .reset = codec_reset,
+        };
+    } else if (strcmp(_nc->type, "frame") == 0 &&
+               strcmp(_nc->bus, "can") == 0) {
         _nc->c.codec = (struct NCodecVTable){
             .config = codec_config,
             .stat = codec_stat,
@@ -250,6 +1284,27 @@ NCODEC* ncodec_create(const char* mime_type)
             .flush = can_flush,
             .truncate = can_truncate,
             .close = codec_close,
+            .read_batch = can_read_batch,
+            .write_batch = can_write_batch,
+            .write_reserve = can_write_reserve,
+            .write_commit = can_write_commit,
+            .sync = codec_sync,
+            .reset = codec_reset,
+        };
+    } else if (strcmp(_nc->type, "pdu") == 0 &&
+               strcmp(_nc->schema, "columnar") == 0) {
+        _nc->c.codec = (struct NCodecVTable){
+            .config = codec_config,
+            .stat = codec_stat,
+            .write = pdu_columnar_write,
+            .read = pdu_columnar_read,
+            .flush = pdu_columnar_flush,
+            .truncate = pdu_columnar_truncate,
+            .close = codec_close,
+            .write_batch = pdu_columnar_write_batch,
+            .write_reserve = pdu_columnar_write_reserve,
+            .write_commit = pdu_columnar_write_commit,
+            .reset = codec_reset,
         };
     } else if (strcmp(_nc->type, "pdu") == 0) {
         _nc->c.codec = (struct NCodecVTable){
@@ -260,24 +1315,198 @@ NCODEC* ncodec_create(const char* mime_type)
             .flush = pdu_flush,
             .truncate = pdu_truncate,
             .close = codec_close,
+            .write_batch = pdu_write_batch,
+            .write_reserve = pdu_write_reserve,
+            .write_commit = pdu_write_commit,
+            .sync = codec_sync,
+            .pdu_transport = pdu_transport,
+            .reset = codec_reset,
         };
     } else {
         goto create_fail;
     }
 
+    return _d;
+
+create_fail:
+    free(_buf);
+    _descriptor_free(_d);
+    return NULL;
+}
+
+
+static void _descriptor_table_grow(void)
+{
+    size_t buckets =
+        descriptor_buckets ? descriptor_buckets * 2 : DESCRIPTOR_BUCKETS;
+    ABCodecDescriptor** table = calloc(buckets, sizeof(ABCodecDescriptor*));
+    if (table == NULL) return; /* Continue with the current table. */
+
+    for (size_t i = 0; i < descriptor_buckets; i++) {
+        ABCodecDescriptor* _d = descriptor_table[i];
+        while (_d) {
+            ABCodecDescriptor* next = _d->next;
+            size_t             bucket = _d->hash % buckets;
+            _d->next = table[bucket];
+            table[bucket] = _d;
+            _d = next;
+        }
+    }
+    free(descriptor_table);
+    descriptor_table = table;
+    descriptor_buckets = buckets;
+}
+
+
+const NCodecDescriptor* ncodec_compile(const char* mime_type)
+{
+    if (mime_type == NULL) return NULL;
+
+    uint32_t hash = _descriptor_hash(mime_type);
+
+    pthread_mutex_lock(&descriptor_lock);
+    if (descriptor_count >= descriptor_buckets) _descriptor_table_grow();
+    if (descriptor_table == NULL) {
+        pthread_mutex_unlock(&descriptor_lock);
+        return NULL;
+    }
+    size_t             bucket = hash % descriptor_buckets;
+    ABCodecDescriptor* _d = descriptor_table[bucket];
+    while (_d && (_d->hash != hash || strcmp(_d->mime_type, mime_type))) {
+        _d = _d->next;
+    }
+    if (_d == NULL) {
+        _d = _descriptor_parse(mime_type);
+        if (_d) {
+            _d->hash = hash;
+            _d->next = descriptor_table[bucket];
+            descriptor_table[bucket] = _d;
+            descriptor_count++;
+        }
+    }
+    pthread_mutex_unlock(&descriptor_lock);
+
+    return (NCodecDescriptor*)_d;
+}
+
+
+/* Builder allocations are made with the allocator of the instance, and are
+   only released when the builder is cleared (buffers do not shrink). */
+static int _builder_alloc(void* alloc_context, flatcc_iovec_t* b,
+    size_t request, int zero_fill, int alloc_type)
+{
+    NCODEC* nc = alloc_context;
+    UNUSED(alloc_type);
+
+    if (request == 0) {
+        ncodec_free(nc, b->iov_base);
+        b->iov_base = NULL;
+        b->iov_len = 0;
+        return 0;
+    }
+    if (request <= b->iov_len) return 0;
+
+    size_t n = 64;
+    while (n < request) {
+        n *= 2;
+    }
+    uint8_t* p = ncodec_realloc(nc, b->iov_base, n);
+    if (p == NULL) return -1;
+    if (zero_fill) memset(p + b->iov_len, 0, n - b->iov_len);
+    b->iov_base = p;
+    b->iov_len = n;
+    return 0;
+}
+
+
+static void _instance_init(ABCodecInstance* _nc, const ABCodecDescriptor* _d,
+    NCodecAllocatorVTable* allocator)
+{
+    /* Keep the builders of a reused instance, they remain valid when
+       restored at the same address. */
+    bool             reuse = _nc->fbs_builder_initalized;
+    flatcc_builder_t builders[2];
+    if (reuse) memcpy(builders, _nc->fbs_builders, sizeof(builders));
+
+    /* Copy the template, selectors and parameters remain with the
+       descriptor. */
+    *_nc = _d->instance;
+    _nc->descriptor = _d;
+    _nc->c.allocator = allocator;
+
     /* Complete the setup of this codec instance. */
-    flatcc_builder_init(&_nc->fbs_builder);
-    _nc->fbs_builder.buffer_flags |= flatcc_builder_with_size;
+    for (size_t i = 0; i < 2; i++) {
+        if (reuse) {
+            _nc->fbs_builders[i] = builders[i];
+            flatcc_builder_reset(&_nc->fbs_builders[i]);
+        } else {
+            flatcc_builder_custom_init(
+                &_nc->fbs_builders[i], NULL, NULL, _builder_alloc, _nc);
+            _nc->fbs_builders[i].buffer_flags |= flatcc_builder_with_size;
+        }
+    }
+    _nc->fbs_builder = &_nc->fbs_builders[0];
     _nc->fbs_stream_initalized = false;
     _nc->fbs_builder_initalized = true;
+}
+
+
+NCODEC* ncodec_create_from_descriptor(const NCodecDescriptor* descriptor)
+{
+    const ABCodecDescriptor* _d = descriptor;
+    if (_d == NULL) return NULL;
+
+    NCodecAllocatorVTable* allocator = ncodec_allocator(NULL);
+    ABCodecInstance*       _nc = _pool_get(allocator);
+    if (_nc == NULL) _nc = ncodec_alloc(NULL, sizeof(ABCodecInstance));
+    if (_nc == NULL) return NULL;
+    _instance_init(_nc, _d, allocator);
 
     return (void*)_nc;
+}
 
-create_fail:
-    if (_buf) free(_buf);
-    if (_nc) {
-        free_codec(_nc);
-        free(_nc);
+
+int32_t codec_reset(NCODEC* nc)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+
+    /* Reinitialise from the descriptor, keeping the API user references. */
+    NCodecInstance c = _nc->c;
+    release_codec(_nc);
+    _instance_init(_nc, _nc->descriptor, c.allocator);
+    _nc->c.mime_type = c.mime_type;
+    _nc->c.stream = c.stream;
+    _nc->c.trace = c.trace;
+    _nc->c.private = c.private;
+    if (c.mime_type && c.mime_type != _nc->descriptor->mime_type) {
+        _mime_apply_ids(nc, c.mime_type);
     }
-    return NULL;
+    if (_nc->c.stream) _nc->c.stream->seek(nc, 0, NCODEC_SEEK_RESET);
+
+    return 0;
+}
+
+
+NCODEC* ncodec_create(const char* mime_type)
+{
+    if (mime_type == NULL) return NULL;
+
+    /* Instances are created from the interned descriptor of the shape of
+       their MIME type, the instance ids (node_id etc.) are then applied. */
+    char   buf[256];
+    char*  shape = buf;
+    size_t len = _mime_shape(mime_type, buf, sizeof(buf));
+    if (len >= sizeof(buf)) {
+        shape = malloc(len + 1);
+        if (shape == NULL) return NULL;
+        _mime_shape(mime_type, shape, len + 1);
+    }
+    const NCodecDescriptor* _d = ncodec_compile(shape);
+    if (shape != buf) free(shape);
+    NCodecInstance* _nc = (void*)ncodec_create_from_descriptor(_d);
+    if (_nc == NULL) return NULL;
+    _nc->mime_type = mime_type;
+    _mime_apply_ids((void*)_nc, mime_type);
+    return (void*)_nc;
 }
@@ -5,6 +5,7 @@
 #ifndef DSE_NCODEC_LIBS_AUTOMOTIVE_BUS_CODEC_H_
 #define DSE_NCODEC_LIBS_AUTOMOTIVE_BUS_CODEC_H_
 
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <automotive_bus_schema/stream/flatbuffers_common_reader.h>
@@ -12,10 +13,155 @@
 #include <dse/ncodec/codec.h>
 
 
+/* Performance counters (supporting ncodec_stat()). */
+typedef struct ABCodecStats {
+    uint64_t write_count;
+    uint64_t write_bytes;
+    uint64_t read_count;
+    uint64_t read_bytes;
+    uint64_t flush_count;
+    uint64_t filter_count; /* Filtered by node_id/swc_id/subscribe. */
+    uint64_t builder_hwm;  /* Largest buffer emitted by the builder. */
+    uint64_t write_ns;     /* Only measured with stats=timing. */
+    uint64_t read_ns;
+    uint64_t flush_ns;
+} ABCodecStats;
+
+#define AB_CODEC_STATS_COUNT   (sizeof(ABCodecStats) / sizeof(uint64_t))
+#define AB_CODEC_STATS_STR_LEN 21
+/* Index (ncodec_stat()) of the first counter, fixed regardless of the number
+   of parameters. Enumeration continues from the last parameter to this
+   index. */
+#define AB_CODEC_STATS_INDEX   1000
+
+
+/* Compressed message (supporting compression=lz4), size prefixed:
+       uint32_t length;      Uncompressed length (of the size prefixed stream).
+       char     id[4];       File identifier, AB_CODEC_LZ4_IDENTIFIER.
+       uint8_t  block[];     LZ4 block.
+*/
+#define AB_CODEC_LZ4_IDENTIFIER "SLZ4"
+#define AB_CODEC_LZ4_HEADER_LEN 8
+
+/* Decompressed messages are appended to blocks which are not moved, so that
+   messages (and payloads) already returned remain valid. The head block is
+   the current (and largest) block. */
+typedef struct ABCodecInflateBlock {
+    struct ABCodecInflateBlock* next;
+    size_t                      len;
+    size_t                      used;
+    uint8_t                     data[];
+} ABCodecInflateBlock;
+
+
+/* Raw CAN stream (supporting schema=raw), a size prefixed message with a
+   header followed by fixed size records (host byte order). */
+#define AB_CODEC_RAW_IDENTIFIER  "SCRA"
+#define AB_CODEC_RAW_VERSION     1
+#define AB_CODEC_RAW_PAYLOAD_LEN 64
+
+typedef struct ABCodecRawHeader {
+    uint32_t count; /* Number of records. */
+    char     id[4]; /* File identifier, AB_CODEC_RAW_IDENTIFIER. */
+    uint16_t record_len;
+    uint16_t version;
+    uint32_t __reserved__;
+} ABCodecRawHeader;
+
+typedef struct ABCodecRawRecord {
+    uint32_t frame_id;
+    uint8_t  frame_type;
+    uint8_t  bus_id;
+    uint8_t  node_id;
+    uint8_t  interface_id;
+    uint8_t  len;
+    uint8_t  __reserved__[7];
+    uint8_t  payload[AB_CODEC_RAW_PAYLOAD_LEN];
+} ABCodecRawRecord;
+
+
+/* Columnar PDU stream (supporting schema=columnar), a size prefixed message
+   with a header followed by the columns id, swc_id, ecu_id (count entries)
+   and offset (count + 1 entries, PDU i is the payload blob range offset[i]
+   to offset[i + 1]), then the payload blob (padded to 4 bytes). Columns are
+   uint32_t, in host byte order. */
+#define AB_CODEC_COLUMNAR_IDENTIFIER "SPDC"
+#define AB_CODEC_COLUMNAR_VERSION    1
+
+typedef struct ABCodecColumnarHeader {
+    uint32_t count; /* Number of PDUs. */
+    char     id[4]; /* File identifier, AB_CODEC_COLUMNAR_IDENTIFIER. */
+    uint16_t version;
+    uint16_t __reserved__;
+    uint32_t payload_len;
+} ABCodecColumnarHeader;
+
+/* Columns of the PDUs written during a step (schema=columnar). */
+typedef struct ABCodecColumns {
+    uint32_t* id;
+    uint32_t* swc_id;
+    uint32_t* ecu_id;
+    uint32_t* offset;
+    size_t    count;
+    size_t    capacity; /* Capacity of each column. */
+    uint8_t*  payload;
+    size_t    payload_len;
+    size_t    payload_capacity;
+    bool      reserved; /* Payload of pdu_columnar_write_reserve(). */
+    size_t    reserved_len;
+    uint8_t*  buffer; /* Message, assembled when flushed. */
+    size_t    buffer_len;
+} ABCodecColumns;
+
+
+/* PDU subscription (supporting subscribe=). Entries are held in two open
+   addressing hash sets (PDU id, and (ecu_id, swc_id) pairs) which share one
+   allocation, a key of 0 marks an empty slot. The pair (0, 0), which has a
+   key of 0, is held by node_zero. */
+typedef struct ABCodecSubscription {
+    uint64_t* keys;      /* Id set, followed by the node set. */
+    size_t    mask;      /* Capacity - 1 (capacity is a power of 2). */
+    size_t    count;     /* 0, no subscription (all PDUs are read). */
+    bool      has_id;    /* Set contains PDU id entries. */
+    bool      has_node;  /* Set contains (ecu_id, swc_id) entries. */
+    bool      node_zero; /* Set contains (0, 0). */
+} ABCodecSubscription;
+
+
+/* CAN frame coalescing (supporting coalesce=last). Frames written during a
+   step are held in slots (in order of first write) and indexed by frame_id
+   in an open addressing hash table, an index entry of 0 marks an empty slot
+   (otherwise the entry is slot + 1). Slots are encoded when flushed. */
+typedef struct ABCodecCoalesceSlot {
+    uint32_t           frame_id;
+    NCodecCanFrameType frame_type;
+    uint8_t*           payload;
+    size_t             len;
+    size_t             capacity; /* Capacity of payload. */
+} ABCodecCoalesceSlot;
+
+typedef struct ABCodecCoalesce {
+    ABCodecCoalesceSlot* slots;
+    size_t               count;
+    size_t               capacity; /* Capacity of slots. */
+    uint32_t*            index;
+    size_t               mask;     /* Index capacity - 1 (power of 2). */
+    uint32_t             shift;    /* 32 - log2(index capacity). */
+    ABCodecCoalesceSlot* reserved; /* Slot of can_write_reserve(). */
+} ABCodecCoalesce;
+
+
+struct ABCodecDescriptor;
+
+
 /* Declare an extension to the NCodecInstance type. */
 typedef struct ABCodecInstance {
     NCodecInstance c;
 
+    /* Descriptor this instance was created from, the selectors and
+       parameters are shared with the descriptor until reconfigured. */
+    const struct ABCodecDescriptor* descriptor;
+
     /* Codec selectors: from MIMEtype. */
     char* interface;
     char* type;
@@ -29,17 +175,75 @@ typedef struct ABCodecInstance {
     char*   interface_id_str;
     char*   swc_id_str;
     char*   ecu_id_str;
+    char*   flush_str;
+    char*   subscribe_str;
+    char*   metadata_str;
+    char*   coalesce_str;
+    char*   compression_str;
+    char*   stats_param_str;
     /* Internal representation. */
     uint8_t bus_id;
     uint8_t node_id;
     uint8_t interface_id;
     uint8_t swc_id;
     uint8_t ecu_id;
+    bool    flush_async;
+    bool    metadata_lazy;
+    bool    coalesce_last;
+    bool    compression_lz4;
+    bool    stats_timing;
+
+    /* PDU subscription: from subscribe=. */
+    ABCodecSubscription subscription;
+
+    /* CAN frame coalescing: from coalesce=. */
+    ABCodecCoalesce coalesce;
 
     /* Flatbuffer resources. */
-    flatcc_builder_t fbs_builder;
-    bool             fbs_builder_initalized;
-    bool             fbs_stream_initalized;
+    flatcc_builder_t* fbs_builder; /* Active builder, one of fbs_builders. */
+    flatcc_builder_t  fbs_builders[2];
+    bool              fbs_builder_initalized;
+    bool              fbs_stream_initalized;
+    bool              fbs_reserved;
+    size_t            fbs_reserved_len;
+
+    /* Compression (compression=lz4), buffers are retained. */
+    struct {
+        uint8_t*             buffer; /* Flush, uncompressed and compressed. */
+        size_t               buffer_len;
+        ABCodecInflateBlock* inflate; /* Read, decompressed messages. */
+    } compress;
+
+    /* Raw schema (schema=raw), message (header and records) of the step. */
+    struct {
+        uint8_t*          buffer;
+        size_t            buffer_len;
+        size_t            count;
+        ABCodecRawRecord* reserved; /* Record of can_raw_write_reserve(). */
+    } raw;
+
+    /* Columnar schema (schema=columnar), PDUs of the step. */
+    ABCodecColumns columns;
+
+    /* Message of write_reserve(), supporting the trace of write_commit(). */
+    union {
+        NCodecCanMessage can;
+        NCodecPdu        pdu;
+    } reserved_msg;
+
+    /* Asynchronous flush (flush=async). */
+    struct {
+        pthread_t         thread;
+        pthread_mutex_t   mutex;
+        pthread_cond_t    cond;
+        bool              running;
+        bool              exit;
+        /* Builder handed to the worker, NULL when the worker is idle. */
+        flatcc_builder_t* pending;
+        void (*end_stream)(flatcc_builder_t* B);
+        /* Error of a flush made by the worker, see codec_sync(). */
+        int32_t rc;
+    } async;
 
     /* Message parsing state. */
     uint8_t* msg_ptr;
@@ -49,7 +253,27 @@ typedef struct ABCodecInstance {
     const flatbuffers_uoffset_t* vector;
     size_t                       vector_idx;
     size_t                       vector_len;
+    /* Last PDU returned by pdu_read() (supporting pdu_transport). */
+    const void*                  pdu_table;
+
+    /* Performance counters. */
+    ABCodecStats stats;
+    char         stats_str[AB_CODEC_STATS_COUNT][AB_CODEC_STATS_STR_LEN];
+
+    /* Instance pool (supporting codec_close()). */
+    struct ABCodecInstance* pool_next;
 } ABCodecInstance;
 
 
+/* Compiled MIME type, see ncodec_compile(). Descriptors are interned, an
+   instance created with ncodec_create() uses the descriptor of the shape of
+   its MIME type (i.e. without the instance ids). */
+typedef struct ABCodecDescriptor {
+    char*           mime_type;
+    uint32_t        hash;
+    ABCodecInstance instance; /* Template, configured from the MIME type. */
+    struct ABCodecDescriptor* next;
+} ABCodecDescriptor;
+
+
 #endif  // DSE_NCODEC_LIBS_AUTOMOTIVE_BUS_CODEC_H_
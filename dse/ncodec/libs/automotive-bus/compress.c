@@ -0,0 +1,195 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+/* LZ4 block format (compatible with LZ4_compress_default() and
+   LZ4_decompress_safe() of the reference implementation).
+
+   A block is a sequence of: token, literal length, literals, match offset
+   and match length. The token holds the literal length (high 4 bits) and the
+   match length - MINMATCH (low 4 bits), the value 15 indicates that further
+   length bytes follow (each 255 continues). The last sequence contains only
+   literals.
+*/
+
+#define MINMATCH     4
+#define MFLIMIT      12 /* The last match starts before this limit. */
+#define LASTLITERALS 5  /* The last bytes are always literals. */
+#define MAX_OFFSET   65535
+#define HASH_LOG     12
+#define RUN_MASK     15
+
+
+static inline uint32_t _read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+
+static inline uint32_t _hash(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - HASH_LOG);
+}
+
+
+static uint8_t* _write_length(uint8_t* op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+
+static uint8_t* _write_sequence(uint8_t* op, const uint8_t* literals,
+    size_t lit_len, size_t offset, size_t match_len)
+{
+    uint8_t* token = op++;
+    *token = (uint8_t)((lit_len < RUN_MASK ? lit_len : RUN_MASK) << 4);
+    if (lit_len >= RUN_MASK) op = _write_length(op, lit_len - RUN_MASK);
+    memcpy(op, literals, lit_len);
+    op += lit_len;
+    if (offset == 0) return op; /* Last sequence, literals only. */
+
+    *op++ = (uint8_t)(offset & 0xff);
+    *op++ = (uint8_t)(offset >> 8);
+    match_len -= MINMATCH;
+    *token |= (uint8_t)(match_len < RUN_MASK ? match_len : RUN_MASK);
+    if (match_len >= RUN_MASK) op = _write_length(op, match_len - RUN_MASK);
+    return op;
+}
+
+
+size_t codec_lz4_bound(size_t len)
+{
+    return len + (len / 255) + 16;
+}
+
+
+/* Compress `src` into `dst`, which must have a capacity of at least
+   codec_lz4_bound(len). Returns the compressed length (or 0). */
+size_t codec_lz4_compress(
+    const uint8_t* src, size_t len, uint8_t* dst, size_t dst_len)
+{
+    if (dst_len < codec_lz4_bound(len)) return 0;
+
+    uint32_t       table[1 << HASH_LOG] = { 0 };
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* const end = src + len;
+    uint8_t*       op = dst;
+
+    if (len > MFLIMIT) {
+        const uint8_t* const mflimit = end - MFLIMIT;
+        const uint8_t* const matchlimit = end - LASTLITERALS;
+
+        table[_hash(_read32(ip))] = 0;
+        ip++;
+        while (ip < mflimit) {
+            /* Find a match (candidate of the hash table, verified). */
+            uint32_t       h = _hash(_read32(ip));
+            const uint8_t* ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+            if (ref >= ip || (ip - ref) > MAX_OFFSET ||
+                _read32(ref) != _read32(ip)) {
+                ip++;
+                continue;
+            }
+
+            /* Extend the match, backwards and then forwards. */
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t* m = ip + MINMATCH;
+            const uint8_t* r = ref + MINMATCH;
+            while (m < matchlimit && *m == *r) {
+                m++;
+                r++;
+            }
+
+            op = _write_sequence(
+                op, anchor, ip - anchor, ip - ref, (size_t)(m - ip));
+            ip = anchor = m;
+            if (ip < mflimit) {
+                table[_hash(_read32(ip - 2))] = (uint32_t)(ip - 2 - src);
+            }
+        }
+    }
+
+    /* Last literals. */
+    op = _write_sequence(op, anchor, end - anchor, 0, 0);
+    return op - dst;
+}
+
+
+static int32_t _read_length(
+    const uint8_t** ip, const uint8_t* const iend, size_t* len)
+{
+    uint8_t b;
+    do {
+        if (*ip >= iend) return -EPROTO;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+
+/* Decompress `src` into `dst`. Returns the decompressed length, or -EPROTO
+   if the block is malformed (or larger than `dst_len`). */
+int32_t codec_lz4_decompress(
+    const uint8_t* src, size_t len, uint8_t* dst, size_t dst_len)
+{
+    const uint8_t*       ip = src;
+    const uint8_t* const iend = src + len;
+    uint8_t*             op = dst;
+    uint8_t* const       oend = dst + dst_len;
+
+    if (dst_len > INT32_MAX) return -EINVAL;
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        /* Literals. */
+        size_t lit_len = token >> 4;
+        if (lit_len == RUN_MASK && _read_length(&ip, iend, &lit_len)) {
+            return -EPROTO;
+        }
+        if (lit_len > (size_t)(iend - ip) || lit_len > (size_t)(oend - op)) {
+            return -EPROTO;
+        }
+        memcpy(op, ip, lit_len);
+        op += lit_len;
+        ip += lit_len;
+        if (ip == iend) break; /* Last sequence. */
+
+        /* Match (may overlap the output, copy forwards). */
+        if (iend - ip < 2) return -EPROTO;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return -EPROTO;
+        size_t match_len = token & RUN_MASK;
+        if (match_len == RUN_MASK && _read_length(&ip, iend, &match_len)) {
+            return -EPROTO;
+        }
+        match_len += MINMATCH;
+        if (match_len > (size_t)(oend - op)) return -EPROTO;
+        const uint8_t* ref = op - offset;
+        for (size_t i = 0; i < match_len; i++) {
+            op[i] = ref[i];
+        }
+        op += match_len;
+    }
+
+    return (int32_t)(op - dst);
+}
@@ -12,13 +12,29 @@
 
 #undef ns
 #define ns(x) FLATBUFFERS_WRAP_NAMESPACE(AutomotiveBus_Stream_Frame, x)
+#define COALESCE_SLOTS   16 /* Initial slot capacity (power of 2). */
+#define COALESCE_PAYLOAD 8  /* Minimum payload capacity of a slot. */
+
+
+extern size_t   codec_flush_builder(ABCodecInstance* nc, flatcc_builder_t* B);
+extern uint64_t codec_clock_ns(ABCodecInstance* nc);
+extern int32_t  codec_flush_async(
+    ABCodecInstance* nc, void (*end_stream)(flatcc_builder_t* B));
+extern void     codec_sync_wait(ABCodecInstance* nc);
+extern int32_t  codec_decompress(
+    ABCodecInstance* nc, uint8_t** msg_ptr, size_t* msg_len);
+extern void     codec_inflate_reset(ABCodecInstance* nc);
+extern void     codec_trace_write_batch(
+    ABCodecInstance* nc, NCodecMessage* msgs, size_t size, size_t count);
+extern void     codec_trace_read_batch(
+    ABCodecInstance* nc, NCodecCanMessageBatch* b);
 
 
 static void initialize_stream(ABCodecInstance* nc)
 {
     if (nc->fbs_stream_initalized) return;
 
-    flatcc_builder_t* B = &nc->fbs_builder;
+    flatcc_builder_t* B = nc->fbs_builder;
     flatcc_builder_reset(B);
     ns(Stream_start_as_root_with_size(B));
     ns(Stream_frames_start(B));
@@ -30,26 +46,191 @@ static void reset_stream(ABCodecInstance* nc)
 {
     if (nc->fbs_stream_initalized == false) return;
 
-    flatcc_builder_t* B = &nc->fbs_builder;
+    flatcc_builder_t* B = nc->fbs_builder;
     flatcc_builder_reset(B);
     nc->fbs_stream_initalized = false;
+    nc->fbs_reserved = false;
+    nc->fbs_reserved_len = 0;
 }
 
 
-static void finalize_stream(
-    ABCodecInstance* nc, uint8_t** buffer, size_t* length)
+static void end_stream(flatcc_builder_t* B)
 {
-    if (nc->fbs_stream_initalized == false) {
-        *buffer = NULL;
-        *length = 0;
-        return;
-    }
-
-    flatcc_builder_t* B = &nc->fbs_builder;
     ns(Stream_frames_end(B));
     ns(Stream_end_as_root(B));
-    *buffer = flatcc_builder_finalize_buffer(B, length);
+}
+
+
+static size_t finalize_stream(ABCodecInstance* nc)
+{
+    if (nc->fbs_stream_initalized == false) return 0;
+
+    /* Asynchronous, the builder is ended and copied by the worker. */
+    if (nc->flush_async && codec_flush_async(nc, end_stream) == 0) {
+        nc->fbs_stream_initalized = false;
+        return 0;
+    }
+
+    flatcc_builder_t* B = nc->fbs_builder;
+    codec_sync_wait(nc);
+    end_stream(B);
+    size_t length = codec_flush_builder(nc, B);
     reset_stream(nc);
+    return length;
+}
+
+
+static ns(Frame_ref_t) encode_can_frame(
+    ABCodecInstance* nc, NCodecCanMessage* msg)
+{
+    flatcc_builder_t* B = nc->fbs_builder;
+
+    ns(Frame_start(B));
+    ns(CanFrame_start(B));
+    /* Encode the message. */
+    ns(CanFrame_frame_id_add(B, msg->frame_id));
+    ns(CanFrame_frame_type_add(B, msg->frame_type));
+    ns(CanFrame_payload_add(
+        B, flatbuffers_uint8_vec_create(B, msg->buffer, msg->len)));
+    /* Add additional metadata. */
+    ns(CanFrame_bus_id_add(B, nc->bus_id));
+    ns(CanFrame_node_id_add(B, nc->node_id));
+    ns(CanFrame_interface_id_add(B, nc->interface_id));
+    /* Complete the encoding. */
+    ns(Frame_f_CanFrame_add(B, ns(CanFrame_end(B))));
+    return ns(Frame_end(B));
+}
+
+
+static void coalesce_clear(ABCodecInstance* nc)
+{
+    ABCodecCoalesce* c = &nc->coalesce;
+    if (c->reserved) {
+        c->reserved = NULL;
+        nc->fbs_reserved = false;
+        nc->fbs_reserved_len = 0;
+    }
+    if (c->count == 0) return;
+
+    memset(c->index, 0, (c->mask + 1) * sizeof(uint32_t));
+    c->count = 0;
+}
+
+
+/* Fibonacci hashing, the index is taken from the high bits of the product
+   (the low bits of sequential frame ids would otherwise cluster). */
+static inline size_t coalesce_hash(ABCodecCoalesce* c, uint32_t frame_id)
+{
+    return (uint32_t)(frame_id * 2654435761u) >> c->shift;
+}
+
+
+static int32_t coalesce_grow(ABCodecInstance* nc)
+{
+    ABCodecCoalesce* c = &nc->coalesce;
+    size_t           capacity = c->capacity ? c->capacity * 2 : COALESCE_SLOTS;
+    size_t           mask = capacity * 2 - 1; /* Load factor <= 0.5 */
+
+    uint32_t* index = ncodec_alloc((NCODEC*)nc, (mask + 1) * sizeof(*index));
+    if (index == NULL) return -ENOMEM;
+    ABCodecCoalesceSlot* slots =
+        ncodec_realloc((NCODEC*)nc, c->slots, capacity * sizeof(*slots));
+    if (slots == NULL) {
+        ncodec_free((NCODEC*)nc, index);
+        return -ENOMEM;
+    }
+    memset(&slots[c->capacity], 0, (capacity - c->capacity) * sizeof(*slots));
+    c->slots = slots;
+    c->capacity = capacity;
+    ncodec_free((NCODEC*)nc, c->index);
+    c->index = index;
+    c->mask = mask;
+    c->shift = 32;
+    for (size_t n = mask + 1; n > 1; n >>= 1) {
+        c->shift--;
+    }
+
+    /* Rehash the current slots. */
+    for (size_t i = 0; i < c->count; i++) {
+        size_t h = coalesce_hash(c, c->slots[i].frame_id);
+        while (c->index[h]) {
+            h = (h + 1) & c->mask;
+        }
+        c->index[h] = i + 1;
+    }
+    return 0;
+}
+
+
+/* Locate the slot of a frame_id, or allocate a new (empty) slot. */
+static ABCodecCoalesceSlot* coalesce_slot(
+    ABCodecInstance* nc, uint32_t frame_id, size_t len)
+{
+    ABCodecCoalesce*     c = &nc->coalesce;
+    ABCodecCoalesceSlot* slot = NULL;
+
+    if (c->count == c->capacity && coalesce_grow(nc)) return NULL;
+    size_t h = coalesce_hash(c, frame_id);
+    while (c->index[h]) {
+        if (c->slots[c->index[h] - 1].frame_id == frame_id) {
+            slot = &c->slots[c->index[h] - 1];
+            break;
+        }
+        h = (h + 1) & c->mask;
+    }
+    bool found = (slot != NULL);
+    if (found == false) slot = &c->slots[c->count];
+
+    /* Payload buffers are retained (for the slot) between steps. */
+    if (slot->payload == NULL || len > slot->capacity) {
+        size_t   capacity = (len > COALESCE_PAYLOAD) ? len : COALESCE_PAYLOAD;
+        uint8_t* payload =
+            ncodec_realloc((NCODEC*)nc, slot->payload, capacity);
+        if (payload == NULL) return NULL;
+        slot->payload = payload;
+        slot->capacity = capacity;
+    }
+    if (found == false) {
+        slot->frame_id = frame_id;
+        slot->len = 0;
+        c->index[h] = ++c->count;
+    }
+    return slot;
+}
+
+
+/* Write a message to its slot, overwriting any previous message with the
+   same frame_id (in this step). */
+static int32_t coalesce_write(ABCodecInstance* nc, NCodecCanMessage* msg)
+{
+    ABCodecCoalesceSlot* slot = coalesce_slot(nc, msg->frame_id, msg->len);
+    if (slot == NULL) return -ENOMEM;
+
+    if (msg->len) memcpy(slot->payload, msg->buffer, msg->len);
+    slot->len = msg->len;
+    slot->frame_type = msg->frame_type;
+    return 0;
+}
+
+
+/* Encode the coalesced messages (in order of first write). */
+static void coalesce_encode(ABCodecInstance* nc)
+{
+    ABCodecCoalesce* c = &nc->coalesce;
+    if (c->count == 0) return;
+
+    flatcc_builder_t* B = nc->fbs_builder;
+    initialize_stream(nc);
+    for (size_t i = 0; i < c->count; i++) {
+        NCodecCanMessage msg = {
+            .frame_id = c->slots[i].frame_id,
+            .frame_type = c->slots[i].frame_type,
+            .buffer = c->slots[i].payload,
+            .len = c->slots[i].len,
+        };
+        ns(Stream_frames_push(B, encode_can_frame(nc, &msg)));
+    }
+    coalesce_clear(nc);
 }
 
 
@@ -60,26 +241,171 @@ int32_t can_write(NCODEC* nc, NCodecMessage* msg)
     if (_nc == NULL) return -ENOSTR;
     if (_msg == NULL) return -EINVAL;
     if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->fbs_reserved) return -EBUSY;
+
+    flatcc_builder_t* B = _nc->fbs_builder;
+    uint64_t          t0 = codec_clock_ns(_nc);
+
+    if (_nc->coalesce_last) {
+        int32_t rc = coalesce_write(_nc, _msg);
+        if (rc) return rc;
+    } else {
+        initialize_stream(_nc);
+        ns(Stream_frames_push(B, encode_can_frame(_nc, _msg)));
+    }
+
+    _nc->stats.write_count++;
+    _nc->stats.write_bytes += _msg->len;
+    _nc->stats.write_ns += codec_clock_ns(_nc) - t0;
+    return _msg->len;
+}
+
+
+int32_t can_write_batch(NCODEC* nc, NCodecMessage* msgs, size_t count)
+{
+    ABCodecInstance*  _nc = (ABCodecInstance*)nc;
+    NCodecCanMessage* _msgs = (NCodecCanMessage*)msgs;
+    if (_nc == NULL) return -ENOSTR;
+    if (_msgs == NULL && count) return -EINVAL;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->fbs_reserved) return -EBUSY;
+    if (count > INT32_MAX) return -EINVAL;
+    if (count == 0) return 0;
+
+    flatcc_builder_t* B = _nc->fbs_builder;
+    uint64_t          t0 = codec_clock_ns(_nc);
+
+    if (_nc->coalesce_last) {
+        /* Frames are written to slots individually, on failure the frames
+           already written remain (and are counted). */
+        size_t i;
+        for (i = 0; i < count; i++) {
+            if (coalesce_write(_nc, &_msgs[i])) break;
+            _nc->stats.write_bytes += _msgs[i].len;
+        }
+        _nc->stats.write_count += i;
+        _nc->stats.write_ns += codec_clock_ns(_nc) - t0;
+        codec_trace_write_batch(_nc, _msgs, sizeof(*_msgs), i);
+        return i ? (int32_t)i : -ENOMEM;
+    }
+
+    initialize_stream(_nc);
+    /* Reserve the vector slots for all frames, then encode each frame and
+       set its reference. The vector is edited via its (current) base pointer
+       because encoding a frame may reallocate the builder stack. */
+    size_t base = ns(Stream_frames_reserved_len(B));
+    if (ns(Stream_frames_extend(B, count)) == NULL) return -ENOMEM;
+    for (size_t i = 0; i < count; i++) {
+        ns(Frame_ref_t) ref = encode_can_frame(_nc, &_msgs[i]);
+        ns(Stream_frames_edit(B))[base + i] = ref;
+        _nc->stats.write_bytes += _msgs[i].len;
+    }
+
+    _nc->stats.write_count += count;
+    _nc->stats.write_ns += codec_clock_ns(_nc) - t0;
+    codec_trace_write_batch(_nc, _msgs, sizeof(*_msgs), count);
+    return (int32_t)count;
+}
 
-    flatcc_builder_t* B = &_nc->fbs_builder;
+
+uint8_t* can_write_reserve(NCODEC* nc, NCodecMessage* msg, size_t len)
+{
+    ABCodecInstance*  _nc = (ABCodecInstance*)nc;
+    NCodecCanMessage* _msg = (NCodecCanMessage*)msg;
+    if (_nc == NULL) {
+        errno = ENOSTR;
+        return NULL;
+    }
+    if (_msg == NULL || len > INT32_MAX) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (_nc->c.stream == NULL) {
+        errno = ENOSR;
+        return NULL;
+    }
+    if (_nc->fbs_reserved) {
+        errno = EBUSY;
+        return NULL;
+    }
+
+    flatcc_builder_t* B = _nc->fbs_builder;
+
+    /* Coalesce, the payload is reserved in the slot of the frame. */
+    if (_nc->coalesce_last) {
+        ABCodecCoalesceSlot* slot = coalesce_slot(_nc, _msg->frame_id, len);
+        if (slot == NULL) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        slot->len = 0;
+        slot->frame_type = _msg->frame_type;
+        _nc->coalesce.reserved = slot;
+        _nc->fbs_reserved = true;
+        _nc->fbs_reserved_len = len;
+        _nc->reserved_msg.can = *_msg;
+        _nc->reserved_msg.can.buffer = slot->payload;
+        return slot->payload;
+    }
 
     initialize_stream(_nc);
     ns(Stream_frames_push_start(B));
     ns(CanFrame_start(B));
-    /* Encode the message. */
+    /* Encode the message header. */
     ns(CanFrame_frame_id_add(B, _msg->frame_id));
     ns(CanFrame_frame_type_add(B, _msg->frame_type));
-    ns(CanFrame_payload_add(
-        B, flatbuffers_uint8_vec_create(B, _msg->buffer, _msg->len)));
     /* Add additional metadata. */
     ns(CanFrame_bus_id_add(B, _nc->bus_id));
     ns(CanFrame_node_id_add(B, _nc->node_id));
     ns(CanFrame_interface_id_add(B, _nc->interface_id));
-    /* Complete the encoding. */
-    ns(Frame_f_CanFrame_add(B, ns(CanFrame_end(B))));
-    ns(Stream_frames_push_end(B));
+    /* Reserve the payload, the frame is completed by can_write_commit(). */
+    ns(CanFrame_payload_start(B));
+    uint8_t* payload = ns(CanFrame_payload_extend(B, len));
+    if (payload == NULL) {
+        reset_stream(_nc);
+        errno = ENOMEM;
+        return NULL;
+    }
+    _nc->fbs_reserved = true;
+    _nc->fbs_reserved_len = len;
+    _nc->reserved_msg.can = *_msg;
+    _nc->reserved_msg.can.buffer = payload;
 
-    return _msg->len;
+    return payload;
+}
+
+
+int32_t can_write_commit(NCODEC* nc, size_t len)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->fbs_reserved == false) return -EINVAL;
+    if (len > _nc->fbs_reserved_len) return -EINVAL;
+
+    flatcc_builder_t* B = _nc->fbs_builder;
+
+    if (_nc->coalesce.reserved) {
+        /* Complete the slot. */
+        _nc->coalesce.reserved->len = len;
+        _nc->coalesce.reserved = NULL;
+    } else {
+        /* Complete the encoding (payload, frame and vector element). */
+        ns(CanFrame_payload_truncate(B, _nc->fbs_reserved_len - len));
+        ns(CanFrame_payload_end(B));
+        ns(Frame_f_CanFrame_add(B, ns(CanFrame_end(B))));
+        ns(Stream_frames_push_end(B));
+    }
+    _nc->fbs_reserved = false;
+    _nc->fbs_reserved_len = 0;
+
+    _nc->stats.write_count++;
+    _nc->stats.write_bytes += len;
+    if (_nc->c.trace.write) {
+        _nc->reserved_msg.can.len = len;
+        _nc->c.trace.write(nc, &_nc->reserved_msg.can);
+    }
+    return (int32_t)len;
 }
 
 
@@ -94,7 +420,11 @@ static void get_msg_from_stream(NCODEC* nc)
     _nc->vector_idx = 0;
     _nc->vector_len = 0;
 
-    /* Next message? */
+    /* Next message? Reading from the start of the stream (i.e. the stream
+       was rewound), release the messages decompressed by the previous pass. */
+    if (_nc->c.stream->tell && _nc->c.stream->tell(nc) == 0) {
+        codec_inflate_reset(_nc);
+    }
     uint8_t* buffer;
     size_t   length;
     _nc->c.stream->read(nc, &buffer, &length, NCODEC_POS_NC);
@@ -108,10 +438,13 @@ static void get_msg_from_stream(NCODEC* nc)
         if (msg_len == 0) break;
         /* Advance the stream pos (+4 for size prefix). */
         _nc->c.stream->seek(nc, msg_len + 4, NCODEC_SEEK_CUR);
-        /* Set the parsing state. */
-        if (flatbuffers_has_identifier(msg_ptr, flatbuffers_identifier)) {
-            _nc->msg_ptr = msg_ptr;
-            _nc->msg_len = msg_len;
+        /* Set the parsing state (decompress if necessary). */
+        uint8_t* _msg_ptr = msg_ptr;
+        size_t   _msg_len = msg_len;
+        if (codec_decompress(_nc, &_msg_ptr, &_msg_len) == 0 &&
+            flatbuffers_has_identifier(_msg_ptr, flatbuffers_identifier)) {
+            _nc->msg_ptr = _msg_ptr;
+            _nc->msg_len = _msg_len;
             return;
         }
         /* Next message in the stream. */
@@ -141,6 +474,24 @@ static void get_vector_from_message(NCODEC* nc)
 }
 
 
+static ns(CanFrame_table_t) get_can_frame(ABCodecInstance* nc, size_t index)
+{
+    ns(Frame_table_t) frame = ns(Frame_vec_at(nc->vector, index));
+    if (!ns(Frame_f_is_present(frame))) return NULL;
+    ns(FrameTypes_union_type_t) frame_type = ns(Frame_f_type(frame));
+    if (frame_type != ns(FrameTypes_CanFrame)) return NULL;
+
+    /* Filter: sender==receiver. */
+    ns(CanFrame_table_t) can_frame = (ns(CanFrame_table_t))ns(Frame_f(frame));
+    if ((nc->node_id) && (nc->node_id == ns(CanFrame_node_id(can_frame)))) {
+        nc->stats.filter_count++;
+        return NULL;
+    }
+
+    return can_frame;
+}
+
+
 int32_t can_read(NCODEC* nc, NCodecMessage* msg)
 {
     ABCodecInstance*  _nc = (ABCodecInstance*)nc;
@@ -148,28 +499,21 @@ int32_t can_read(NCODEC* nc, NCodecMessage* msg)
     if (_nc == NULL) return -ENOSTR;
     if (_msg == NULL) return -EINVAL;
     if (_nc->c.stream == NULL) return -ENOSR;
+    codec_sync_wait(_nc);
 
     /* Reset the message, in case caller ignores the return value. */
     _msg->len = 0;
     _msg->frame_type = CAN_BASE_FRAME;
     _msg->buffer = NULL;
+    uint64_t t0 = codec_clock_ns(_nc);
 
     /* Process the stream/frames. */
     if (_nc->msg_ptr == NULL) get_msg_from_stream(nc);
     if (_nc->vector == NULL) get_vector_from_message(nc);
     while (_nc->msg_ptr && _nc->vector) {
         for (uint32_t _vi = _nc->vector_idx; _vi < _nc->vector_len; _vi++) {
-            ns(Frame_table_t) frame = ns(Frame_vec_at(_nc->vector, _vi));
-            if (!ns(Frame_f_is_present(frame))) continue;
-            ns(FrameTypes_union_type_t) frame_type = ns(Frame_f_type(frame));
-            if (frame_type != ns(FrameTypes_CanFrame)) continue;
-
-            /* Filter: sender==receiver. */
-            ns(CanFrame_table_t) can_frame =
-                (ns(CanFrame_table_t))ns(Frame_f(frame));
-            if ((_nc->node_id) &&
-                (_nc->node_id == ns(CanFrame_node_id(can_frame))))
-                continue;
+            ns(CanFrame_table_t) can_frame = get_can_frame(_nc, _vi);
+            if (can_frame == NULL) continue;
 
             /* Return the message. */
             _msg->frame_id = ns(CanFrame_frame_id(can_frame));
@@ -185,6 +529,9 @@ int32_t can_read(NCODEC* nc, NCodecMessage* msg)
 
             /* ... but don't forget to save the vector index either. */
             _nc->vector_idx = _vi + 1;
+            _nc->stats.read_count++;
+            _nc->stats.read_bytes += _msg->len;
+            _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
             return _msg->len;
         }
 
@@ -194,24 +541,92 @@ int32_t can_read(NCODEC* nc, NCodecMessage* msg)
     }
     /* No messages in stream. */
     _nc->c.stream->seek(nc, 0, NCODEC_SEEK_END);
+    _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
     return -ENOMSG;
 }
 
 
-int32_t can_flush(NCODEC* nc)
+int32_t can_read_batch(NCODEC* nc, NCodecMessage* batch)
 {
-    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    ABCodecInstance*       _nc = (ABCodecInstance*)nc;
+    NCodecCanMessageBatch* _b = (NCodecCanMessageBatch*)batch;
     if (_nc == NULL) return -ENOSTR;
+    if (_b == NULL) return -EINVAL;
+    if (_b->frame_id == NULL || _b->buffer == NULL || _b->len == NULL) {
+        return -EINVAL;
+    }
     if (_nc->c.stream == NULL) return -ENOSR;
+    codec_sync_wait(_nc);
+
+    /* Reset the batch, in case caller ignores the return value. */
+    _b->count = 0;
+    if (_b->capacity == 0) return -EINVAL;
+    uint64_t t0 = codec_clock_ns(_nc);
+
+    /* Process the stream/frames, filling the batch arrays in one pass. */
+    if (_nc->msg_ptr == NULL) get_msg_from_stream(nc);
+    if (_nc->vector == NULL) get_vector_from_message(nc);
+    while (_nc->msg_ptr && _nc->vector) {
+        for (size_t _vi = _nc->vector_idx; _vi < _nc->vector_len; _vi++) {
+            ns(CanFrame_table_t) can_frame = get_can_frame(_nc, _vi);
+            if (can_frame == NULL) continue;
 
-    uint8_t* buffer = NULL;
-    size_t   length = 0;
+            /* Add the message to the batch. */
+            size_t                  i = _b->count++;
+            flatbuffers_uint8_vec_t payload = ns(CanFrame_payload(can_frame));
+            _b->frame_id[i] = ns(CanFrame_frame_id(can_frame));
+            _b->buffer[i] = (uint8_t*)payload;
+            _b->len[i] = flatbuffers_uint8_vec_len(payload);
+            _nc->stats.read_bytes += _b->len[i];
+            if (_b->frame_type) {
+                _b->frame_type[i] = ns(CanFrame_frame_type(can_frame));
+            }
+            if (_b->sender.bus_id) {
+                _b->sender.bus_id[i] = ns(CanFrame_bus_id(can_frame));
+            }
+            if (_b->sender.node_id) {
+                _b->sender.node_id[i] = ns(CanFrame_node_id(can_frame));
+            }
+            if (_b->sender.interface_id) {
+                _b->sender.interface_id[i] =
+                    ns(CanFrame_interface_id(can_frame));
+            }
+
+            /* Batch full, save the vector index for the next call. */
+            if (_b->count == _b->capacity) {
+                _nc->vector_idx = _vi + 1;
+                _nc->stats.read_count += _b->count;
+                _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
+                codec_trace_read_batch(_nc, _b);
+                return _b->count;
+            }
+        }
 
-    finalize_stream(_nc, &buffer, &length);
-    if (buffer) {
-        _nc->c.stream->write(nc, buffer, length);
-        free(buffer);
+        /* Next msg/vector? */
+        get_msg_from_stream(nc);
+        if (_nc->msg_ptr) get_vector_from_message(nc);
     }
+    /* No (more) messages in stream. */
+    _nc->c.stream->seek(nc, 0, NCODEC_SEEK_END);
+    _nc->stats.read_count += _b->count;
+    _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
+    codec_trace_read_batch(_nc, _b);
+    return _b->count ? (int32_t)_b->count : -ENOMSG;
+}
+
+
+int32_t can_flush(NCODEC* nc)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->fbs_reserved) return -EBUSY;
+
+    uint64_t t0 = codec_clock_ns(_nc);
+    coalesce_encode(_nc);
+    size_t length = finalize_stream(_nc);
+    _nc->stats.flush_count++;
+    _nc->stats.flush_ns += codec_clock_ns(_nc) - t0;
     return length;
 }
 
@@ -222,7 +637,10 @@ int32_t can_truncate(NCODEC* nc)
     if (_nc == NULL) return -ENOSTR;
     if (_nc->c.stream == NULL) return -ENOSR;
 
+    codec_sync_wait(_nc);
     reset_stream(_nc);
+    coalesce_clear(_nc);
+    codec_inflate_reset(_nc);
     _nc->c.stream->seek(nc, 0, NCODEC_SEEK_RESET);
 
     return 0;
@@ -0,0 +1,429 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <dse/ncodec/codec.h>
+#include <automotive-bus/codec.h>
+
+
+/* Raw CAN stream (schema=raw). Frames written during a step are appended, as
+   fixed size records, to a message buffer of the codec which is written to
+   the stream when flushed:
+
+       [size prefix][ABCodecRawHeader][ABCodecRawRecord] ... [ABCodecRawRecord]
+
+   The identifier of the header is at the same offset as the file identifier
+   of a FlatBuffers message, so each reader skips messages of the other
+   schema. Readers index the records directly (there is no decoding), the
+   payload of a read message references the record in the stream.
+*/
+
+#define RAW_HEADER_LEN (4 + sizeof(ABCodecRawHeader)) /* With size prefix. */
+#define RAW_RECORD_LEN sizeof(ABCodecRawRecord)
+#define RAW_RECORDS    16 /* Initial record capacity. */
+
+
+extern size_t   codec_flush_buffer(
+    ABCodecInstance* nc, uint8_t* buffer, size_t length);
+extern uint64_t codec_clock_ns(ABCodecInstance* nc);
+extern int32_t  codec_decompress(
+    ABCodecInstance* nc, uint8_t** msg_ptr, size_t* msg_len);
+extern void     codec_inflate_reset(ABCodecInstance* nc);
+extern void     codec_trace_write_batch(
+    ABCodecInstance* nc, NCodecMessage* msgs, size_t size, size_t count);
+extern void     codec_trace_read_batch(
+    ABCodecInstance* nc, NCodecCanMessageBatch* b);
+
+
+static void raw_clear(ABCodecInstance* nc)
+{
+    nc->raw.count = 0;
+    nc->raw.reserved = NULL;
+}
+
+
+static ABCodecRawRecord* raw_append(ABCodecInstance* nc)
+{
+    size_t len = RAW_HEADER_LEN + (nc->raw.count + 1) * RAW_RECORD_LEN;
+    if (len > nc->raw.buffer_len) {
+        size_t buffer_len = nc->raw.buffer_len;
+        if (buffer_len == 0) {
+            buffer_len = RAW_HEADER_LEN + RAW_RECORDS * RAW_RECORD_LEN;
+        }
+        while (buffer_len < len) {
+            buffer_len *= 2;
+        }
+        uint8_t* buffer =
+            ncodec_realloc((NCODEC*)nc, nc->raw.buffer, buffer_len);
+        if (buffer == NULL) return NULL;
+        nc->raw.buffer = buffer;
+        nc->raw.buffer_len = buffer_len;
+    }
+
+    uint8_t* record = nc->raw.buffer + RAW_HEADER_LEN;
+    record += nc->raw.count++ * RAW_RECORD_LEN;
+    return (ABCodecRawRecord*)record;
+}
+
+
+static void raw_encode(ABCodecInstance* nc, ABCodecRawRecord* record,
+    NCodecCanMessage* msg, size_t len)
+{
+    *record = (ABCodecRawRecord){
+        .frame_id = msg->frame_id,
+        .frame_type = msg->frame_type,
+        .bus_id = nc->bus_id,
+        .node_id = nc->node_id,
+        .interface_id = nc->interface_id,
+        .len = len,
+    };
+    if (msg->buffer && len) memcpy(record->payload, msg->buffer, len);
+}
+
+
+int32_t can_raw_write(NCODEC* nc, NCodecMessage* msg)
+{
+    ABCodecInstance*  _nc = (ABCodecInstance*)nc;
+    NCodecCanMessage* _msg = (NCodecCanMessage*)msg;
+    if (_nc == NULL) return -ENOSTR;
+    if (_msg == NULL) return -EINVAL;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->raw.reserved) return -EBUSY;
+    if (_msg->len > AB_CODEC_RAW_PAYLOAD_LEN) return -EMSGSIZE;
+
+    uint64_t          t0 = codec_clock_ns(_nc);
+    ABCodecRawRecord* record = raw_append(_nc);
+    if (record == NULL) return -ENOMEM;
+    raw_encode(_nc, record, _msg, _msg->len);
+
+    _nc->stats.write_count++;
+    _nc->stats.write_bytes += _msg->len;
+    _nc->stats.write_ns += codec_clock_ns(_nc) - t0;
+    return _msg->len;
+}
+
+
+int32_t can_raw_write_batch(NCODEC* nc, NCodecMessage* msgs, size_t count)
+{
+    ABCodecInstance*  _nc = (ABCodecInstance*)nc;
+    NCodecCanMessage* _msgs = (NCodecCanMessage*)msgs;
+    if (_nc == NULL) return -ENOSTR;
+    if (_msgs == NULL && count) return -EINVAL;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->raw.reserved) return -EBUSY;
+    if (count > INT32_MAX) return -EINVAL;
+    for (size_t i = 0; i < count; i++) {
+        if (_msgs[i].len > AB_CODEC_RAW_PAYLOAD_LEN) return -EMSGSIZE;
+    }
+
+    uint64_t t0 = codec_clock_ns(_nc);
+    for (size_t i = 0; i < count; i++) {
+        ABCodecRawRecord* record = raw_append(_nc);
+        if (record == NULL) return -ENOMEM;
+        raw_encode(_nc, record, &_msgs[i], _msgs[i].len);
+        _nc->stats.write_bytes += _msgs[i].len;
+    }
+
+    _nc->stats.write_count += count;
+    _nc->stats.write_ns += codec_clock_ns(_nc) - t0;
+    codec_trace_write_batch(_nc, _msgs, sizeof(*_msgs), count);
+    return (int32_t)count;
+}
+
+
+uint8_t* can_raw_write_reserve(NCODEC* nc, NCodecMessage* msg, size_t len)
+{
+    ABCodecInstance*  _nc = (ABCodecInstance*)nc;
+    NCodecCanMessage* _msg = (NCodecCanMessage*)msg;
+    if (_nc == NULL) {
+        errno = ENOSTR;
+        return NULL;
+    }
+    if (_msg == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (_nc->c.stream == NULL) {
+        errno = ENOSR;
+        return NULL;
+    }
+    if (_nc->raw.reserved) {
+        errno = EBUSY;
+        return NULL;
+    }
+    if (len > AB_CODEC_RAW_PAYLOAD_LEN) {
+        errno = EMSGSIZE;
+        return NULL;
+    }
+
+    /* The payload is reserved in the record, completed by commit. */
+    ABCodecRawRecord* record = raw_append(_nc);
+    if (record == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    raw_encode(_nc, record, &(NCodecCanMessage){ .frame_id = _msg->frame_id,
+                                .frame_type = _msg->frame_type },
+        len);
+    _nc->raw.reserved = record;
+    _nc->reserved_msg.can = *_msg;
+    _nc->reserved_msg.can.buffer = record->payload;
+    return record->payload;
+}
+
+
+int32_t can_raw_write_commit(NCODEC* nc, size_t len)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->raw.reserved == NULL) return -EINVAL;
+    if (len > _nc->raw.reserved->len) return -EINVAL;
+
+    _nc->raw.reserved->len = len;
+    _nc->raw.reserved = NULL;
+
+    _nc->stats.write_count++;
+    _nc->stats.write_bytes += len;
+    if (_nc->c.trace.write) {
+        _nc->reserved_msg.can.len = len;
+        _nc->c.trace.write(nc, &_nc->reserved_msg.can);
+    }
+    return (int32_t)len;
+}
+
+
+static void get_raw_msg_from_stream(NCODEC* nc)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+
+    /* Reset the message (and record) parsing state. */
+    _nc->msg_ptr = NULL;
+    _nc->msg_len = 0;
+    _nc->vector_idx = 0;
+    _nc->vector_len = 0;
+
+    /* Next message? Reading from the start of the stream (i.e. the stream
+       was rewound), release the messages decompressed by the previous pass. */
+    if (_nc->c.stream->tell && _nc->c.stream->tell(nc) == 0) {
+        codec_inflate_reset(_nc);
+    }
+    uint8_t* buffer;
+    size_t   length;
+    _nc->c.stream->read(nc, &buffer, &length, NCODEC_POS_NC);
+
+    uint8_t*       msg_ptr = buffer;
+    uint8_t* const buffer_ptr = buffer;
+    while ((size_t)(msg_ptr - buffer_ptr) + 4 <= length) {
+        /* Messages start with a size prefix. */
+        uint32_t msg_len;
+        memcpy(&msg_len, msg_ptr, 4);
+        msg_ptr += 4;
+        if (msg_len == 0) break;
+        if (msg_len > length - (size_t)(msg_ptr - buffer_ptr)) break;
+        /* Advance the stream pos (+4 for size prefix). */
+        _nc->c.stream->seek(nc, msg_len + 4, NCODEC_SEEK_CUR);
+        /* Set the parsing state (decompress if necessary). */
+        uint8_t* _msg_ptr = msg_ptr;
+        size_t   _msg_len = msg_len;
+        if (codec_decompress(_nc, &_msg_ptr, &_msg_len) == 0 &&
+            _msg_len >= sizeof(ABCodecRawHeader)) {
+            ABCodecRawHeader header;
+            memcpy(&header, _msg_ptr, sizeof(header));
+            if (memcmp(header.id, AB_CODEC_RAW_IDENTIFIER, 4) == 0 &&
+                header.version == AB_CODEC_RAW_VERSION &&
+                header.record_len >= RAW_RECORD_LEN &&
+                header.count <= (_msg_len - sizeof(header)) /
+                                    header.record_len) {
+                _nc->msg_ptr = _msg_ptr;
+                _nc->msg_len = _msg_len;
+                _nc->vector_len = header.count;
+                return;
+            }
+        }
+        /* Next message in the stream. */
+        msg_ptr += msg_len;
+    }
+
+    /* No message in stream. */
+    _nc->c.stream->seek(nc, 0, NCODEC_SEEK_END);
+}
+
+
+/* Record `index` of the current message, or NULL if filtered. The record
+   header is copied (records of a stream are not necessarily aligned). */
+static const uint8_t* get_raw_record(
+    ABCodecInstance* nc, size_t index, ABCodecRawRecord* record)
+{
+    uint16_t record_len;
+    memcpy(&record_len, nc->msg_ptr + offsetof(ABCodecRawHeader, record_len),
+        sizeof(record_len));
+    const uint8_t* _r =
+        nc->msg_ptr + sizeof(ABCodecRawHeader) + index * record_len;
+    memcpy(record, _r, offsetof(ABCodecRawRecord, payload));
+
+    /* Filter: sender==receiver. */
+    if ((nc->node_id) && (nc->node_id == record->node_id)) {
+        nc->stats.filter_count++;
+        return NULL;
+    }
+    if (record->len > AB_CODEC_RAW_PAYLOAD_LEN) return NULL;
+
+    return _r + offsetof(ABCodecRawRecord, payload);
+}
+
+
+int32_t can_raw_read(NCODEC* nc, NCodecMessage* msg)
+{
+    ABCodecInstance*  _nc = (ABCodecInstance*)nc;
+    NCodecCanMessage* _msg = (NCodecCanMessage*)msg;
+    if (_nc == NULL) return -ENOSTR;
+    if (_msg == NULL) return -EINVAL;
+    if (_nc->c.stream == NULL) return -ENOSR;
+
+    /* Reset the message, in case caller ignores the return value. */
+    _msg->len = 0;
+    _msg->frame_type = CAN_BASE_FRAME;
+    _msg->buffer = NULL;
+    uint64_t t0 = codec_clock_ns(_nc);
+
+    /* Process the stream/records. */
+    if (_nc->msg_ptr == NULL) get_raw_msg_from_stream(nc);
+    while (_nc->msg_ptr) {
+        for (size_t _ri = _nc->vector_idx; _ri < _nc->vector_len; _ri++) {
+            ABCodecRawRecord record;
+            const uint8_t*   payload = get_raw_record(_nc, _ri, &record);
+            if (payload == NULL) continue;
+
+            /* Return the message. */
+            _msg->frame_id = record.frame_id;
+            _msg->frame_type = record.frame_type;
+            _msg->buffer = (uint8_t*)payload;
+            _msg->len = record.len;
+            _msg->sender.bus_id = record.bus_id;
+            _msg->sender.node_id = record.node_id;
+            _msg->sender.interface_id = record.interface_id;
+
+            /* ... but don't forget to save the record index either. */
+            _nc->vector_idx = _ri + 1;
+            _nc->stats.read_count++;
+            _nc->stats.read_bytes += _msg->len;
+            _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
+            return _msg->len;
+        }
+
+        /* Next msg? */
+        get_raw_msg_from_stream(nc);
+    }
+    /* No messages in stream. */
+    _nc->c.stream->seek(nc, 0, NCODEC_SEEK_END);
+    _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
+    return -ENOMSG;
+}
+
+
+int32_t can_raw_read_batch(NCODEC* nc, NCodecMessage* batch)
+{
+    ABCodecInstance*       _nc = (ABCodecInstance*)nc;
+    NCodecCanMessageBatch* _b = (NCodecCanMessageBatch*)batch;
+    if (_nc == NULL) return -ENOSTR;
+    if (_b == NULL) return -EINVAL;
+    if (_b->frame_id == NULL || _b->buffer == NULL || _b->len == NULL) {
+        return -EINVAL;
+    }
+    if (_nc->c.stream == NULL) return -ENOSR;
+
+    /* Reset the batch, in case caller ignores the return value. */
+    _b->count = 0;
+    if (_b->capacity == 0) return -EINVAL;
+    uint64_t t0 = codec_clock_ns(_nc);
+
+    /* Process the stream/records, filling the batch arrays in one pass. */
+    if (_nc->msg_ptr == NULL) get_raw_msg_from_stream(nc);
+    while (_nc->msg_ptr) {
+        for (size_t _ri = _nc->vector_idx; _ri < _nc->vector_len; _ri++) {
+            ABCodecRawRecord record;
+            const uint8_t*   payload = get_raw_record(_nc, _ri, &record);
+            if (payload == NULL) continue;
+
+            /* Add the message to the batch. */
+            size_t i = _b->count++;
+            _b->frame_id[i] = record.frame_id;
+            _b->buffer[i] = (uint8_t*)payload;
+            _b->len[i] = record.len;
+            _nc->stats.read_bytes += record.len;
+            if (_b->frame_type) _b->frame_type[i] = record.frame_type;
+            if (_b->sender.bus_id) _b->sender.bus_id[i] = record.bus_id;
+            if (_b->sender.node_id) _b->sender.node_id[i] = record.node_id;
+            if (_b->sender.interface_id) {
+                _b->sender.interface_id[i] = record.interface_id;
+            }
+
+            /* Batch full, save the record index for the next call. */
+            if (_b->count == _b->capacity) {
+                _nc->vector_idx = _ri + 1;
+                _nc->stats.read_count += _b->count;
+                _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
+                codec_trace_read_batch(_nc, _b);
+                return _b->count;
+            }
+        }
+
+        /* Next msg? */
+        get_raw_msg_from_stream(nc);
+    }
+    /* No (more) messages in stream. */
+    _nc->c.stream->seek(nc, 0, NCODEC_SEEK_END);
+    _nc->stats.read_count += _b->count;
+    _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
+    codec_trace_read_batch(_nc, _b);
+    return _b->count ? (int32_t)_b->count : -ENOMSG;
+}
+
+
+int32_t can_raw_flush(NCODEC* nc)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->raw.reserved) return -EBUSY;
+    if (_nc->raw.count == 0) return 0;
+
+    /* Complete the size prefix and header, then write the message. */
+    uint64_t         t0 = codec_clock_ns(_nc);
+    size_t           length = RAW_HEADER_LEN + _nc->raw.count * RAW_RECORD_LEN;
+    uint32_t         msg_len = length - 4;
+    ABCodecRawHeader header = {
+        .count = _nc->raw.count,
+        .record_len = RAW_RECORD_LEN,
+        .version = AB_CODEC_RAW_VERSION,
+    };
+    memcpy(header.id, AB_CODEC_RAW_IDENTIFIER, 4);
+    memcpy(_nc->raw.buffer, &msg_len, 4);
+    memcpy(_nc->raw.buffer + 4, &header, sizeof(header));
+    length = codec_flush_buffer(_nc, _nc->raw.buffer, length);
+    raw_clear(_nc);
+
+    _nc->stats.flush_count++;
+    _nc->stats.flush_ns += codec_clock_ns(_nc) - t0;
+    return length;
+}
+
+
+int32_t can_raw_truncate(NCODEC* nc)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->c.stream == NULL) return -ENOSR;
+
+    raw_clear(_nc);
+    codec_inflate_reset(_nc);
+    _nc->c.stream->seek(nc, 0, NCODEC_SEEK_RESET);
+
+    return 0;
+}
@@ -0,0 +1,462 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <dse/ncodec/codec.h>
+#include <automotive-bus/codec.h>
+
+
+/* Columnar PDU stream (schema=columnar). PDUs written during a step are
+   appended to the columns (and payload blob) of the codec, which are
+   assembled into a message when flushed:
+
+       [size prefix][ABCodecColumnarHeader][id][swc_id][ecu_id][offset][blob]
+
+   Readers scan the id and swc_id columns (subscription and sender filters)
+   and only access the payload of a selected PDU, the returned payload
+   references the blob in the stream. Transport metadata is not encoded.
+*/
+
+#define COL_HEADER_LEN sizeof(ABCodecColumnarHeader)
+#define COL_COUNT      64  /* Initial column capacity. */
+#define COL_PAYLOAD    512 /* Initial payload blob capacity. */
+#define COL_ALIGN(x)   (((x) + 3) & ~(size_t)3)
+
+
+extern size_t   codec_flush_buffer(
+    ABCodecInstance* nc, uint8_t* buffer, size_t length);
+extern uint64_t codec_clock_ns(ABCodecInstance* nc);
+extern bool     codec_subscribed(
+    ABCodecInstance* nc, uint32_t id, uint32_t ecu_id, uint32_t swc_id);
+extern int32_t  codec_decompress(
+    ABCodecInstance* nc, uint8_t** msg_ptr, size_t* msg_len);
+extern void     codec_inflate_reset(ABCodecInstance* nc);
+extern void     codec_trace_write_batch(
+    ABCodecInstance* nc, NCodecMessage* msgs, size_t size, size_t count);
+
+
+static void columns_clear(ABCodecInstance* nc)
+{
+    nc->columns.count = 0;
+    nc->columns.payload_len = 0;
+    nc->columns.reserved = false;
+    nc->columns.reserved_len = 0;
+}
+
+
+static int32_t columns_extend(ABCodecInstance* nc, size_t payload_len)
+{
+    ABCodecColumns* c = &nc->columns;
+
+    /* Columns, each is reallocated (capacity is updated when all are). */
+    if (c->count + 1 > c->capacity) {
+        size_t     capacity = c->capacity ? c->capacity * 2 : COL_COUNT;
+        uint32_t** columns[] = { &c->id, &c->swc_id, &c->ecu_id, &c->offset };
+        for (size_t i = 0; i < sizeof(columns) / sizeof(columns[0]); i++) {
+            /* Offset has an additional entry (end of the last payload). */
+            size_t    len = (capacity + 1) * sizeof(uint32_t);
+            uint32_t* column = ncodec_realloc((NCODEC*)nc, *columns[i], len);
+            if (column == NULL) return -ENOMEM;
+            *columns[i] = column;
+        }
+        c->capacity = capacity;
+    }
+
+    /* Payload blob (allocated for empty payloads too). */
+    if (c->payload == NULL ||
+        c->payload_len + payload_len > c->payload_capacity) {
+        size_t capacity = c->payload_capacity;
+        if (capacity == 0) capacity = COL_PAYLOAD;
+        while (capacity < c->payload_len + payload_len) {
+            capacity *= 2;
+        }
+        uint8_t* payload = ncodec_realloc((NCODEC*)nc, c->payload, capacity);
+        if (payload == NULL) return -ENOMEM;
+        c->payload = payload;
+        c->payload_capacity = capacity;
+    }
+
+    return 0;
+}
+
+
+/* Append a PDU, the payload is copied if provided. Returns the payload
+   location in the blob, or NULL. */
+static uint8_t* columns_append(
+    ABCodecInstance* nc, NCodecPdu* pdu, const uint8_t* payload, size_t len)
+{
+    ABCodecColumns* c = &nc->columns;
+    if (len > UINT32_MAX - c->payload_len) return NULL;
+    if (columns_extend(nc, len)) return NULL;
+
+    size_t i = c->count++;
+    c->id[i] = pdu->id;
+    c->swc_id[i] = pdu->swc_id ? pdu->swc_id : nc->swc_id;
+    c->ecu_id[i] = pdu->ecu_id ? pdu->ecu_id : nc->ecu_id;
+    c->offset[i] = c->payload_len;
+    uint8_t* blob = c->payload + c->payload_len;
+    if (payload && len) memcpy(blob, payload, len);
+    c->payload_len += len;
+    return blob;
+}
+
+
+int32_t pdu_columnar_write(NCODEC* nc, NCodecMessage* msg)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    NCodecPdu*       _pdu = (NCodecPdu*)msg;
+    if (_nc == NULL) return -ENOSTR;
+    if (_pdu == NULL) return -EINVAL;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->columns.reserved) return -EBUSY;
+    if (_pdu->payload_len > INT32_MAX) return -EMSGSIZE;
+    if (_pdu->transport_type != NCodecPduTransportTypeNone) return -ENOTSUP;
+
+    uint64_t t0 = codec_clock_ns(_nc);
+    if (columns_append(_nc, _pdu, _pdu->payload, _pdu->payload_len) == NULL) {
+        return -ENOMEM;
+    }
+
+    _nc->stats.write_count++;
+    _nc->stats.write_bytes += _pdu->payload_len;
+    _nc->stats.write_ns += codec_clock_ns(_nc) - t0;
+    return _pdu->payload_len;
+}
+
+
+int32_t pdu_columnar_write_batch(
+    NCODEC* nc, NCodecMessage* msgs, size_t count)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    NCodecPdu*       _pdus = (NCodecPdu*)msgs;
+    if (_nc == NULL) return -ENOSTR;
+    if (_pdus == NULL && count) return -EINVAL;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->columns.reserved) return -EBUSY;
+    if (count > INT32_MAX) return -EINVAL;
+
+    /* On error, the PDUs already appended remain written. */
+    uint64_t t0 = codec_clock_ns(_nc);
+    int32_t  rc = 0;
+    size_t   i;
+    for (i = 0; i < count; i++) {
+        if (_pdus[i].payload_len > INT32_MAX) {
+            rc = -EMSGSIZE;
+            break;
+        }
+        if (_pdus[i].transport_type != NCodecPduTransportTypeNone) {
+            rc = -ENOTSUP;
+            break;
+        }
+        if (columns_append(_nc, &_pdus[i], _pdus[i].payload,
+                _pdus[i].payload_len) == NULL) {
+            rc = -ENOMEM;
+            break;
+        }
+        _nc->stats.write_bytes += _pdus[i].payload_len;
+    }
+
+    _nc->stats.write_count += i;
+    _nc->stats.write_ns += codec_clock_ns(_nc) - t0;
+    codec_trace_write_batch(_nc, _pdus, sizeof(*_pdus), i);
+    return i ? (int32_t)i : rc;
+}
+
+
+uint8_t* pdu_columnar_write_reserve(
+    NCODEC* nc, NCodecMessage* msg, size_t len)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    NCodecPdu*       _pdu = (NCodecPdu*)msg;
+    if (_nc == NULL) {
+        errno = ENOSTR;
+        return NULL;
+    }
+    if (_pdu == NULL || len > INT32_MAX) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (_nc->c.stream == NULL) {
+        errno = ENOSR;
+        return NULL;
+    }
+    if (_nc->columns.reserved) {
+        errno = EBUSY;
+        return NULL;
+    }
+    if (_pdu->transport_type != NCodecPduTransportTypeNone) {
+        errno = ENOTSUP;
+        return NULL;
+    }
+
+    /* Reserve the payload in the blob, completed by commit. */
+    uint8_t* payload = columns_append(_nc, _pdu, NULL, len);
+    if (payload == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    _nc->columns.reserved = true;
+    _nc->columns.reserved_len = len;
+    _nc->reserved_msg.pdu = *_pdu;
+    _nc->reserved_msg.pdu.payload = payload;
+    return payload;
+}
+
+
+int32_t pdu_columnar_write_commit(NCODEC* nc, size_t len)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->columns.reserved == false) return -EINVAL;
+    if (len > _nc->columns.reserved_len) return -EINVAL;
+
+    _nc->columns.payload_len -= _nc->columns.reserved_len - len;
+    _nc->columns.reserved = false;
+    _nc->columns.reserved_len = 0;
+
+    _nc->stats.write_count++;
+    _nc->stats.write_bytes += len;
+    if (_nc->c.trace.write) {
+        _nc->reserved_msg.pdu.payload_len = len;
+        _nc->c.trace.write(nc, &_nc->reserved_msg.pdu);
+    }
+    return (int32_t)len;
+}
+
+
+static inline uint32_t _column_at(const uint8_t* column, size_t index)
+{
+    uint32_t v;
+    memcpy(&v, column + index * sizeof(uint32_t), sizeof(v));
+    return v;
+}
+
+
+static void get_columns_from_stream(NCODEC* nc)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+
+    /* Reset the message (and column) parsing state. */
+    _nc->msg_ptr = NULL;
+    _nc->msg_len = 0;
+    _nc->vector_idx = 0;
+    _nc->vector_len = 0;
+
+    /* Next message? Reading from the start of the stream (i.e. the stream
+       was rewound), release the messages decompressed by the previous pass. */
+    if (_nc->c.stream->tell && _nc->c.stream->tell(nc) == 0) {
+        codec_inflate_reset(_nc);
+    }
+    uint8_t* buffer;
+    size_t   length;
+    _nc->c.stream->read(nc, &buffer, &length, NCODEC_POS_NC);
+
+    uint8_t*       msg_ptr = buffer;
+    uint8_t* const buffer_ptr = buffer;
+    while ((size_t)(msg_ptr - buffer_ptr) + 4 <= length) {
+        /* Messages start with a size prefix. */
+        uint32_t msg_len;
+        memcpy(&msg_len, msg_ptr, 4);
+        msg_ptr += 4;
+        if (msg_len == 0) break;
+        if (msg_len > length - (size_t)(msg_ptr - buffer_ptr)) break;
+        /* Advance the stream pos (+4 for size prefix). */
+        _nc->c.stream->seek(nc, msg_len + 4, NCODEC_SEEK_CUR);
+        /* Set the parsing state (decompress if necessary). */
+        uint8_t* _msg_ptr = msg_ptr;
+        size_t   _msg_len = msg_len;
+        if (codec_decompress(_nc, &_msg_ptr, &_msg_len) == 0 &&
+            _msg_len >= COL_HEADER_LEN) {
+            ABCodecColumnarHeader header;
+            memcpy(&header, _msg_ptr, sizeof(header));
+            size_t count = header.count;
+            size_t columns_len =
+                COL_HEADER_LEN + (count * 4 + 1) * sizeof(uint32_t);
+            if (memcmp(header.id, AB_CODEC_COLUMNAR_IDENTIFIER, 4) == 0 &&
+                count <= _msg_len / 16 &&
+                columns_len + header.payload_len <= _msg_len) {
+                _nc->msg_ptr = _msg_ptr;
+                _nc->msg_len = _msg_len;
+                _nc->vector_len = header.count;
+                return;
+            }
+        }
+        /* Next message in the stream. */
+        msg_ptr += msg_len;
+    }
+
+    /* No message in stream. */
+    _nc->c.stream->seek(nc, 0, NCODEC_SEEK_END);
+}
+
+
+/* Scan the columns of the current message, from vector_idx, for the next
+   PDU which is not filtered. Returns the PDU index, or vector_len. */
+static size_t columns_scan(ABCodecInstance* nc)
+{
+    size_t         count = nc->vector_len;
+    const uint8_t* id = nc->msg_ptr + COL_HEADER_LEN;
+    const uint8_t* swc_id = id + count * sizeof(uint32_t);
+    const uint8_t* ecu_id = swc_id + count * sizeof(uint32_t);
+
+    size_t i = nc->vector_idx;
+    if (nc->subscription.count == 0) {
+        /* Filter: sender==receiver (only). */
+        if (nc->swc_id == 0) return i;
+        while (i < count && _column_at(swc_id, i) == nc->swc_id) {
+            nc->stats.filter_count++;
+            i++;
+        }
+        return i;
+    }
+    for (; i < count; i++) {
+        /* Filter: subscription. */
+        if (!codec_subscribed(nc, _column_at(id, i), _column_at(ecu_id, i),
+                _column_at(swc_id, i))) {
+            nc->stats.filter_count++;
+            continue;
+        }
+        /* Filter: sender==receiver. */
+        if ((nc->swc_id) && (nc->swc_id == _column_at(swc_id, i))) {
+            nc->stats.filter_count++;
+            continue;
+        }
+        break;
+    }
+    return i;
+}
+
+
+int32_t pdu_columnar_read(NCODEC* nc, NCodecMessage* msg)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    NCodecPdu*       _pdu = (NCodecPdu*)msg;
+    if (_nc == NULL) return -ENOSTR;
+    if (_pdu == NULL) return -EINVAL;
+    if (_nc->c.stream == NULL) return -ENOSR;
+
+    /* Reset the message, in case caller ignores the return value. */
+    _pdu->payload_len = 0;
+    _pdu->payload = NULL;
+    uint64_t t0 = codec_clock_ns(_nc);
+
+    /* Process the stream/columns. */
+    if (_nc->msg_ptr == NULL) get_columns_from_stream(nc);
+    while (_nc->msg_ptr) {
+        size_t i;
+        while ((i = columns_scan(_nc)) < _nc->vector_len) {
+            size_t         count = _nc->vector_len;
+            const uint8_t* id = _nc->msg_ptr + COL_HEADER_LEN;
+            const uint8_t* swc_id = id + count * sizeof(uint32_t);
+            const uint8_t* ecu_id = swc_id + count * sizeof(uint32_t);
+            const uint8_t* offset = ecu_id + count * sizeof(uint32_t);
+            const uint8_t* blob = offset + (count + 1) * sizeof(uint32_t);
+            _nc->vector_idx = i + 1;
+
+            /* Check the payload is within the blob. */
+            uint32_t payload_len;
+            memcpy(&payload_len,
+                _nc->msg_ptr + offsetof(ABCodecColumnarHeader, payload_len),
+                sizeof(payload_len));
+            uint32_t start = _column_at(offset, i);
+            uint32_t end = _column_at(offset, i + 1);
+            if (start > end || end > payload_len) continue;
+
+            /* Return the message. */
+            _pdu->id = _column_at(id, i);
+            _pdu->payload = blob + start;
+            _pdu->payload_len = end - start;
+            _pdu->swc_id = _column_at(swc_id, i);
+            _pdu->ecu_id = _column_at(ecu_id, i);
+            _pdu->transport_type = NCodecPduTransportTypeNone;
+
+            _nc->stats.read_count++;
+            _nc->stats.read_bytes += _pdu->payload_len;
+            _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
+            return _pdu->payload_len;
+        }
+
+        /* Next msg? */
+        get_columns_from_stream(nc);
+    }
+    /* No messages in stream. */
+    _nc->c.stream->seek(nc, 0, NCODEC_SEEK_END);
+    _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
+    return -ENOMSG;
+}
+
+
+int32_t pdu_columnar_flush(NCODEC* nc)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->columns.reserved) return -EBUSY;
+
+    ABCodecColumns* c = &_nc->columns;
+    if (c->count == 0) return 0;
+
+    /* Assemble the message (size prefix, header, columns and blob). */
+    uint64_t t0 = codec_clock_ns(_nc);
+    size_t   column_len = c->count * sizeof(uint32_t);
+    size_t   length = 4 + COL_HEADER_LEN + column_len * 4 + sizeof(uint32_t) +
+                    COL_ALIGN(c->payload_len);
+    if (length - 4 > UINT32_MAX) return -EMSGSIZE;
+    if (length > c->buffer_len) {
+        uint8_t* buffer = ncodec_realloc((NCODEC*)nc, c->buffer, length);
+        if (buffer == NULL) return -ENOMEM;
+        c->buffer = buffer;
+        c->buffer_len = length;
+    }
+    c->offset[c->count] = c->payload_len;
+
+    uint32_t              msg_len = length - 4;
+    ABCodecColumnarHeader header = {
+        .count = c->count,
+        .version = AB_CODEC_COLUMNAR_VERSION,
+        .payload_len = c->payload_len,
+    };
+    memcpy(header.id, AB_CODEC_COLUMNAR_IDENTIFIER, 4);
+    uint8_t* p = c->buffer;
+    memcpy(p, &msg_len, 4);
+    p += 4;
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, c->id, column_len);
+    p += column_len;
+    memcpy(p, c->swc_id, column_len);
+    p += column_len;
+    memcpy(p, c->ecu_id, column_len);
+    p += column_len;
+    memcpy(p, c->offset, column_len + sizeof(uint32_t));
+    p += column_len + sizeof(uint32_t);
+    memcpy(p, c->payload, c->payload_len);
+    memset(p + c->payload_len, 0, COL_ALIGN(c->payload_len) - c->payload_len);
+
+    length = codec_flush_buffer(_nc, c->buffer, length);
+    columns_clear(_nc);
+
+    _nc->stats.flush_count++;
+    _nc->stats.flush_ns += codec_clock_ns(_nc) - t0;
+    return length;
+}
+
+
+int32_t pdu_columnar_truncate(NCODEC* nc)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->c.stream == NULL) return -ENOSR;
+
+    columns_clear(_nc);
+    codec_inflate_reset(_nc);
+    _nc->c.stream->seek(nc, 0, NCODEC_SEEK_RESET);
+
+    return 0;
+}
@@ -14,11 +14,25 @@
 #define ns(x) FLATBUFFERS_WRAP_NAMESPACE(AutomotiveBus_Stream_Pdu, x)
 
 
+extern size_t   codec_flush_builder(ABCodecInstance* nc, flatcc_builder_t* B);
+extern uint64_t codec_clock_ns(ABCodecInstance* nc);
+extern int32_t  codec_flush_async(
+    ABCodecInstance* nc, void (*end_stream)(flatcc_builder_t* B));
+extern void     codec_sync_wait(ABCodecInstance* nc);
+extern bool     codec_subscribed(
+    ABCodecInstance* nc, uint32_t id, uint32_t ecu_id, uint32_t swc_id);
+extern int32_t  codec_decompress(
+    ABCodecInstance* nc, uint8_t** msg_ptr, size_t* msg_len);
+extern void     codec_inflate_reset(ABCodecInstance* nc);
+extern void     codec_trace_write_batch(
+    ABCodecInstance* nc, NCodecMessage* msgs, size_t size, size_t count);
+
+
 static void initialize_stream(ABCodecInstance* nc)
 {
     if (nc->fbs_stream_initalized) return;
 
-    flatcc_builder_t* B = &nc->fbs_builder;
+    flatcc_builder_t* B = nc->fbs_builder;
     flatcc_builder_reset(B);
     ns(Stream_start_as_root_with_size(B));
     ns(Stream_pdus_start(B));
@@ -30,26 +44,37 @@ static void reset_stream(ABCodecInstance* nc)
 {
     if (nc->fbs_stream_initalized == false) return;
 
-    flatcc_builder_t* B = &nc->fbs_builder;
+    flatcc_builder_t* B = nc->fbs_builder;
     flatcc_builder_reset(B);
     nc->fbs_stream_initalized = false;
+    nc->fbs_reserved = false;
+    nc->fbs_reserved_len = 0;
 }
 
 
-static void finalize_stream(
-    ABCodecInstance* nc, uint8_t** buffer, size_t* length)
+static void end_stream(flatcc_builder_t* B)
 {
-    if (nc->fbs_stream_initalized == false) {
-        *buffer = NULL;
-        *length = 0;
-        return;
-    }
-
-    flatcc_builder_t* B = &nc->fbs_builder;
     ns(Stream_pdus_end(B));
     ns(Stream_end_as_root(B));
-    *buffer = flatcc_builder_finalize_buffer(B, length);
+}
+
+
+static size_t finalize_stream(ABCodecInstance* nc)
+{
+    if (nc->fbs_stream_initalized == false) return 0;
+
+    /* Asynchronous, the builder is ended and copied by the worker. */
+    if (nc->flush_async && codec_flush_async(nc, end_stream) == 0) {
+        nc->fbs_stream_initalized = false;
+        return 0;
+    }
+
+    flatcc_builder_t* B = nc->fbs_builder;
+    codec_sync_wait(nc);
+    end_stream(B);
+    size_t length = codec_flush_builder(nc, B);
     reset_stream(nc);
+    return length;
 }
 
 
@@ -204,19 +229,11 @@ static uint32_t _emit_struct_metadata(flatcc_builder_t* B, NCodecPdu* _pdu)
 }
 
 
-int32_t pdu_write(NCODEC* nc, NCodecPdu* pdu)
+static void encode_pdu_start(ABCodecInstance* nc, NCodecPdu* _pdu)
 {
-    ABCodecInstance* _nc = (ABCodecInstance*)nc;
-    NCodecPdu*       _pdu = (NCodecPdu*)pdu;
-    if (_nc == NULL) return -ENOSTR;
-    if (_pdu == NULL) return -EINVAL;
-    if (_nc->c.stream == NULL) return -ENOSR;
-
-    uint32_t swc_id = _pdu->swc_id ? _pdu->swc_id : _nc->swc_id;
-    uint32_t ecu_id = _pdu->ecu_id ? _pdu->ecu_id : _nc->ecu_id;
-
-    flatcc_builder_t* B = &_nc->fbs_builder;
-    initialize_stream(_nc);
+    flatcc_builder_t* B = nc->fbs_builder;
+    uint32_t          swc_id = _pdu->swc_id ? _pdu->swc_id : nc->swc_id;
+    uint32_t          ecu_id = _pdu->ecu_id ? _pdu->ecu_id : nc->ecu_id;
     ns(CanMessageMetadata_ref_t) can_message_metadata = 0;
     ns(IpMessageMetadata_ref_t) ip_message_metadata = 0;
     ns(StructMetadata_ref_t) struct_metadata = 0;
@@ -237,11 +254,9 @@ int32_t pdu_write(NCODEC* nc, NCodecPdu* pdu)
         break;
     }
 
-    // PDU Table
-    ns(Stream_pdus_push_start(B));
+    // PDU Table (payload is added by the caller)
+    ns(Pdu_start(B));
     ns(Pdu_id_add(B, _pdu->id));
-    ns(Pdu_payload_add(
-        B, flatbuffers_uint8_vec_create(B, _pdu->payload, _pdu->payload_len)));
     ns(Pdu_swc_id_add(B, swc_id));
     ns(Pdu_ecu_id_add(B, ecu_id));
     if (can_message_metadata) {
@@ -251,12 +266,138 @@ int32_t pdu_write(NCODEC* nc, NCodecPdu* pdu)
     } else if (struct_metadata) {
         ns(Pdu_transport_Struct_add(B, struct_metadata));
     }
-    ns(Stream_pdus_push_end(B));
+}
 
+
+static ns(Pdu_ref_t) encode_pdu(ABCodecInstance* nc, NCodecPdu* _pdu)
+{
+    flatcc_builder_t* B = nc->fbs_builder;
+
+    encode_pdu_start(nc, _pdu);
+    ns(Pdu_payload_add(
+        B, flatbuffers_uint8_vec_create(B, _pdu->payload, _pdu->payload_len)));
+    return ns(Pdu_end(B));
+}
+
+
+int32_t pdu_write(NCODEC* nc, NCodecPdu* pdu)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    NCodecPdu*       _pdu = (NCodecPdu*)pdu;
+    if (_nc == NULL) return -ENOSTR;
+    if (_pdu == NULL) return -EINVAL;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->fbs_reserved) return -EBUSY;
+
+    flatcc_builder_t* B = _nc->fbs_builder;
+    uint64_t          t0 = codec_clock_ns(_nc);
+    initialize_stream(_nc);
+    ns(Stream_pdus_push(B, encode_pdu(_nc, _pdu)));
+
+    _nc->stats.write_count++;
+    _nc->stats.write_bytes += _pdu->payload_len;
+    _nc->stats.write_ns += codec_clock_ns(_nc) - t0;
     return _pdu->payload_len;
 }
 
 
+int32_t pdu_write_batch(NCODEC* nc, NCodecPdu* pdus, size_t count)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    NCodecPdu*       _pdus = (NCodecPdu*)pdus;
+    if (_nc == NULL) return -ENOSTR;
+    if (_pdus == NULL && count) return -EINVAL;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->fbs_reserved) return -EBUSY;
+    if (count > INT32_MAX) return -EINVAL;
+    if (count == 0) return 0;
+
+    flatcc_builder_t* B = _nc->fbs_builder;
+    uint64_t          t0 = codec_clock_ns(_nc);
+    initialize_stream(_nc);
+    /* Reserve the vector slots for all PDUs, then encode each PDU and
+       set its reference (via the current base pointer of the vector). */
+    size_t base = ns(Stream_pdus_reserved_len(B));
+    if (ns(Stream_pdus_extend(B, count)) == NULL) return -ENOMEM;
+    for (size_t i = 0; i < count; i++) {
+        ns(Pdu_ref_t) ref = encode_pdu(_nc, &_pdus[i]);
+        ns(Stream_pdus_edit(B))[base + i] = ref;
+        _nc->stats.write_bytes += _pdus[i].payload_len;
+    }
+
+    _nc->stats.write_count += count;
+    _nc->stats.write_ns += codec_clock_ns(_nc) - t0;
+    codec_trace_write_batch(_nc, _pdus, sizeof(*_pdus), count);
+    return (int32_t)count;
+}
+
+
+uint8_t* pdu_write_reserve(NCODEC* nc, NCodecPdu* pdu, size_t len)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    NCodecPdu*       _pdu = (NCodecPdu*)pdu;
+    if (_nc == NULL) {
+        errno = ENOSTR;
+        return NULL;
+    }
+    if (_pdu == NULL || len > INT32_MAX) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (_nc->c.stream == NULL) {
+        errno = ENOSR;
+        return NULL;
+    }
+    if (_nc->fbs_reserved) {
+        errno = EBUSY;
+        return NULL;
+    }
+
+    flatcc_builder_t* B = _nc->fbs_builder;
+    initialize_stream(_nc);
+    encode_pdu_start(_nc, _pdu);
+    /* Reserve the payload, the PDU is completed by pdu_write_commit(). */
+    ns(Pdu_payload_start(B));
+    uint8_t* payload = ns(Pdu_payload_extend(B, len));
+    if (payload == NULL) {
+        reset_stream(_nc);
+        errno = ENOMEM;
+        return NULL;
+    }
+    _nc->fbs_reserved = true;
+    _nc->fbs_reserved_len = len;
+    _nc->reserved_msg.pdu = *_pdu;
+    _nc->reserved_msg.pdu.payload = payload;
+
+    return payload;
+}
+
+
+int32_t pdu_write_commit(NCODEC* nc, size_t len)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->fbs_reserved == false) return -EINVAL;
+    if (len > _nc->fbs_reserved_len) return -EINVAL;
+
+    flatcc_builder_t* B = _nc->fbs_builder;
+    ns(Pdu_payload_truncate(B, _nc->fbs_reserved_len - len));
+    ns(Pdu_payload_end(B));
+    ns(Stream_pdus_push(B, ns(Pdu_end(B))));
+    _nc->fbs_reserved = false;
+    _nc->fbs_reserved_len = 0;
+
+    _nc->stats.write_count++;
+    _nc->stats.write_bytes += len;
+    if (_nc->c.trace.write) {
+        _nc->reserved_msg.pdu.payload_len = len;
+        _nc->c.trace.write(nc, &_nc->reserved_msg.pdu);
+    }
+    return (int32_t)len;
+}
+
+
 static void _decode_can_message_metadata(ns(Pdu_table_t) pdu, NCodecPdu* _pdu)
 {
     NCodecPduCanMessageMetadata* can = &_pdu->transport.can_message;
@@ -387,6 +528,22 @@ static void _decode_struct_metadata(ns(Pdu_table_t) pdu, NCodecPdu* _pdu)
 }
 
 
+static void _decode_transport(ns(Pdu_table_t) pdu, NCodecPdu* _pdu)
+{
+    if (ns(Pdu_transport_is_present(pdu)) == false) return;
+
+    ns(TransportMetadata_union_type_t) transport_type =
+        ns(Pdu_transport_type(pdu));
+    if (transport_type == ns(TransportMetadata_Can)) {
+        _decode_can_message_metadata(pdu, _pdu);
+    } else if (transport_type == ns(TransportMetadata_Ip)) {
+        _decode_ip_message_metadata(pdu, _pdu);
+    } else if (transport_type == ns(TransportMetadata_Struct)) {
+        _decode_struct_metadata(pdu, _pdu);
+    }
+}
+
+
 static void get_stream_from_buffer(NCODEC* nc)
 {
     ABCodecInstance* _nc = (ABCodecInstance*)nc;
@@ -398,7 +555,11 @@ static void get_stream_from_buffer(NCODEC* nc)
     _nc->vector_idx = 0;
     _nc->vector_len = 0;
 
-    /* Next message? */
+    /* Next message? Reading from the start of the stream (i.e. the stream
+       was rewound), release the messages decompressed by the previous pass. */
+    if (_nc->c.stream->tell && _nc->c.stream->tell(nc) == 0) {
+        codec_inflate_reset(_nc);
+    }
     uint8_t* buffer;
     size_t   length;
     _nc->c.stream->read(nc, &buffer, &length, NCODEC_POS_NC);
@@ -412,10 +573,13 @@ static void get_stream_from_buffer(NCODEC* nc)
         if (msg_len == 0) break;
         /* Advance the stream pos (+4 for size prefix). */
         _nc->c.stream->seek(nc, msg_len + 4, NCODEC_SEEK_CUR);
-        /* Set the parsing state. */
-        if (flatbuffers_has_identifier(msg_ptr, flatbuffers_identifier)) {
-            _nc->msg_ptr = msg_ptr;
-            _nc->msg_len = msg_len;
+        /* Set the parsing state (decompress if necessary). */
+        uint8_t* _msg_ptr = msg_ptr;
+        size_t   _msg_len = msg_len;
+        if (codec_decompress(_nc, &_msg_ptr, &_msg_len) == 0 &&
+            flatbuffers_has_identifier(_msg_ptr, flatbuffers_identifier)) {
+            _nc->msg_ptr = _msg_ptr;
+            _nc->msg_len = _msg_len;
             return;
         }
         /* Next message in the stream. */
@@ -451,10 +615,13 @@ int32_t pdu_read(NCODEC* nc, NCodecPdu* pdu)
     if (_nc == NULL) return -ENOSTR;
     if (_pdu == NULL) return -EINVAL;
     if (_nc->c.stream == NULL) return -ENOSR;
+    codec_sync_wait(_nc);
 
     /* Reset the message, in case caller ignores the return value. */
     _pdu->payload_len = 0;
     _pdu->payload = NULL;
+    _nc->pdu_table = NULL;
+    uint64_t t0 = codec_clock_ns(_nc);
 
     /* Process the stream/frames. */
     if (_nc->msg_ptr == NULL) get_stream_from_buffer(nc);
@@ -463,8 +630,19 @@ int32_t pdu_read(NCODEC* nc, NCodecPdu* pdu)
         for (uint32_t _vi = _nc->vector_idx; _vi < _nc->vector_len; _vi++) {
             ns(Pdu_table_t) pdu = ns(Pdu_vec_at(_nc->vector, _vi));
 
+            /* Filter: subscription (before any decode). */
+            if (_nc->subscription.count &&
+                !codec_subscribed(_nc, ns(Pdu_id(pdu)), ns(Pdu_ecu_id(pdu)),
+                    ns(Pdu_swc_id(pdu)))) {
+                _nc->stats.filter_count++;
+                continue;
+            }
+
             /* Filter: sender==receiver. */
-            if ((_nc->swc_id) && (_nc->swc_id == ns(Pdu_swc_id(pdu)))) continue;
+            if ((_nc->swc_id) && (_nc->swc_id == ns(Pdu_swc_id(pdu)))) {
+                _nc->stats.filter_count++;
+                continue;
+            }
 
             /* Return the message. */
             _pdu->id = ns(Pdu_id(pdu));
@@ -473,21 +651,20 @@ int32_t pdu_read(NCODEC* nc, NCodecPdu* pdu)
             _pdu->payload_len = flatbuffers_uint8_vec_len(payload);
             _pdu->swc_id = ns(Pdu_swc_id(pdu));
             _pdu->ecu_id = ns(Pdu_ecu_id(pdu));
+            _nc->pdu_table = pdu;
 
-            if (ns(Pdu_transport_is_present(pdu))) {
-                ns(TransportMetadata_union_type_t) transport_type =
-                    ns(Pdu_transport_type(pdu));
-                if (transport_type == ns(TransportMetadata_Can)) {
-                    _decode_can_message_metadata(pdu, _pdu);
-                } else if (transport_type == ns(TransportMetadata_Ip)) {
-                    _decode_ip_message_metadata(pdu, _pdu);
-                } else if (transport_type == ns(TransportMetadata_Struct)) {
-                    _decode_struct_metadata(pdu, _pdu);
-                }
+            /* Transport metadata, unless decoded on demand. */
+            if (_nc->metadata_lazy) {
+                _pdu->transport_type = NCodecPduTransportTypeNone;
+            } else {
+                _decode_transport(pdu, _pdu);
             }
 
             /* ... but don't forget to save the vector index either. */
             _nc->vector_idx = _vi + 1;
+            _nc->stats.read_count++;
+            _nc->stats.read_bytes += _pdu->payload_len;
+            _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
             return _pdu->payload_len;
         }
 
@@ -497,6 +674,7 @@ int32_t pdu_read(NCODEC* nc, NCodecPdu* pdu)
     }
     /* No messages in stream. */
     _nc->c.stream->seek(nc, 0, NCODEC_SEEK_END);
+    _nc->stats.read_ns += codec_clock_ns(_nc) - t0;
     return -ENOMSG;
 }
 
@@ -506,15 +684,12 @@ int32_t pdu_flush(NCODEC* nc)
     ABCodecInstance* _nc = (ABCodecInstance*)nc;
     if (_nc == NULL) return -ENOSTR;
     if (_nc->c.stream == NULL) return -ENOSR;
+    if (_nc->fbs_reserved) return -EBUSY;
 
-    uint8_t* buffer = NULL;
-    size_t   length = 0;
-
-    finalize_stream(_nc, &buffer, &length);
-    if (buffer) {
-        _nc->c.stream->write(nc, buffer, length);
-        free(buffer);
-    }
+    uint64_t t0 = codec_clock_ns(_nc);
+    size_t   length = finalize_stream(_nc);
+    _nc->stats.flush_count++;
+    _nc->stats.flush_ns += codec_clock_ns(_nc) - t0;
     return length;
 }
 
@@ -525,8 +700,25 @@ int32_t pdu_truncate(NCODEC* nc)
     if (_nc == NULL) return -ENOSTR;
     if (_nc->c.stream == NULL) return -ENOSR;
 
+    codec_sync_wait(_nc);
     reset_stream(_nc);
+    _nc->pdu_table = NULL;
+    codec_inflate_reset(_nc);
     _nc->c.stream->seek(nc, 0, NCODEC_SEEK_RESET);
 
     return 0;
 }
+
+
+int32_t pdu_transport(NCODEC* nc, NCodecPdu* pdu)
+{
+    ABCodecInstance* _nc = (ABCodecInstance*)nc;
+    NCodecPdu*       _pdu = (NCodecPdu*)pdu;
+    if (_nc == NULL) return -ENOSTR;
+    if (_pdu == NULL) return -EINVAL;
+    if (_nc->pdu_table == NULL) return -ENOMSG;
+
+    _pdu->transport_type = NCodecPduTransportTypeNone;
+    _decode_transport(_nc->pdu_table, _pdu);
+    return 0;
+}
@@ -6,7 +6,11 @@
 
 extern int run_codec_tests(void);
 extern int run_can_fbs_tests(void);
+extern int run_can_raw_tests(void);
 extern int run_pdu_fbs_tests(void);
+extern int run_pdu_columnar_tests(void);
+extern int run_trace_tests(void);
+extern int run_record_tests(void);
 
 
 int main()
@@ -14,6 +18,10 @@ int main()
     int rc = 0;
     rc |= run_codec_tests();
     rc |= run_can_fbs_tests();
+    rc |= run_can_raw_tests();
     rc |= run_pdu_fbs_tests();
+    rc |= run_pdu_columnar_tests();
+    rc |= run_trace_tests();
+    rc |= run_record_tests();
     return rc;
 }
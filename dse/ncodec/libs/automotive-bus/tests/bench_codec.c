@@ -0,0 +1,532 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dse/ncodec/codec.h>
+
+
+/* Microbenchmark of the codec hot paths (write/flush/read) for CAN (schema
+   fbs and raw) and PDU (schema fbs and columnar) streams. Each configuration
+   runs a number of simulation steps, where a step is: truncate, write N
+   messages, flush, seek and read until -ENOMSG.
+
+   Usage: bench_codec [CSV file] [steps]
+*/
+
+
+#define UNUSED(x)       ((void)x)
+#define CSV_FILE        "bench_codec.csv"
+#define STEPS           2000
+#define WARMUP_STEPS    100
+#define STREAM_LEN      4096
+#define SWC_ID_SELF     4
+#define SWC_ID_OTHER    6
+#define ARRAY_SIZE(x)   (sizeof(x) / sizeof(x[0]))
+
+#define MIMETYPE_CAN_SELF                                                      \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=fbs;"                          \
+    "bus_id=1;node_id=2;interface_id=3"
+#define MIMETYPE_CAN_OTHER                                                     \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=fbs;"                          \
+    "bus_id=1;node_id=3;interface_id=3"
+#define MIMETYPE_CAN_RAW_SELF                                                  \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=raw;"                          \
+    "bus_id=1;node_id=2;interface_id=3"
+#define MIMETYPE_CAN_RAW_OTHER                                                 \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=raw;"                          \
+    "bus_id=1;node_id=3;interface_id=3"
+#define MIMETYPE_PDU                                                           \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=pdu;schema=fbs;"                                    \
+    "swc_id=4;ecu_id=5"
+#define MIMETYPE_PDU_COLUMNAR                                                  \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=pdu;schema=columnar;"                               \
+    "swc_id=4;ecu_id=5"
+
+
+/* Growable memory stream, shared by the writing and reading codecs. */
+typedef struct BenchStream {
+    NCodecStreamVTable s;
+    uint8_t*           buffer;
+    size_t             buffer_len;
+    size_t             len;
+    size_t             pos;
+} BenchStream;
+
+
+static BenchStream* _stream(NCODEC* nc)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) return NULL;
+    return (BenchStream*)_nc->stream;
+}
+
+
+static int32_t _stream_extend(BenchStream* _s, size_t len)
+{
+    if (len <= _s->buffer_len) return 0;
+    size_t buffer_len = _s->buffer_len ? _s->buffer_len : STREAM_LEN;
+    while (buffer_len < len) {
+        buffer_len *= 2;
+    }
+    uint8_t* buffer = realloc(_s->buffer, buffer_len);
+    if (buffer == NULL) return -ENOMEM;
+    _s->buffer = buffer;
+    _s->buffer_len = buffer_len;
+    return 0;
+}
+
+
+static size_t stream_read(
+    NCODEC* nc, uint8_t** data, size_t* len, int32_t pos_op)
+{
+    BenchStream* _s = _stream(nc);
+    if (_s == NULL) return -ENOSTR;
+    if (data == NULL || len == NULL) return -EINVAL;
+
+    if (_s->pos >= _s->len) {
+        *data = NULL;
+        *len = 0;
+        return 0;
+    }
+    *data = &_s->buffer[_s->pos];
+    *len = _s->len - _s->pos;
+    if (pos_op == NCODEC_POS_UPDATE) _s->pos = _s->len;
+    return *len;
+}
+
+
+static size_t stream_write(NCODEC* nc, uint8_t* data, size_t len)
+{
+    BenchStream* _s = _stream(nc);
+    if (_s == NULL) return -ENOSTR;
+    if (_stream_extend(_s, _s->pos + len)) return -EMSGSIZE;
+
+    memcpy(&_s->buffer[_s->pos], data, len);
+    _s->pos += len;
+    if (_s->pos > _s->len) _s->len = _s->pos;
+    return len;
+}
+
+
+static uint8_t* stream_reserve(NCODEC* nc, size_t len)
+{
+    BenchStream* _s = _stream(nc);
+    if (_s == NULL) return NULL;
+    if (_stream_extend(_s, _s->pos + len)) return NULL;
+    return &_s->buffer[_s->pos];
+}
+
+
+static int32_t stream_commit(NCODEC* nc, size_t len)
+{
+    BenchStream* _s = _stream(nc);
+    if (_s == NULL) return -ENOSTR;
+    if (_s->pos + len > _s->buffer_len) return -EMSGSIZE;
+
+    _s->pos += len;
+    if (_s->pos > _s->len) _s->len = _s->pos;
+    return len;
+}
+
+
+static int64_t stream_seek(NCODEC* nc, size_t pos, int32_t op)
+{
+    BenchStream* _s = _stream(nc);
+    if (_s == NULL) return -ENOSTR;
+
+    if (op == NCODEC_SEEK_SET) {
+        _s->pos = (pos > _s->len) ? _s->len : pos;
+    } else if (op == NCODEC_SEEK_CUR) {
+        pos = _s->pos + pos;
+        _s->pos = (pos > _s->len) ? _s->len : pos;
+    } else if (op == NCODEC_SEEK_END) {
+        _s->pos = _s->len;
+    } else if (op == NCODEC_SEEK_RESET) {
+        _s->pos = _s->len = 0;
+    } else {
+        return -EINVAL;
+    }
+    return _s->pos;
+}
+
+
+static int64_t stream_tell(NCODEC* nc)
+{
+    BenchStream* _s = _stream(nc);
+    if (_s == NULL) return -ENOSTR;
+    return _s->pos;
+}
+
+
+static int32_t stream_eof(NCODEC* nc)
+{
+    BenchStream* _s = _stream(nc);
+    if (_s && _s->pos < _s->len) return 0;
+    return 1;
+}
+
+
+static int32_t stream_close(NCODEC* nc)
+{
+    UNUSED(nc);
+    return 0;
+}
+
+
+static BenchStream bench_stream = {
+    .s =
+        (struct NCodecStreamVTable){
+            .read = stream_read,
+            .write = stream_write,
+            .seek = stream_seek,
+            .tell = stream_tell,
+            .eof = stream_eof,
+            .close = stream_close,
+            .reserve = stream_reserve,
+            .commit = stream_commit,
+        },
+};
+
+
+/* Benchmark configuration and results. */
+typedef enum {
+    BENCH_CAN = 0,
+    BENCH_CAN_RAW,
+    BENCH_PDU,
+    BENCH_PDU_COLUMNAR,
+} BenchKind;
+
+#define BENCH_IS_CAN(bc)                                                       \
+    ((bc)->kind == BENCH_CAN || (bc)->kind == BENCH_CAN_RAW)
+
+typedef struct BenchCase {
+    BenchKind              kind;
+    size_t                 payload_len;
+    size_t                 msg_count; /* Messages per step. */
+    NCodecPduTransportType metadata;
+    uint32_t               filter_pct; /* Self-filter hit rate (%). */
+} BenchCase;
+
+typedef struct BenchResult {
+    uint64_t write_ns; /* Total of write + flush. */
+    uint64_t read_ns;  /* Total of seek + read (until -ENOMSG). */
+    uint64_t msg_read; /* Messages returned (i.e. not filtered). */
+    uint64_t step_p50_ns;
+    uint64_t step_p99_ns;
+    uint64_t max_stream_len;
+} BenchResult;
+
+
+static uint64_t _now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+static int _compare_u64(const void* a, const void* b)
+{
+    uint64_t _a = *(const uint64_t*)a;
+    uint64_t _b = *(const uint64_t*)b;
+    return (_a > _b) - (_a < _b);
+}
+
+
+/* Spread the self-filter hits evenly over the messages of a step. */
+static bool _filter_hit(size_t i, uint32_t filter_pct)
+{
+    return ((i + 1) * filter_pct) / 100 != (i * filter_pct) / 100;
+}
+
+
+static const char* _metadata_str(BenchCase* bc)
+{
+    if (BENCH_IS_CAN(bc)) return "-";
+    switch (bc->metadata) {
+    case NCodecPduTransportTypeCan:
+        return "can";
+    case NCodecPduTransportTypeIp:
+        return "ip";
+    case NCodecPduTransportTypeStruct:
+        return "struct";
+    default:
+        return "none";
+    }
+}
+
+
+static void _pdu_metadata(NCodecPdu* pdu, NCodecPduTransportType metadata)
+{
+    pdu->transport_type = metadata;
+    switch (metadata) {
+    case NCodecPduTransportTypeCan:
+        pdu->transport.can_message = (NCodecPduCanMessageMetadata){
+            .frame_format = NCodecPduCanFrameFormatFdBase,
+            .frame_type = NCodecPduCanFrameTypeData,
+            .interface_id = 3,
+            .network_id = 1,
+        };
+        break;
+    case NCodecPduTransportTypeIp:
+        pdu->transport.ip_message = (NCodecPduIpMessageMetadata){
+            .eth_dst_mac = 0x0000123456789ABC,
+            .eth_src_mac = 0x0000CBA987654321,
+            .eth_ethertype = 0x0800,
+            .ip_protocol = NCodecPduIpProtocolUdp,
+            .ip_addr_type = NCodecPduIpAddrIPv4,
+            .ip_addr.ip_v4 = { .src_addr = 0xC0A80001,
+                .dst_addr = 0xC0A80002 },
+            .ip_src_port = 30490,
+            .ip_dst_port = 30490,
+            .so_ad_type = NCodecPduSoAdSomeIP,
+            .so_ad.some_ip = { .message_id = 42, .length = 8 },
+        };
+        break;
+    case NCodecPduTransportTypeStruct:
+        pdu->transport.struct_object = (NCodecPduStructMetadata){
+            .type_name = "bench_t",
+            .var_name = "bench",
+            .encoding = "none",
+            .attribute_aligned = 8,
+            .platform_arch = "amd64",
+            .platform_os = "linux",
+            .platform_abi = "gnu",
+        };
+        break;
+    default:
+        break;
+    }
+}
+
+
+static int32_t _bench_step(BenchCase* bc, NCODEC* tx_self, NCODEC* tx_other,
+    NCODEC* rx, uint8_t* payload, uint64_t* write_ns, uint64_t* read_ns,
+    uint64_t* msg_read)
+{
+    /* Write and flush. */
+    uint64_t t0 = _now_ns();
+    ncodec_truncate(tx_self);
+    for (size_t i = 0; i < bc->msg_count; i++) {
+        bool    hit = _filter_hit(i, bc->filter_pct);
+        int32_t rc;
+        if (BENCH_IS_CAN(bc)) {
+            rc = ncodec_write(hit ? tx_self : tx_other,
+                &(struct NCodecCanMessage){ .frame_id = 42 + i,
+                    .frame_type = bc->payload_len > 8 ? CAN_FD_BASE_FRAME
+                                                      : CAN_BASE_FRAME,
+                    .buffer = payload,
+                    .len = bc->payload_len });
+        } else {
+            NCodecPdu pdu = {
+                .id = 42 + i,
+                .payload = payload,
+                .payload_len = bc->payload_len,
+                .swc_id = hit ? SWC_ID_SELF : SWC_ID_OTHER,
+            };
+            _pdu_metadata(&pdu, bc->metadata);
+            rc = ncodec_write(tx_self, &pdu);
+        }
+        if (rc < 0) return rc;
+    }
+    ncodec_flush(tx_self);
+    if (tx_other) ncodec_flush(tx_other);
+    uint64_t t1 = _now_ns();
+
+    /* Read back, until all messages are consumed. */
+    ncodec_seek(rx, 0, NCODEC_SEEK_SET);
+    while (1) {
+        int32_t rc;
+        if (BENCH_IS_CAN(bc)) {
+            NCodecCanMessage msg = {};
+            rc = ncodec_read(rx, &msg);
+        } else {
+            NCodecPdu pdu = {};
+            rc = ncodec_read(rx, &pdu);
+        }
+        if (rc < 0) break;
+        *msg_read += 1;
+    }
+    uint64_t t2 = _now_ns();
+
+    *write_ns = t1 - t0;
+    *read_ns = t2 - t1;
+    return 0;
+}
+
+
+static int32_t _bench_run(BenchCase* bc, size_t steps, BenchResult* result)
+{
+    NCODEC*   tx_self = NULL;
+    NCODEC*   tx_other = NULL;
+    NCODEC*   rx = NULL;
+    uint8_t*  payload = malloc(bc->payload_len);
+    uint64_t* step_ns = calloc(steps, sizeof(uint64_t));
+    int32_t   rc = -ENOMEM;
+    if (payload == NULL || step_ns == NULL) goto run_exit;
+    for (size_t i = 0; i < bc->payload_len; i++) {
+        payload[i] = (uint8_t)i;
+    }
+
+    /* The writers and reader share the stream. For CAN, messages are
+       written by either the reader's node (filtered) or another node. */
+    rc = -EINVAL;
+    void* stream = &bench_stream;
+    if (BENCH_IS_CAN(bc)) {
+        bool raw = (bc->kind == BENCH_CAN_RAW);
+        tx_self = ncodec_open(
+            raw ? MIMETYPE_CAN_RAW_SELF : MIMETYPE_CAN_SELF, stream);
+        tx_other = ncodec_open(
+            raw ? MIMETYPE_CAN_RAW_OTHER : MIMETYPE_CAN_OTHER, stream);
+        rx = ncodec_open(
+            raw ? MIMETYPE_CAN_RAW_SELF : MIMETYPE_CAN_SELF, stream);
+        if (tx_self == NULL || tx_other == NULL || rx == NULL) goto run_exit;
+    } else {
+        const char* mime_type = (bc->kind == BENCH_PDU_COLUMNAR)
+                                    ? MIMETYPE_PDU_COLUMNAR
+                                    : MIMETYPE_PDU;
+        tx_self = ncodec_open(mime_type, stream);
+        rx = ncodec_open(mime_type, stream);
+        if (tx_self == NULL || rx == NULL) goto run_exit;
+    }
+
+    *result = (BenchResult){};
+    for (size_t i = 0; i < WARMUP_STEPS + steps; i++) {
+        uint64_t write_ns, read_ns, msg_read = 0;
+        rc = _bench_step(bc, tx_self, tx_other, rx, payload, &write_ns,
+            &read_ns, &msg_read);
+        if (rc) goto run_exit;
+        if (bench_stream.len > result->max_stream_len) {
+            result->max_stream_len = bench_stream.len;
+        }
+        if (i < WARMUP_STEPS) continue;
+        result->write_ns += write_ns;
+        result->read_ns += read_ns;
+        result->msg_read += msg_read;
+        step_ns[i - WARMUP_STEPS] = write_ns + read_ns;
+    }
+    qsort(step_ns, steps, sizeof(uint64_t), _compare_u64);
+    result->step_p50_ns = step_ns[steps / 2];
+    result->step_p99_ns = step_ns[(steps * 99) / 100];
+
+run_exit:
+    if (rx) ncodec_close(rx);
+    if (tx_other) ncodec_close(tx_other);
+    if (tx_self) ncodec_close(tx_self);
+    free(step_ns);
+    free(payload);
+    return rc;
+}
+
+
+static const char* _kind_str[] = { "can", "can_raw", "pdu", "pdu_columnar" };
+
+
+static void _bench_report(
+    FILE* csv, BenchCase* bc, size_t steps, BenchResult* r)
+{
+    uint64_t msg_total = (uint64_t)bc->msg_count * steps;
+    uint64_t total_ns = r->write_ns + r->read_ns;
+    double   msgs_per_sec = total_ns ? msg_total * 1e9 / total_ns : 0;
+    double   mb_per_sec = msgs_per_sec * bc->payload_len / (1024 * 1024);
+
+    fprintf(csv,
+        "%s,%zu,%zu,%s,%u,%zu,%.1f,%.1f,%llu,%llu,%.0f,%.2f,%llu,%llu\n",
+        _kind_str[bc->kind], bc->payload_len, bc->msg_count,
+        _metadata_str(bc), bc->filter_pct, steps,
+        (double)r->write_ns / msg_total, (double)r->read_ns / msg_total,
+        (unsigned long long)r->step_p50_ns, (unsigned long long)r->step_p99_ns,
+        msgs_per_sec, mb_per_sec, (unsigned long long)r->msg_read,
+        (unsigned long long)r->max_stream_len);
+    fflush(csv);
+}
+
+
+int main(int argc, char** argv)
+{
+    const char* csv_file = (argc > 1) ? argv[1] : CSV_FILE;
+    size_t      steps = (argc > 2) ? strtoul(argv[2], NULL, 10) : STEPS;
+    if (steps == 0) steps = STEPS;
+
+    FILE* csv = fopen(csv_file, "w");
+    if (csv == NULL) {
+        fprintf(stderr, "Could not open %s (%s)\n", csv_file, strerror(errno));
+        return 1;
+    }
+    fprintf(csv, "codec,payload_len,msgs_per_step,metadata,filter_pct,steps,"
+                 "write_ns_per_msg,read_ns_per_msg,step_ns_p50,step_ns_p99,"
+                 "msgs_per_sec,mb_per_sec,msg_read,stream_len\n");
+
+    /* Sweep parameters. */
+    size_t   can_payload[] = { 8, 64 };
+    size_t   pdu_payload[] = { 8, 64, 1500, 9000 };
+    size_t   msg_count[] = { 1, 10, 100 };
+    uint32_t filter_pct[] = { 0, 50, 100 };
+    NCodecPduTransportType metadata[] = { NCodecPduTransportTypeNone,
+        NCodecPduTransportTypeCan, NCodecPduTransportTypeIp,
+        NCodecPduTransportTypeStruct };
+
+    BenchKind can_kind[] = { BENCH_CAN, BENCH_CAN_RAW };
+
+    int rc = 0;
+    for (size_t k = 0; k < ARRAY_SIZE(can_kind); k++) {
+        for (size_t p = 0; p < ARRAY_SIZE(can_payload); p++) {
+            for (size_t m = 0; m < ARRAY_SIZE(msg_count); m++) {
+                for (size_t f = 0; f < ARRAY_SIZE(filter_pct); f++) {
+                    BenchCase   bc = { .kind = can_kind[k],
+                          .payload_len = can_payload[p],
+                          .msg_count = msg_count[m],
+                          .filter_pct = filter_pct[f] };
+                    BenchResult r;
+                    if (_bench_run(&bc, steps, &r)) {
+                        rc = 1;
+                        continue;
+                    }
+                    _bench_report(csv, &bc, steps, &r);
+                }
+            }
+        }
+    }
+    /* The columnar schema does not encode transport metadata. */
+    BenchKind pdu_kind[] = { BENCH_PDU, BENCH_PDU_COLUMNAR };
+    for (size_t k = 0; k < ARRAY_SIZE(pdu_kind); k++) {
+        size_t metadata_count = ARRAY_SIZE(metadata);
+        if (pdu_kind[k] == BENCH_PDU_COLUMNAR) metadata_count = 1;
+        for (size_t p = 0; p < ARRAY_SIZE(pdu_payload); p++) {
+            for (size_t m = 0; m < ARRAY_SIZE(msg_count); m++) {
+                for (size_t t = 0; t < metadata_count; t++) {
+                    for (size_t f = 0; f < ARRAY_SIZE(filter_pct); f++) {
+                        BenchCase   bc = { .kind = pdu_kind[k],
+                              .payload_len = pdu_payload[p],
+                              .msg_count = msg_count[m],
+                              .metadata = metadata[t],
+                              .filter_pct = filter_pct[f] };
+                        BenchResult r;
+                        if (_bench_run(&bc, steps, &r)) {
+                            rc = 1;
+                            continue;
+                        }
+                        _bench_report(csv, &bc, steps, &r);
+                    }
+                }
+            }
+        }
+    }
+
+    fclose(csv);
+    if (rc) fprintf(stderr, "Some benchmarks failed\n");
+    free(bench_stream.buffer);
+    return rc;
+}
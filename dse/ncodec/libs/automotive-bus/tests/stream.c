@@ -58,6 +58,30 @@ size_t stream_write(NCODEC* nc, uint8_t* data, size_t len)
     return len;
 }
 
+uint8_t* stream_reserve(NCODEC* nc, size_t len)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL || _nc->stream == NULL) return NULL;
+
+    __stream* _s = (__stream*)_nc->stream;
+
+    if ((_s->pos + len) > BUFFER_LEN) return NULL;
+    return &_s->buffer[_s->pos];
+}
+
+int32_t stream_commit(NCODEC* nc, size_t len)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL || _nc->stream == NULL) return -ENOSTR;
+
+    __stream* _s = (__stream*)_nc->stream;
+
+    if ((_s->pos + len) > BUFFER_LEN) return -EMSGSIZE;
+    _s->pos += len;
+    if (_s->pos > _s->len) _s->len = _s->pos;
+    return len;
+}
+
 int64_t stream_seek(NCODEC* nc, size_t pos, int32_t op)
 {
     NCodecInstance* _nc = (NCodecInstance*)nc;
@@ -126,6 +150,8 @@ __stream mem_stream = {
             .tell = stream_tell,
             .eof = stream_eof,
             .close = stream_close,
+            .reserve = stream_reserve,
+            .commit = stream_commit,
         },
     .len = 0,
     .pos = 0,
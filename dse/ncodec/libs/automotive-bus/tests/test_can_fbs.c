@@ -389,6 +389,584 @@ void test_can_fbs_frame_type(void** state)
 }
 
 
+void test_can_fbs_read_batch(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting[] = { "Hello World", "Foo Bar", "Hello Foo Bar" };
+
+    // Write and flush several frames (spoof node_id).
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42 + i,
+                                  .frame_type = CAN_EXTENDED_FRAME,
+                                  .buffer = (uint8_t*)greeting[i],
+                                  .len = strlen(greeting[i]) });
+        assert_int_equal(rc, strlen(greeting[i]));
+    }
+    ncodec_flush(nc);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+
+    // Read the frames back, in batches.
+    uint32_t              frame_id[2];
+    uint8_t*              buffer[2];
+    size_t                len[2];
+    NCodecCanFrameType    frame_type[2];
+    uint8_t               node_id[2];
+    NCodecCanMessageBatch batch = {
+        .capacity = 2,
+        .frame_id = frame_id,
+        .buffer = buffer,
+        .len = len,
+        .frame_type = frame_type,
+        .sender.node_id = node_id,
+    };
+    rc = ncodec_read_batch(nc, &batch);
+    assert_int_equal(rc, 2);
+    assert_int_equal(batch.count, 2);
+    for (uint i = 0; i < 2; i++) {
+        assert_int_equal(frame_id[i], 42 + i);
+        assert_int_equal(len[i], strlen(greeting[i]));
+        assert_memory_equal(buffer[i], greeting[i], strlen(greeting[i]));
+        assert_int_equal(frame_type[i], CAN_EXTENDED_FRAME);
+        assert_int_equal(node_id[i], 8);
+    }
+    rc = ncodec_read_batch(nc, &batch);
+    assert_int_equal(rc, 1);
+    assert_int_equal(batch.count, 1);
+    assert_int_equal(frame_id[0], 44);
+    assert_int_equal(len[0], strlen(greeting[2]));
+    assert_memory_equal(buffer[0], greeting[2], strlen(greeting[2]));
+    rc = ncodec_read_batch(nc, &batch);
+    assert_int_equal(rc, -ENOMSG);
+    assert_int_equal(batch.count, 0);
+
+    // Bad batch arguments.
+    batch.capacity = 0;
+    assert_int_equal(ncodec_read_batch(nc, &batch), -EINVAL);
+    assert_int_equal(ncodec_read_batch(nc, NULL), -EINVAL);
+}
+
+
+void test_can_fbs_write_batch(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting[] = { "Hello World", "Foo Bar", "Hello Foo Bar" };
+
+    // Write (single then batch) and flush several frames (spoof node_id).
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    NCodecCanMessage msgs[ARRAY_SIZE(greeting)];
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        msgs[i] = (struct NCodecCanMessage){ .frame_id = 42 + i,
+            .frame_type = CAN_EXTENDED_FRAME,
+            .buffer = (uint8_t*)greeting[i],
+            .len = strlen(greeting[i]) };
+    }
+    rc = ncodec_write(nc, &msgs[0]);
+    assert_int_equal(rc, strlen(greeting[0]));
+    rc = ncodec_write_batch(nc, &msgs[1], 2);
+    assert_int_equal(rc, 2);
+    rc = ncodec_write_batch(nc, msgs, 0);
+    assert_int_equal(rc, 0);
+    ncodec_flush(nc);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+
+    // Read the frames back.
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        NCodecCanMessage msg = {};
+        rc = ncodec_read(nc, &msg);
+        assert_int_equal(rc, strlen(greeting[i]));
+        assert_int_equal(msg.frame_id, 42 + i);
+        assert_int_equal(msg.frame_type, CAN_EXTENDED_FRAME);
+        assert_memory_equal(msg.buffer, greeting[i], strlen(greeting[i]));
+        assert_int_equal(msg.sender.bus_id, 1);
+        assert_int_equal(msg.sender.node_id, 8);
+        assert_int_equal(msg.sender.interface_id, 3);
+    }
+    NCodecCanMessage msg = {};
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+
+    // Bad batch arguments.
+    assert_int_equal(ncodec_write_batch(nc, NULL, 1), -EINVAL);
+}
+
+
+void test_can_fbs_write_reserve(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    // Commit without a reservation.
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    assert_int_equal(ncodec_write_commit(nc, 0), -EINVAL);
+
+    // Reserve a payload, write into the codec buffer, then commit.
+    uint8_t* payload = ncodec_write_reserve(nc,
+        &(struct NCodecCanMessage){
+            .frame_id = 42, .frame_type = CAN_EXTENDED_FRAME },
+        BUFFER_LEN);
+    assert_non_null(payload);
+    assert_null(ncodec_write_reserve(
+        nc, &(struct NCodecCanMessage){ .frame_id = 43 }, 8));
+    assert_int_equal(errno, EBUSY);
+    assert_int_equal(ncodec_write(nc, &(struct NCodecCanMessage){}), -EBUSY);
+    assert_int_equal(ncodec_flush(nc), -EBUSY);
+    memcpy(payload, greeting, strlen(greeting));
+    assert_int_equal(ncodec_write_commit(nc, BUFFER_LEN + 1), -EINVAL);
+    rc = ncodec_write_commit(nc, strlen(greeting));
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(ncodec_write_commit(nc, 0), -EINVAL);
+    ncodec_flush(nc);
+
+    // Modify the node_id, and read the message back.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    NCodecCanMessage msg = {};
+    rc = ncodec_read(nc, &msg);
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(msg.frame_id, 42);
+    assert_int_equal(msg.frame_type, CAN_EXTENDED_FRAME);
+    assert_int_equal(msg.len, strlen(greeting));
+    assert_memory_equal(msg.buffer, greeting, strlen(greeting));
+    assert_int_equal(msg.sender.bus_id, 1);
+    assert_int_equal(msg.sender.node_id, 2);
+    assert_int_equal(msg.sender.interface_id, 3);
+}
+
+
+void test_can_fbs_flush_stream_write(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+    uint8_t     expect[BUFFER_LEN];
+    uint8_t*    buffer;
+    size_t      buffer_len;
+
+    // Flush via stream reserve/commit (direct copy into stream memory).
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42,
+                              .buffer = (uint8_t*)greeting,
+                              .len = strlen(greeting) });
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(0x66, ncodec_flush(nc));
+    assert_int_equal(0x66, ncodec_tell(nc));
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    stream_read(nc, &buffer, &buffer_len, NCODEC_POS_NC);
+    assert_int_equal(buffer_len, 0x66);
+    memcpy(expect, buffer, buffer_len);
+
+    // Flush via stream write (stream without reserve/commit).
+    NCodecStreamReserve reserve = mem_stream.reserve;
+    mem_stream.reserve = NULL;
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42,
+                              .buffer = (uint8_t*)greeting,
+                              .len = strlen(greeting) });
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(0x66, ncodec_flush(nc));
+    assert_int_equal(0x66, ncodec_tell(nc));
+    mem_stream.reserve = reserve;
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    stream_read(nc, &buffer, &buffer_len, NCODEC_POS_NC);
+    assert_int_equal(buffer_len, 0x66);
+    assert_memory_equal(buffer, expect, buffer_len);
+}
+
+
+void test_can_fbs_flush_overflow(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    uint8_t payload[BUFFER_LEN] = {};
+
+    // The stream refuses the write (reserve/commit, then write).
+    NCodecStreamReserve reserve = mem_stream.reserve;
+    for (uint i = 0; i < 2; i++) {
+        ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+        rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42,
+                                  .buffer = payload,
+                                  .len = sizeof(payload) });
+        assert_int_equal(rc, sizeof(payload));
+        assert_int_equal(ncodec_flush(nc), -EMSGSIZE);
+        assert_int_equal(ncodec_tell(nc), 0);
+        mem_stream.reserve = NULL;
+    }
+    mem_stream.reserve = reserve;
+
+    // Asynchronous, the error is returned by ncodec_sync().
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "flush", .value = "async" });
+    rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42,
+                              .buffer = payload,
+                              .len = sizeof(payload) });
+    assert_int_equal(rc, sizeof(payload));
+    assert_int_equal(ncodec_flush(nc), 0);
+    assert_int_equal(ncodec_sync(nc), -EMSGSIZE);
+    assert_int_equal(ncodec_sync(nc), 0);
+}
+
+
+void test_can_fbs_stats(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    // Write and flush frames (own node_id), read back (all filtered).
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    for (uint i = 0; i < 2; i++) {
+        rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42,
+                                  .buffer = (uint8_t*)greeting,
+                                  .len = strlen(greeting) });
+        assert_int_equal(rc, strlen(greeting));
+    }
+    size_t len = ncodec_flush(nc);
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    NCodecCanMessage msg = {};
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+
+    // Timing is only measured with stats=timing.
+    ABCodecStats* stats = &((ABCodecInstance*)nc)->stats;
+    assert_int_equal(stats->write_ns, 0);
+    assert_int_equal(stats->read_ns, 0);
+    assert_int_equal(stats->flush_ns, 0);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "stats", .value = "timing" });
+
+    // Write and flush a frame (spoof node_id), read back.
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42,
+                              .buffer = (uint8_t*)greeting,
+                              .len = strlen(greeting) });
+    assert_int_equal(rc, strlen(greeting));
+    ncodec_flush(nc);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    assert_int_equal(ncodec_read(nc, &msg), strlen(greeting));
+
+    // Check the counters.
+    assert_int_equal(stats->write_count, 3);
+    assert_int_equal(stats->write_bytes, 3 * strlen(greeting));
+    assert_int_equal(stats->read_count, 1);
+    assert_int_equal(stats->read_bytes, strlen(greeting));
+    assert_int_equal(stats->flush_count, 2);
+    assert_int_equal(stats->filter_count, 2);
+    assert_int_equal(stats->builder_hwm, len);
+    assert_true(stats->write_ns > 0);
+    assert_true(stats->read_ns > 0);
+    assert_true(stats->flush_ns > 0);
+
+    // Counters are also available via ncodec_stat().
+    int32_t          index = AB_CODEC_STATS_INDEX;
+    NCodecConfigItem ci = ncodec_stat(nc, &index);
+    assert_int_equal(index, AB_CODEC_STATS_INDEX);
+    assert_string_equal(ci.name, "write_count");
+    assert_string_equal(ci.value, "3");
+    index = AB_CODEC_STATS_INDEX + 5;
+    ci = ncodec_stat(nc, &index);
+    assert_string_equal(ci.name, "filter_count");
+    assert_string_equal(ci.value, "2");
+}
+
+
+void test_can_fbs_flush_async(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+    const char* farewell = "Goodbye";
+
+    // Write and flush two steps (spoof node_id), second step is written
+    // while the first may still be flushing.
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "flush", .value = "async" });
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42,
+                              .buffer = (uint8_t*)greeting,
+                              .len = strlen(greeting) });
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(ncodec_flush(nc), 0);
+    rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 43,
+                              .buffer = (uint8_t*)farewell,
+                              .len = strlen(farewell) });
+    assert_int_equal(rc, strlen(farewell));
+    assert_int_equal(ncodec_flush(nc), 0);
+
+    // Counters updated by the flush worker are complete when read.
+    int32_t          index = AB_CODEC_STATS_INDEX + 6;
+    NCodecConfigItem ci = ncodec_stat(nc, &index);
+    assert_string_equal(ci.name, "builder_hwm");
+    assert_string_not_equal(ci.value, "0");
+
+    // Barrier, then the stream contains both steps.
+    assert_int_equal(ncodec_sync(nc), 0);
+    assert_true(ncodec_tell(nc) > 0);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    NCodecCanMessage msg = {};
+    assert_int_equal(ncodec_read(nc, &msg), strlen(greeting));
+    assert_int_equal(msg.frame_id, 42);
+    assert_memory_equal(msg.buffer, greeting, strlen(greeting));
+    assert_int_equal(ncodec_read(nc, &msg), strlen(farewell));
+    assert_int_equal(msg.frame_id, 43);
+    assert_memory_equal(msg.buffer, farewell, strlen(farewell));
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+}
+
+
+void test_can_fbs_coalesce(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+    const char* farewell = "Goodbye";
+
+    // Write the same frame_ids several times in a step (spoof node_id).
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "coalesce", .value = "last" });
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    for (uint i = 0; i < 10; i++) {
+        rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42,
+                                  .buffer = (uint8_t*)greeting,
+                                  .len = strlen(greeting) - i });
+        assert_int_equal(rc, strlen(greeting) - i);
+        rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 43,
+                                  .buffer = (uint8_t*)greeting,
+                                  .len = strlen(greeting) });
+        assert_int_equal(rc, strlen(greeting));
+    }
+    uint8_t* payload = ncodec_write_reserve(nc,
+        &(struct NCodecCanMessage){
+            .frame_id = 43, .frame_type = CAN_EXTENDED_FRAME },
+        8);
+    assert_non_null(payload);
+    memcpy(payload, farewell, strlen(farewell));
+    assert_int_equal(ncodec_write_commit(nc, strlen(farewell)),
+        strlen(farewell));
+    size_t len = ncodec_flush(nc);
+
+    // Only the last message of each frame_id is in the stream.
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    NCodecCanMessage msg = {};
+    assert_int_equal(ncodec_read(nc, &msg), strlen(greeting) - 9);
+    assert_int_equal(msg.frame_id, 42);
+    assert_memory_equal(msg.buffer, greeting, strlen(greeting) - 9);
+    assert_int_equal(ncodec_read(nc, &msg), strlen(farewell));
+    assert_int_equal(msg.frame_id, 43);
+    assert_int_equal(msg.frame_type, CAN_EXTENDED_FRAME);
+    assert_memory_equal(msg.buffer, farewell, strlen(farewell));
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+    assert_int_equal(((ABCodecInstance*)nc)->stats.write_count, 21);
+
+    // The next step starts empty, truncate discards coalesced messages.
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42,
+                         .buffer = (uint8_t*)greeting,
+                         .len = strlen(greeting) });
+    assert_int_equal(ncodec_truncate(nc), 0);
+    assert_int_equal(ncodec_flush(nc), 0);
+    ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 44,
+                         .buffer = (uint8_t*)greeting,
+                         .len = strlen(greeting) });
+    assert_true(ncodec_flush(nc) < (int)len);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    assert_int_equal(ncodec_read(nc, &msg), strlen(greeting));
+    assert_int_equal(msg.frame_id, 44);
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+
+    // Bad parameter value, ignored.
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "coalesce", .value = "first" });
+    int32_t          index = 12;
+    NCodecConfigItem ci = ncodec_stat(nc, &index);
+    assert_string_equal(ci.name, "coalesce");
+    assert_string_equal(ci.value, "last");
+}
+
+
+void test_can_fbs_compression(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    uint8_t  payload[32] = { 1, 2, 3 };
+    uint8_t* buffer;
+    size_t   buffer_len;
+
+    // Write and flush a step, uncompressed (spoof node_id).
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    for (uint i = 0; i < 10; i++) {
+        rc = ncodec_write(nc, &(struct NCodecCanMessage){
+                                  .frame_id = 42 + i,
+                                  .frame_type = CAN_FD_BASE_FRAME,
+                                  .buffer = payload,
+                                  .len = sizeof(payload) });
+        assert_int_equal(rc, sizeof(payload));
+    }
+    size_t len = ncodec_flush(nc);
+
+    // Write and flush the same step, compressed.
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "compression", .value = "lz4" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    for (uint i = 0; i < 10; i++) {
+        rc = ncodec_write(nc, &(struct NCodecCanMessage){
+                                  .frame_id = 42 + i,
+                                  .frame_type = CAN_FD_BASE_FRAME,
+                                  .buffer = payload,
+                                  .len = sizeof(payload) });
+        assert_int_equal(rc, sizeof(payload));
+    }
+    size_t compressed_len = ncodec_flush(nc);
+    assert_true(compressed_len > 0);
+    assert_true(compressed_len < len / 2);
+    assert_int_equal(ncodec_tell(nc), compressed_len);
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    stream_read(nc, &buffer, &buffer_len, NCODEC_POS_NC);
+    assert_memory_equal(&buffer[8], AB_CODEC_LZ4_IDENTIFIER, 4);
+
+    // Read back (decompressed transparently).
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "compression", .value = "none" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    NCodecCanMessage msg = {};
+    for (uint i = 0; i < 10; i++) {
+        assert_int_equal(ncodec_read(nc, &msg), sizeof(payload));
+        assert_int_equal(msg.frame_id, 42 + i);
+        assert_int_equal(msg.frame_type, CAN_FD_BASE_FRAME);
+        assert_int_equal(msg.sender.node_id, 8);
+        assert_memory_equal(msg.buffer, payload, sizeof(payload));
+    }
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+
+    // A malformed compressed message is skipped.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    stream_read(nc, &buffer, &buffer_len, NCODEC_POS_NC);
+    buffer[12] = 0xff;
+    buffer[13] = 0xff;
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+
+    // An uncompressed length beyond the LZ4 bound is rejected (before
+    // allocating).
+    buffer[4] = buffer[5] = buffer[6] = 0;
+    buffer[7] = 0x10;
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+    assert_true(((ABCodecInstance*)nc)->compress.inflate->len < 0x10000000);
+}
+
+
+void test_can_fbs_compression_batch(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+#define MESSAGES 3
+#define FRAMES   20
+    uint8_t payload[64];
+
+    // Write and flush several compressed messages (spoof node_id).
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "compression", .value = "lz4" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    for (uint m = 0; m < MESSAGES; m++) {
+        memset(payload, m + 1, sizeof(payload));
+        for (uint i = 0; i < FRAMES; i++) {
+            rc = ncodec_write(nc, &(struct NCodecCanMessage){
+                                      .frame_id = m * FRAMES + i,
+                                      .frame_type = CAN_FD_BASE_FRAME,
+                                      .buffer = payload,
+                                      .len = sizeof(payload) });
+            assert_int_equal(rc, sizeof(payload));
+        }
+        assert_true(ncodec_flush(nc) > 0);
+    }
+
+    // Read back in a single batch, spanning all messages. Payloads of
+    // earlier messages remain valid.
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    uint32_t              frame_id[MESSAGES * FRAMES];
+    uint8_t*              buffer[MESSAGES * FRAMES];
+    size_t                len[MESSAGES * FRAMES];
+    NCodecCanMessageBatch batch = {
+        .capacity = MESSAGES * FRAMES,
+        .frame_id = frame_id,
+        .buffer = buffer,
+        .len = len,
+    };
+    rc = ncodec_read_batch(nc, &batch);
+    assert_int_equal(rc, MESSAGES * FRAMES);
+    for (uint i = 0; i < MESSAGES * FRAMES; i++) {
+        memset(payload, (i / FRAMES) + 1, sizeof(payload));
+        assert_int_equal(frame_id[i], i);
+        assert_int_equal(len[i], sizeof(payload));
+        assert_memory_equal(buffer[i], payload, sizeof(payload));
+    }
+    assert_int_equal(ncodec_read_batch(nc, &batch), -ENOMSG);
+
+    // Again, reading from the start of the stream.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    assert_int_equal(ncodec_read_batch(nc, &batch), MESSAGES * FRAMES);
+    memset(payload, 1, sizeof(payload));
+    assert_memory_equal(buffer[0], payload, sizeof(payload));
+#undef MESSAGES
+#undef FRAMES
+}
+
+
 int run_can_fbs_tests(void)
 {
     void* s = test_setup;
@@ -405,6 +983,16 @@ int run_can_fbs_tests(void)
         cmocka_unit_test_setup_teardown(test_can_fbs_readwrite_messages, s, t),
         cmocka_unit_test_setup_teardown(test_can_fbs_truncate, s, t),
         cmocka_unit_test_setup_teardown(test_can_fbs_frame_type, s, t),
+        cmocka_unit_test_setup_teardown(test_can_fbs_read_batch, s, t),
+        cmocka_unit_test_setup_teardown(test_can_fbs_write_batch, s, t),
+        cmocka_unit_test_setup_teardown(test_can_fbs_write_reserve, s, t),
+        cmocka_unit_test_setup_teardown(test_can_fbs_flush_stream_write, s, t),
+        cmocka_unit_test_setup_teardown(test_can_fbs_flush_overflow, s, t),
+        cmocka_unit_test_setup_teardown(test_can_fbs_stats, s, t),
+        cmocka_unit_test_setup_teardown(test_can_fbs_flush_async, s, t),
+        cmocka_unit_test_setup_teardown(test_can_fbs_coalesce, s, t),
+        cmocka_unit_test_setup_teardown(test_can_fbs_compression, s, t),
+        cmocka_unit_test_setup_teardown(test_can_fbs_compression_batch, s, t),
     };
 
     return cmocka_run_group_tests_name("CAN FBS", can_fbs_tests, NULL, NULL);
@@ -0,0 +1,337 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <testing.h>
+#include <errno.h>
+#include <stdio.h>
+#include <dse/ncodec/codec.h>
+#include <automotive-bus/codec.h>
+
+
+#define UNUSED(x)     ((void)x)
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+
+extern NCODEC* ncodec_create(const char* mime_type);
+extern void    codec_close(NCODEC* nc);
+extern int32_t codec_config(NCODEC* nc, NCodecConfigItem item);
+extern int32_t stream_read(NCODEC* nc, uint8_t** data, size_t* len, int pos_op);
+
+
+typedef struct Mock {
+    NCODEC* nc;
+} Mock;
+
+extern NCodecStreamVTable mem_stream;
+
+
+#define MIMETYPE                                                               \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=raw;"                          \
+    "bus_id=1;node_id=2;interface_id=3"
+#define MIMETYPE_FBS                                                           \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=fbs;"                          \
+    "bus_id=1;node_id=4;interface_id=3"
+#define RAW_MSG_LEN(n)                                                         \
+    (4 + sizeof(ABCodecRawHeader) + (n) * sizeof(ABCodecRawRecord))
+
+
+static int test_setup(void** state)
+{
+    Mock* mock = calloc(1, sizeof(Mock));
+    assert_non_null(mock);
+
+    mock->nc = (void*)ncodec_open(MIMETYPE, (void*)&mem_stream);
+    assert_non_null(mock->nc);
+
+    *state = mock;
+    return 0;
+}
+
+
+static int test_teardown(void** state)
+{
+    Mock* mock = *state;
+    if (mock && mock->nc) codec_close((void*)mock->nc);
+    if (mock) free(mock);
+
+    return 0;
+}
+
+
+void test_can_raw_mimetype(void** state)
+{
+    UNUSED(state);
+
+    // The raw schema is only supported for CAN frames.
+    NCODEC* nc = ncodec_create("application/x-automotive-bus; "
+                               "interface=stream;type=pdu;schema=raw");
+    assert_null(nc);
+    nc = ncodec_create("application/x-automotive-bus; "
+                       "interface=stream;type=frame;bus=can;schema=foo");
+    assert_null(nc);
+
+    // Always flushed synchronously.
+    nc = ncodec_create("application/x-automotive-bus; "
+                       "interface=stream;type=frame;bus=can;schema=raw;"
+                       "flush=async");
+    assert_null(nc);
+    nc = ncodec_create("application/x-automotive-bus; "
+                       "interface=stream;type=frame;bus=can;schema=raw");
+    assert_non_null(nc);
+    assert_int_equal(codec_config(nc, (struct NCodecConfigItem){
+                                          .name = "flush", .value = "async" }),
+        -ENOTSUP);
+    codec_close(nc);
+
+    // Frames are not coalesced.
+    nc = ncodec_create("application/x-automotive-bus; "
+                       "interface=stream;type=frame;bus=can;schema=raw;"
+                       "coalesce=last");
+    assert_null(nc);
+    nc = ncodec_create("application/x-automotive-bus; "
+                       "interface=stream;type=frame;bus=can;schema=raw");
+    assert_non_null(nc);
+    NCodecConfigItem coalesce = { .name = "coalesce", .value = "last" };
+    assert_int_equal(codec_config(nc, coalesce), -ENOTSUP);
+    coalesce.value = "none";
+    assert_int_equal(codec_config(nc, coalesce), 0);
+    codec_close(nc);
+}
+
+
+void test_can_raw_readwrite(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting[] = { "Hello World", "Foo Bar", "Hello Foo Bar" };
+    uint8_t     payload[AB_CODEC_RAW_PAYLOAD_LEN + 1] = {};
+
+    // Write and flush several frames (spoof node_id).
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    assert_int_equal(ncodec_flush(nc), 0);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42 + i,
+                                  .frame_type = CAN_EXTENDED_FRAME,
+                                  .buffer = (uint8_t*)greeting[i],
+                                  .len = strlen(greeting[i]) });
+        assert_int_equal(rc, strlen(greeting[i]));
+    }
+    rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 45,
+                              .frame_type = CAN_FD_BASE_FRAME,
+                              .buffer = payload,
+                              .len = sizeof(payload) });
+    assert_int_equal(rc, -EMSGSIZE);
+    assert_int_equal(ncodec_flush(nc), RAW_MSG_LEN(3));
+    assert_int_equal(ncodec_tell(nc), RAW_MSG_LEN(3));
+
+    // Check the message header.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    uint8_t* buffer;
+    size_t   buffer_len;
+    stream_read(nc, &buffer, &buffer_len, NCODEC_POS_NC);
+    ABCodecRawHeader header;
+    memcpy(&header, buffer + 4, sizeof(header));
+    assert_memory_equal(header.id, AB_CODEC_RAW_IDENTIFIER, 4);
+    assert_int_equal(header.count, 3);
+    assert_int_equal(header.record_len, sizeof(ABCodecRawRecord));
+    assert_int_equal(header.version, AB_CODEC_RAW_VERSION);
+
+    // Read the frames back.
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        NCodecCanMessage msg = {};
+        rc = ncodec_read(nc, &msg);
+        assert_int_equal(rc, strlen(greeting[i]));
+        assert_int_equal(msg.frame_id, 42 + i);
+        assert_int_equal(msg.frame_type, CAN_EXTENDED_FRAME);
+        assert_memory_equal(msg.buffer, greeting[i], strlen(greeting[i]));
+        assert_int_equal(msg.sender.bus_id, 1);
+        assert_int_equal(msg.sender.node_id, 8);
+        assert_int_equal(msg.sender.interface_id, 3);
+    }
+    NCodecCanMessage msg = {};
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+
+    // Frames of this node are filtered.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+
+    // Messages of another version are skipped.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    header.version = AB_CODEC_RAW_VERSION + 1;
+    memcpy(buffer + 4, &header, sizeof(header));
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+
+    // Truncate the stream.
+    assert_int_equal(ncodec_truncate(nc), 0);
+    assert_int_equal(ncodec_tell(nc), 0);
+}
+
+
+void test_can_raw_batch(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting[] = { "Hello World", "Foo Bar", "Hello Foo Bar" };
+
+    // Write (batch) and flush several frames (spoof node_id).
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    NCodecCanMessage msgs[ARRAY_SIZE(greeting)];
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        msgs[i] = (struct NCodecCanMessage){ .frame_id = 42 + i,
+            .frame_type = CAN_EXTENDED_FRAME,
+            .buffer = (uint8_t*)greeting[i],
+            .len = strlen(greeting[i]) };
+    }
+    rc = ncodec_write_batch(nc, msgs, ARRAY_SIZE(greeting));
+    assert_int_equal(rc, ARRAY_SIZE(greeting));
+    assert_int_equal(ncodec_write_batch(nc, NULL, 1), -EINVAL);
+    ncodec_flush(nc);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+
+    // Read the frames back, in batches.
+    uint32_t              frame_id[2];
+    uint8_t*              buffer[2];
+    size_t                len[2];
+    uint8_t               node_id[2];
+    NCodecCanMessageBatch batch = {
+        .capacity = 2,
+        .frame_id = frame_id,
+        .buffer = buffer,
+        .len = len,
+        .sender.node_id = node_id,
+    };
+    rc = ncodec_read_batch(nc, &batch);
+    assert_int_equal(rc, 2);
+    for (uint i = 0; i < 2; i++) {
+        assert_int_equal(frame_id[i], 42 + i);
+        assert_int_equal(len[i], strlen(greeting[i]));
+        assert_memory_equal(buffer[i], greeting[i], strlen(greeting[i]));
+        assert_int_equal(node_id[i], 8);
+    }
+    rc = ncodec_read_batch(nc, &batch);
+    assert_int_equal(rc, 1);
+    assert_int_equal(frame_id[0], 44);
+    assert_memory_equal(buffer[0], greeting[2], strlen(greeting[2]));
+    assert_int_equal(ncodec_read_batch(nc, &batch), -ENOMSG);
+}
+
+
+void test_can_raw_write_reserve(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    // Reserve a payload (limited to the record payload), then commit.
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    assert_int_equal(ncodec_write_commit(nc, 0), -EINVAL);
+    assert_null(ncodec_write_reserve(nc,
+        &(struct NCodecCanMessage){ .frame_id = 42 },
+        AB_CODEC_RAW_PAYLOAD_LEN + 1));
+    assert_int_equal(errno, EMSGSIZE);
+    uint8_t* payload = ncodec_write_reserve(nc,
+        &(struct NCodecCanMessage){
+            .frame_id = 42, .frame_type = CAN_FD_EXTENDED_FRAME },
+        AB_CODEC_RAW_PAYLOAD_LEN);
+    assert_non_null(payload);
+    assert_int_equal(ncodec_write(nc, &(struct NCodecCanMessage){}), -EBUSY);
+    assert_int_equal(ncodec_flush(nc), -EBUSY);
+    memcpy(payload, greeting, strlen(greeting));
+    rc = ncodec_write_commit(nc, AB_CODEC_RAW_PAYLOAD_LEN + 1);
+    assert_int_equal(rc, -EINVAL);
+    rc = ncodec_write_commit(nc, strlen(greeting));
+    assert_int_equal(rc, strlen(greeting));
+    ncodec_flush(nc);
+
+    // Modify the node_id, and read the message back.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    NCodecCanMessage msg = {};
+    rc = ncodec_read(nc, &msg);
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(msg.frame_id, 42);
+    assert_int_equal(msg.frame_type, CAN_FD_EXTENDED_FRAME);
+    assert_memory_equal(msg.buffer, greeting, strlen(greeting));
+    assert_int_equal(msg.sender.node_id, 2);
+}
+
+
+void test_can_raw_mixed_schema(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    // Write a message with each schema to the same stream.
+    NCODEC* nc_fbs = (void*)ncodec_open(MIMETYPE_FBS, (void*)&mem_stream);
+    assert_non_null(nc_fbs);
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    rc = ncodec_write(nc_fbs, &(struct NCodecCanMessage){ .frame_id = 1,
+                                  .buffer = (uint8_t*)greeting,
+                                  .len = strlen(greeting) });
+    assert_int_equal(rc, strlen(greeting));
+    ncodec_flush(nc_fbs);
+    rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 2,
+                              .buffer = (uint8_t*)greeting,
+                              .len = strlen(greeting) });
+    assert_int_equal(rc, strlen(greeting));
+    ncodec_flush(nc);
+
+    // Each codec only reads the message of its schema.
+    NCodecCanMessage msg = {};
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    assert_int_equal(ncodec_read(nc, &msg), strlen(greeting));
+    assert_int_equal(msg.frame_id, 2);
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+    ncodec_seek(nc_fbs, 0, NCODEC_SEEK_SET);
+    ncodec_config(nc_fbs, (struct NCodecConfigItem){
+                              .name = "node_id", .value = "8" });
+    assert_int_equal(ncodec_read(nc_fbs, &msg), strlen(greeting));
+    assert_int_equal(msg.frame_id, 1);
+    assert_int_equal(ncodec_read(nc_fbs, &msg), -ENOMSG);
+
+    ncodec_close(nc_fbs);
+}
+
+
+int run_can_raw_tests(void)
+{
+    void* s = test_setup;
+    void* t = test_teardown;
+
+    const struct CMUnitTest can_raw_tests[] = {
+        cmocka_unit_test_setup_teardown(test_can_raw_mimetype, s, t),
+        cmocka_unit_test_setup_teardown(test_can_raw_readwrite, s, t),
+        cmocka_unit_test_setup_teardown(test_can_raw_batch, s, t),
+        cmocka_unit_test_setup_teardown(test_can_raw_write_reserve, s, t),
+        cmocka_unit_test_setup_teardown(test_can_raw_mixed_schema, s, t),
+    };
+
+    return cmocka_run_group_tests_name("CAN RAW", can_raw_tests, NULL, NULL);
+}
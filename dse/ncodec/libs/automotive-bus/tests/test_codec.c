@@ -4,12 +4,14 @@
 
 #include <testing.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <dse/ncodec/codec.h>
 #include <automotive-bus/codec.h>
 
 
 #define UNUSED(x)     ((void)x)
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+#define STATS         AB_CODEC_STATS_INDEX
 
 
 extern void             free_codec(ABCodecInstance* nc);
@@ -18,6 +20,8 @@ extern void             codec_config(NCODEC* nc, NCodecConfigItem item);
 extern NCodecConfigItem codec_stat(NCODEC* nc, int* index);
 extern NCODEC*          ncodec_create(const char* mime_type);
 extern void             codec_close(NCODEC* nc);
+extern void             codec_pool_drain(void);
+extern int32_t          codec_reset(NCODEC* nc);
 extern int32_t          can_write(NCODEC* nc, NCodecMessage* msg);
 extern int32_t          can_read(NCODEC* nc, NCodecMessage* msg);
 extern int32_t          can_flush(NCODEC* nc);
@@ -260,10 +264,28 @@ void test_codec_stat(void** state)
         { .index = 6, .name = "interface_id", .value = "3" },
         { .index = 7, .name = "swc_id", .value = "4" },
         { .index = 8, .name = "ecu_id", .value = "5" },
+        { .index = 9, .name = "flush", .value = "sync" },
+        { .index = 10, .name = "subscribe", .value = "42,1:2" },
+        { .index = 11, .name = "metadata", .value = "lazy" },
+        { .index = 12, .name = "coalesce", .value = "last" },
+        { .index = 13, .name = "compression", .value = "lz4" },
+        { .index = 14, .name = "stats", .value = "timing" },
+        /* Performance counters. */
+        { .index = STATS + 0, .name = "write_count", .value = "0" },
+        { .index = STATS + 1, .name = "write_bytes", .value = "0" },
+        { .index = STATS + 2, .name = "read_count", .value = "0" },
+        { .index = STATS + 3, .name = "read_bytes", .value = "0" },
+        { .index = STATS + 4, .name = "flush_count", .value = "0" },
+        { .index = STATS + 5, .name = "filter_count", .value = "0" },
+        { .index = STATS + 6, .name = "builder_hwm", .value = "0" },
+        { .index = STATS + 7, .name = "write_ns", .value = "0" },
+        { .index = STATS + 8, .name = "read_ns", .value = "0" },
+        { .index = STATS + 9, .name = "flush_ns", .value = "0" },
         { .index = -1, .name = "foo", .value = "bar" },
     };
 
     for (uint i = 0; i < ARRAY_SIZE(tc); i++) {
+        if (tc[i].index >= STATS) continue;
         codec_config((void*)nc, (struct NCodecConfigItem){
                                     .name = tc[i].name,
                                     .value = tc[i].value,
@@ -439,6 +461,237 @@ void test_ncodec_create_failon_mime(void** state)
 }
 
 
+void test_ncodec_create_descriptor(void** state)
+{
+    UNUSED(state);
+
+    const char* mime_type = "application/x-automotive-bus; "
+                            "interface=stream;type=pdu;schema=fbs;"
+                            "swc_id=4;ecu_id=5";
+    char        mime_type_copy[200];
+    strncpy(mime_type_copy, mime_type, sizeof(mime_type_copy) - 1);
+
+    /* Descriptors are interned. */
+    const NCodecDescriptor* d = ncodec_compile(mime_type);
+    assert_non_null(d);
+    assert_ptr_equal(ncodec_compile(mime_type_copy), d);
+    assert_null(ncodec_compile("application/x-foo; interface=stream"));
+    assert_null(ncodec_compile(NULL));
+    assert_null(ncodec_create_from_descriptor(NULL));
+
+    /* Instances share the descriptor parameters. */
+    ABCodecInstance* nc1 = (void*)ncodec_create_from_descriptor(d);
+    ABCodecInstance* nc2 = (void*)ncodec_create_from_descriptor(d);
+    assert_non_null(nc1);
+    assert_non_null(nc2);
+    assert_ptr_equal(nc1->descriptor, d);
+    assert_ptr_equal(nc2->descriptor, d);
+    assert_string_equal(nc1->c.mime_type, mime_type);
+    assert_ptr_equal(nc1->c.codec.read, pdu_read);
+    assert_ptr_equal(nc1->swc_id_str, nc2->swc_id_str);
+    assert_int_equal(nc1->swc_id, 4);
+    assert_int_equal(nc2->ecu_id, 5);
+
+    /* Instances created from a MIME type share the descriptor of its shape
+       (without the instance ids), the ids are applied to the instance. */
+    const NCodecDescriptor* shape =
+        ncodec_compile("application/x-automotive-bus; "
+                       "interface=stream; type=pdu; schema=fbs");
+    ABCodecInstance* nc3 = (void*)ncodec_create(mime_type_copy);
+    ABCodecInstance* nc4 = (void*)ncodec_create(
+        "application/x-automotive-bus; interface=stream; swc_id=6; "
+        "type=pdu; schema=fbs");
+    assert_non_null(nc3);
+    assert_non_null(nc4);
+    assert_ptr_equal(nc3->descriptor, shape);
+    assert_ptr_equal(nc4->descriptor, shape);
+    assert_ptr_equal(nc3->c.mime_type, mime_type_copy);
+    assert_string_equal(nc3->swc_id_str, "4");
+    assert_int_equal(nc3->swc_id, 4);
+    assert_int_equal(nc3->ecu_id, 5);
+    assert_int_equal(nc4->swc_id, 6);
+    assert_int_equal(nc4->ecu_id, 0);
+    assert_null(nc4->ecu_id_str);
+    codec_close((void*)nc3);
+    codec_close((void*)nc4);
+
+    /* Reconfigure one instance, the other is unchanged. */
+    codec_config((void*)nc1, (struct NCodecConfigItem){
+                                 .name = "swc_id", .value = "8" });
+    assert_string_equal(nc1->swc_id_str, "8");
+    assert_int_equal(nc1->swc_id, 8);
+    assert_string_equal(nc2->swc_id_str, "4");
+    assert_int_equal(nc2->swc_id, 4);
+
+    codec_close((void*)nc1);
+    codec_close((void*)nc2);
+
+    /* The descriptor table grows, interned descriptors remain valid. */
+    const NCodecDescriptor* ds[200];
+    char                    mt[ARRAY_SIZE(ds)][100];
+    for (size_t i = 0; i < ARRAY_SIZE(ds); i++) {
+        snprintf(mt[i], sizeof(mt[i]),
+            "application/x-automotive-bus; "
+            "interface=stream;type=pdu;schema=fbs;swc_id=%zu",
+            i);
+        ds[i] = ncodec_compile(mt[i]);
+        assert_non_null(ds[i]);
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(ds); i++) {
+        assert_ptr_equal(ncodec_compile(mt[i]), ds[i]);
+    }
+    assert_ptr_equal(ncodec_compile(mime_type), d);
+}
+
+
+void test_ncodec_reset_pool(void** state)
+{
+    UNUSED(state);
+
+    const char* mime_type = "application/x-automotive-bus; "
+                            "interface=stream;type=frame;bus=can;schema=fbs;"
+                            "bus_id=1;node_id=2;interface_id=3";
+
+    /* Reconfigure, then reset to the MIME type parameters. */
+    ABCodecInstance* nc = (void*)ncodec_create(mime_type);
+    assert_non_null(nc);
+    nc->c.private = (void*)nc;
+    nc->stats.write_count = 42;
+    ncodec_config((void*)nc, (struct NCodecConfigItem){
+                                 .name = "node_id", .value = "8" });
+    ncodec_config((void*)nc, (struct NCodecConfigItem){
+                                 .name = "flush", .value = "async" });
+    assert_int_equal(nc->node_id, 8);
+    assert_int_equal(ncodec_reset((void*)nc), 0);
+    assert_int_equal(nc->node_id, 2);
+    assert_string_equal(nc->node_id_str, "2");
+    assert_false(nc->flush_async);
+    assert_int_equal(nc->stats.write_count, 0);
+    assert_ptr_equal(nc->c.mime_type, mime_type);
+    assert_ptr_equal(nc->c.private, nc);
+    assert_ptr_equal(nc->c.codec.reset, codec_reset);
+    assert_true(nc->fbs_builder_initalized);
+    assert_ptr_equal(nc->fbs_builder, &nc->fbs_builders[0]);
+
+    /* Closed instances are reused. */
+    codec_close((void*)nc);
+    ABCodecInstance* nc2 = (void*)ncodec_create(mime_type);
+    assert_ptr_equal(nc2, nc);
+    assert_int_equal(nc2->node_id, 2);
+    assert_null(nc2->c.private);
+    codec_close((void*)nc2);
+
+    /* Drain the pool, new instances are then allocated. */
+    const NCodecDescriptor* d = ncodec_compile(mime_type);
+    assert_non_null(d);
+    codec_close(ncodec_create_from_descriptor(d));
+    uint64_t alloc_count = ncodec_alloc_count();
+    codec_close(ncodec_create_from_descriptor(d));
+    assert_int_equal(ncodec_alloc_count(), alloc_count);
+    codec_pool_drain();
+    codec_close(ncodec_create_from_descriptor(d));
+    assert_true(ncodec_alloc_count() > alloc_count);
+
+    /* Bad arguments. */
+    assert_int_equal(ncodec_reset(NULL), -ENOSTR);
+}
+
+
+static size_t _live_allocations;
+
+static void* _counting_realloc(void* context, void* ptr, size_t size)
+{
+    size_t* live = context;
+    if (ptr == NULL) (*live)++;
+    return realloc(ptr, size);
+}
+
+static void _counting_free(void* context, void* ptr)
+{
+    size_t* live = context;
+    (*live)--;
+    free(ptr);
+}
+
+static NCodecAllocatorVTable counting_allocator = {
+    .realloc = _counting_realloc,
+    .free = _counting_free,
+    .context = &_live_allocations,
+};
+
+
+void test_ncodec_allocator(void** state)
+{
+    UNUSED(state);
+
+    const char* mime_type = "application/x-automotive-bus; "
+                            "interface=stream;type=frame;bus=can;schema=fbs;"
+                            "bus_id=1;node_id=2;interface_id=3";
+    const char* mime_type_rx = "application/x-automotive-bus; "
+                               "interface=stream;type=frame;bus=can;schema=fbs;"
+                               "bus_id=1;node_id=3;interface_id=3";
+    const char* greeting = "Hello World";
+
+    /* The object keeps the allocator it was created with. */
+    NCodecAllocatorVTable* previous = ncodec_set_allocator(&counting_allocator);
+    NCODEC*                nc = ncodec_open(mime_type, (void*)&mem_stream);
+    assert_ptr_equal(ncodec_set_allocator(previous), &counting_allocator);
+    assert_non_null(nc);
+    assert_ptr_equal(ncodec_allocator(nc), &counting_allocator);
+    assert_ptr_not_equal(ncodec_allocator(NULL), &counting_allocator);
+    assert_true(_live_allocations > 0);
+    NCODEC* nc_rx = ncodec_open(mime_type_rx, (void*)&mem_stream);
+    assert_non_null(nc_rx);
+
+    /* Reconfiguring allocates with the allocator of the object. */
+    size_t live = _live_allocations;
+    _adjust_node_id(nc, "4");
+    assert_int_equal(_live_allocations, live + 1);
+    _adjust_node_id(nc, "2");
+    assert_int_equal(_live_allocations, live + 1);
+
+    /* No allocations after warm-up. */
+    uint64_t alloc_count = 0;
+    for (int i = 0; i < 10; i++) {
+        if (i == 3) alloc_count = ncodec_alloc_count();
+        ncodec_truncate(nc);
+        for (uint32_t j = 0; j < 4; j++) {
+            ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42 + j,
+                                 .buffer = (uint8_t*)greeting,
+                                 .len = strlen(greeting) });
+        }
+        ncodec_flush(nc);
+
+        ncodec_seek(nc_rx, 0, NCODEC_SEEK_SET);
+        NCodecCanMessage msg = {};
+        uint32_t         count = 0;
+        while (ncodec_read(nc_rx, &msg) >= 0) {
+            assert_int_equal(msg.frame_id, 42 + count);
+            count++;
+        }
+        assert_int_equal(count, 4);
+    }
+    assert_int_equal(ncodec_alloc_count(), alloc_count);
+
+    /* Closed objects are reused for the current allocator only. */
+    ncodec_close(nc_rx);
+    previous = ncodec_set_allocator(&counting_allocator);
+    ncodec_close(nc);
+    NCODEC* nc2 = ncodec_open(mime_type, (void*)&mem_stream);
+    assert_ptr_equal(nc2, nc);
+    ncodec_close(nc2);
+    assert_true(_live_allocations > 0);
+
+    /* Replacing the allocator drains the pool. */
+    ncodec_set_allocator(previous);
+    NCODEC* nc3 = ncodec_open(mime_type, (void*)&mem_stream);
+    assert_non_null(nc3);
+    assert_ptr_not_equal(ncodec_allocator(nc3), &counting_allocator);
+    assert_int_equal(_live_allocations, 0);
+    ncodec_close(nc3);
+}
+
+
 void test_ncodec_call_sequence(void** state)
 {
     UNUSED(state);
@@ -513,6 +766,9 @@ int run_codec_tests(void)
         cmocka_unit_test_setup_teardown(test_ncodec_can_create_close, s, t),
         cmocka_unit_test_setup_teardown(test_ncodec_pdu_create_close, s, t),
         cmocka_unit_test_setup_teardown(test_ncodec_create_failon_mime, s, t),
+        cmocka_unit_test_setup_teardown(test_ncodec_create_descriptor, s, t),
+        cmocka_unit_test_setup_teardown(test_ncodec_reset_pool, s, t),
+        cmocka_unit_test_setup_teardown(test_ncodec_allocator, s, t),
         cmocka_unit_test_setup_teardown(test_ncodec_call_sequence, s, t),
     };
 
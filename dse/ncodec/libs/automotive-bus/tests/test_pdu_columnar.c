@@ -0,0 +1,325 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <testing.h>
+#include <errno.h>
+#include <stdio.h>
+#include <dse/ncodec/codec.h>
+#include <automotive-bus/codec.h>
+
+
+#define UNUSED(x)     ((void)x)
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+
+extern NCODEC* ncodec_create(const char* mime_type);
+extern void    codec_close(NCODEC* nc);
+extern int32_t codec_config(NCODEC* nc, NCodecConfigItem item);
+extern int32_t stream_read(NCODEC* nc, uint8_t** data, size_t* len, int pos_op);
+
+
+typedef struct Mock {
+    NCODEC* nc;
+} Mock;
+
+extern NCodecStreamVTable mem_stream;
+
+
+#define MIMETYPE                                                               \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=pdu;schema=columnar;"                               \
+    "swc_id=4;ecu_id=5"
+#define MIMETYPE_FBS                                                           \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=pdu;schema=fbs;"                                    \
+    "swc_id=6;ecu_id=5"
+
+
+static int test_setup(void** state)
+{
+    Mock* mock = calloc(1, sizeof(Mock));
+    assert_non_null(mock);
+
+    mock->nc = (void*)ncodec_open(MIMETYPE, (void*)&mem_stream);
+    assert_non_null(mock->nc);
+
+    *state = mock;
+    return 0;
+}
+
+
+static int test_teardown(void** state)
+{
+    Mock* mock = *state;
+    if (mock && mock->nc) codec_close((void*)mock->nc);
+    if (mock) free(mock);
+
+    return 0;
+}
+
+
+void test_pdu_columnar_mimetype(void** state)
+{
+    UNUSED(state);
+
+    // The columnar schema is only supported for PDUs.
+    NCODEC* nc = ncodec_create("application/x-automotive-bus; "
+                               "interface=stream;type=frame;bus=can;"
+                               "schema=columnar");
+    assert_null(nc);
+
+    // Always flushed synchronously.
+    nc = ncodec_create("application/x-automotive-bus; "
+                       "interface=stream;type=pdu;schema=columnar;flush=async");
+    assert_null(nc);
+    nc = ncodec_create("application/x-automotive-bus; "
+                       "flush=async;interface=stream;type=pdu;schema=columnar");
+    assert_null(nc);
+    nc = ncodec_create(MIMETYPE);
+    assert_non_null(nc);
+    assert_int_equal(codec_config(nc, (struct NCodecConfigItem){
+                                          .name = "flush", .value = "async" }),
+        -ENOTSUP);
+    assert_int_equal(codec_config(nc, (struct NCodecConfigItem){
+                                          .name = "flush", .value = "sync" }),
+        0);
+    codec_close(nc);
+}
+
+
+void test_pdu_columnar_readwrite(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting[] = { "Hello World", "", "Hello Foo Bar" };
+
+    // Write and flush several PDUs (spoof swc_id).
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    assert_int_equal(ncodec_flush(nc), 0);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "swc_id", .value = "8" });
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        rc = ncodec_write(nc, &(struct NCodecPdu){ .id = 42 + i,
+                                  .payload = (uint8_t*)greeting[i],
+                                  .payload_len = strlen(greeting[i]) });
+        assert_int_equal(rc, strlen(greeting[i]));
+    }
+    size_t len = ncodec_flush(nc);
+    assert_int_equal(len % 4, 0);
+    assert_int_equal(ncodec_tell(nc), len);
+
+    // Check the message header.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    uint8_t* buffer;
+    size_t   buffer_len;
+    stream_read(nc, &buffer, &buffer_len, NCODEC_POS_NC);
+    ABCodecColumnarHeader header;
+    memcpy(&header, buffer + 4, sizeof(header));
+    assert_memory_equal(header.id, AB_CODEC_COLUMNAR_IDENTIFIER, 4);
+    assert_int_equal(header.count, 3);
+    assert_int_equal(header.version, AB_CODEC_COLUMNAR_VERSION);
+    assert_int_equal(header.payload_len,
+        strlen(greeting[0]) + strlen(greeting[1]) + strlen(greeting[2]));
+
+    // Read the PDUs back.
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "swc_id", .value = "4" });
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        NCodecPdu pdu = {};
+        rc = ncodec_read(nc, &pdu);
+        assert_int_equal(rc, strlen(greeting[i]));
+        assert_int_equal(pdu.id, 42 + i);
+        assert_int_equal(pdu.payload_len, strlen(greeting[i]));
+        assert_memory_equal(pdu.payload, greeting[i], strlen(greeting[i]));
+        assert_int_equal(pdu.swc_id, 8);
+        assert_int_equal(pdu.ecu_id, 5);
+        assert_int_equal(pdu.transport_type, NCodecPduTransportTypeNone);
+    }
+    NCodecPdu pdu = {};
+    assert_int_equal(ncodec_read(nc, &pdu), -ENOMSG);
+
+    // PDUs of this SWC are filtered.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "swc_id", .value = "8" });
+    assert_int_equal(ncodec_read(nc, &pdu), -ENOMSG);
+
+    // Truncate the stream.
+    assert_int_equal(ncodec_truncate(nc), 0);
+    assert_int_equal(ncodec_tell(nc), 0);
+}
+
+
+void test_pdu_columnar_batch_reserve(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    // Write a batch, then a reserved PDU (with its own swc_id).
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    NCodecPdu pdus[] = {
+        { .id = 42, .payload = (uint8_t*)greeting, .payload_len = 5 },
+        { .id = 43, .payload = (uint8_t*)greeting, .payload_len = 11 },
+    };
+    rc = ncodec_write_batch(nc, pdus, ARRAY_SIZE(pdus));
+    assert_int_equal(rc, ARRAY_SIZE(pdus));
+    assert_int_equal(ncodec_write_batch(nc, NULL, 1), -EINVAL);
+    assert_int_equal(ncodec_write_commit(nc, 0), -EINVAL);
+    uint8_t* payload = ncodec_write_reserve(
+        nc, &(struct NCodecPdu){ .id = 44, .swc_id = 9 }, 64);
+    assert_non_null(payload);
+    assert_int_equal(ncodec_write(nc, &(struct NCodecPdu){}), -EBUSY);
+    assert_int_equal(ncodec_flush(nc), -EBUSY);
+    memcpy(payload, greeting, strlen(greeting));
+    assert_int_equal(ncodec_write_commit(nc, 65), -EINVAL);
+    rc = ncodec_write_commit(nc, strlen(greeting));
+    assert_int_equal(rc, strlen(greeting));
+    ncodec_flush(nc);
+
+    // Read back, only the reserved PDU is from another SWC.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "swc_id", .value = "4" });
+    NCodecPdu pdu = {};
+    rc = ncodec_read(nc, &pdu);
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(pdu.id, 44);
+    assert_int_equal(pdu.swc_id, 9);
+    assert_memory_equal(pdu.payload, greeting, strlen(greeting));
+    assert_int_equal(ncodec_read(nc, &pdu), -ENOMSG);
+}
+
+
+void test_pdu_columnar_transport(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+
+    const char* greeting = "Hello World";
+
+    // Transport metadata is not encoded, those PDUs are rejected.
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    NCodecPdu pdus[] = {
+        { .id = 42,
+            .payload = (uint8_t*)greeting,
+            .payload_len = 5,
+            .swc_id = 9 },
+        { .id = 43,
+            .payload = (uint8_t*)greeting,
+            .payload_len = 11,
+            .transport_type = NCodecPduTransportTypeCan },
+    };
+    assert_int_equal(ncodec_write(nc, &pdus[1]), -ENOTSUP);
+    assert_null(ncodec_write_reserve(nc, &pdus[1], 11));
+    assert_int_equal(errno, ENOTSUP);
+    assert_int_equal(ncodec_write_batch(nc, &pdus[1], 1), -ENOTSUP);
+
+    // A batch is written up to the rejected PDU.
+    assert_int_equal(ncodec_write_batch(nc, pdus, ARRAY_SIZE(pdus)), 1);
+    ncodec_flush(nc);
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    NCodecPdu pdu = {};
+    assert_int_equal(ncodec_read(nc, &pdu), 5);
+    assert_int_equal(pdu.id, 42);
+    assert_int_equal(ncodec_read(nc, &pdu), -ENOMSG);
+}
+
+
+void test_pdu_columnar_subscribe(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    // Write several PDUs (spoof swc_id).
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "swc_id", .value = "1" });
+    for (uint i = 0; i < 8; i++) {
+        rc = ncodec_write(nc, &(struct NCodecPdu){ .id = 40 + i,
+                                  .payload = (uint8_t*)greeting,
+                                  .payload_len = i });
+        assert_int_equal(rc, i);
+    }
+    ncodec_flush(nc);
+
+    // Read back, only the subscribed PDUs.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "swc_id", .value = "4" });
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "subscribe", .value = "42,46" });
+    NCodecPdu pdu = {};
+    assert_int_equal(ncodec_read(nc, &pdu), 2);
+    assert_int_equal(pdu.id, 42);
+    assert_int_equal(ncodec_read(nc, &pdu), 6);
+    assert_int_equal(pdu.id, 46);
+    assert_int_equal(ncodec_read(nc, &pdu), -ENOMSG);
+}
+
+
+void test_pdu_columnar_mixed_schema(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    // Write a message with each schema to the same stream.
+    NCODEC* nc_fbs = (void*)ncodec_open(MIMETYPE_FBS, (void*)&mem_stream);
+    assert_non_null(nc_fbs);
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    rc = ncodec_write(nc_fbs, &(struct NCodecPdu){ .id = 1,
+                                  .payload = (uint8_t*)greeting,
+                                  .payload_len = strlen(greeting) });
+    assert_int_equal(rc, strlen(greeting));
+    ncodec_flush(nc_fbs);
+    rc = ncodec_write(nc, &(struct NCodecPdu){ .id = 2,
+                              .payload = (uint8_t*)greeting,
+                              .payload_len = strlen(greeting) });
+    assert_int_equal(rc, strlen(greeting));
+    ncodec_flush(nc);
+
+    // Each codec only reads the message of its schema.
+    NCodecPdu pdu = {};
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    assert_int_equal(ncodec_read(nc, &pdu), strlen(greeting));
+    assert_int_equal(pdu.id, 2);
+    assert_int_equal(ncodec_read(nc, &pdu), -ENOMSG);
+    ncodec_seek(nc_fbs, 0, NCODEC_SEEK_SET);
+    ncodec_config(nc_fbs, (struct NCodecConfigItem){
+                              .name = "swc_id", .value = "8" });
+    assert_int_equal(ncodec_read(nc_fbs, &pdu), strlen(greeting));
+    assert_int_equal(pdu.id, 1);
+    assert_int_equal(ncodec_read(nc_fbs, &pdu), -ENOMSG);
+
+    ncodec_close(nc_fbs);
+}
+
+
+int run_pdu_columnar_tests(void)
+{
+    void* s = test_setup;
+    void* t = test_teardown;
+
+    const struct CMUnitTest pdu_columnar_tests[] = {
+        cmocka_unit_test_setup_teardown(test_pdu_columnar_mimetype, s, t),
+        cmocka_unit_test_setup_teardown(test_pdu_columnar_readwrite, s, t),
+        cmocka_unit_test_setup_teardown(test_pdu_columnar_batch_reserve, s, t),
+        cmocka_unit_test_setup_teardown(test_pdu_columnar_transport, s, t),
+        cmocka_unit_test_setup_teardown(test_pdu_columnar_subscribe, s, t),
+        cmocka_unit_test_setup_teardown(test_pdu_columnar_mixed_schema, s, t),
+    };
+
+    return cmocka_run_group_tests_name(
+        "PDU COLUMNAR", pdu_columnar_tests, NULL, NULL);
+}
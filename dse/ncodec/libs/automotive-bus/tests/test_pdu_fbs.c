@@ -841,6 +841,235 @@ void test_pdu_transport_struct(void** state)
 }
 
 
+void test_pdu_fbs_write_batch(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting[] = { "Hello World", "Foo Bar", "Hello Foo Bar" };
+
+    // Write and flush a batch of PDUs.
+    NCodecPdu pdus[ARRAY_SIZE(greeting)];
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        pdus[i] = (struct NCodecPdu){ .id = 42 + i,
+            .payload = (uint8_t*)greeting[i],
+            .payload_len = strlen(greeting[i]),
+            .swc_id = 42 };
+    }
+    pdus[1].transport_type = NCodecPduTransportTypeCan;
+    pdus[1].transport.can_message = (struct NCodecPduCanMessageMetadata){
+        .frame_format = NCodecPduCanFrameFormatFdExtended,
+        .frame_type = NCodecPduCanFrameTypeRemote,
+        .interface_id = 3,
+        .network_id = 4,
+    };
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    rc = ncodec_write_batch(nc, pdus, ARRAY_SIZE(pdus));
+    assert_int_equal(rc, ARRAY_SIZE(pdus));
+    ncodec_flush(nc);
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+
+    // Read the PDUs back.
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        NCodecPdu pdu = {};
+        rc = ncodec_read(nc, &pdu);
+        assert_int_equal(rc, strlen(greeting[i]));
+        assert_int_equal(pdu.id, 42 + i);
+        assert_memory_equal(pdu.payload, greeting[i], strlen(greeting[i]));
+        assert_int_equal(pdu.swc_id, 42);
+        assert_int_equal(pdu.ecu_id, 5);
+        if (i == 1) {
+            assert_int_equal(pdu.transport_type, NCodecPduTransportTypeCan);
+            assert_int_equal(pdu.transport.can_message.frame_format,
+                NCodecPduCanFrameFormatFdExtended);
+            assert_int_equal(pdu.transport.can_message.frame_type,
+                NCodecPduCanFrameTypeRemote);
+            assert_int_equal(pdu.transport.can_message.interface_id, 3);
+            assert_int_equal(pdu.transport.can_message.network_id, 4);
+        }
+    }
+    NCodecPdu pdu = {};
+    assert_int_equal(ncodec_read(nc, &pdu), -ENOMSG);
+
+    // Bad batch arguments.
+    assert_int_equal(ncodec_write_batch(nc, NULL, 1), -EINVAL);
+}
+
+
+void test_pdu_fbs_write_reserve(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    // Reserve a payload, write into the codec buffer, then commit.
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    uint8_t* payload = ncodec_write_reserve(nc,
+        &(struct NCodecPdu){ .id = 42,
+            .swc_id = 42,
+            .transport_type = NCodecPduTransportTypeCan,
+            .transport.can_message = {
+                .frame_format = NCodecPduCanFrameFormatFdBase,
+                .interface_id = 3,
+                .network_id = 4,
+            } },
+        payload_LEN);
+    assert_non_null(payload);
+    assert_int_equal(ncodec_write(nc, &(struct NCodecPdu){}), -EBUSY);
+    memcpy(payload, greeting, strlen(greeting));
+    rc = ncodec_write_commit(nc, strlen(greeting));
+    assert_int_equal(rc, strlen(greeting));
+    ncodec_flush(nc);
+
+    // Read the PDU back.
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    NCodecPdu pdu = {};
+    rc = ncodec_read(nc, &pdu);
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(pdu.id, 42);
+    assert_int_equal(pdu.payload_len, strlen(greeting));
+    assert_memory_equal(pdu.payload, greeting, strlen(greeting));
+    assert_int_equal(pdu.swc_id, 42);
+    assert_int_equal(pdu.ecu_id, 5);
+    assert_int_equal(pdu.transport_type, NCodecPduTransportTypeCan);
+    assert_int_equal(pdu.transport.can_message.frame_format,
+        NCodecPduCanFrameFormatFdBase);
+    assert_int_equal(pdu.transport.can_message.interface_id, 3);
+    assert_int_equal(pdu.transport.can_message.network_id, 4);
+}
+
+
+void test_pdu_fbs_subscribe(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    // Write and flush PDUs from several ECU/SWC.
+    NCodecPdu pdus[] = {
+        { .id = 42, .ecu_id = 1, .swc_id = 1 },
+        { .id = 43, .ecu_id = 1, .swc_id = 2 },
+        { .id = 44, .ecu_id = 2, .swc_id = 1 },
+        { .id = 45, .ecu_id = 2, .swc_id = 2 },
+        { .id = 46, .ecu_id = 3, .swc_id = 3 },
+        { .id = 47, .ecu_id = 258, .swc_id = 257 },
+        { .id = 48, .ecu_id = 300, .swc_id = 70000 },
+    };
+    for (uint i = 0; i < ARRAY_SIZE(pdus); i++) {
+        pdus[i].payload = (uint8_t*)greeting;
+        pdus[i].payload_len = strlen(greeting);
+    }
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    rc = ncodec_write_batch(nc, pdus, ARRAY_SIZE(pdus));
+    assert_int_equal(rc, ARRAY_SIZE(pdus));
+    ncodec_flush(nc);
+
+    // Subscribe to PDU ids and (ecu_id:swc_id) pairs.
+    ncodec_config(nc, (struct NCodecConfigItem){
+        .name = "subscribe", .value = "42,46,2:1,300:70000" });
+    assert_int_equal(((ABCodecInstance*)nc)->subscription.count, 4);
+    uint32_t expect[] = { 42, 44, 46, 48 };
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    for (uint i = 0; i < ARRAY_SIZE(expect); i++) {
+        NCodecPdu pdu = {};
+        rc = ncodec_read(nc, &pdu);
+        assert_int_equal(rc, strlen(greeting));
+        assert_int_equal(pdu.id, expect[i]);
+    }
+    NCodecPdu pdu = {};
+    assert_int_equal(ncodec_read(nc, &pdu), -ENOMSG);
+    assert_int_equal(((ABCodecInstance*)nc)->stats.filter_count, 3);
+
+    // Bad subscriptions are rejected (the previous remains).
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "subscribe", .value = "42,foo" });
+    ncodec_config(nc, (struct NCodecConfigItem){
+        .name = "subscribe", .value = "1:4294967296" });
+    assert_int_equal(((ABCodecInstance*)nc)->subscription.count, 4);
+
+    // Empty subscription, all PDUs are read.
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "subscribe", .value = "" });
+    assert_int_equal(((ABCodecInstance*)nc)->subscription.count, 0);
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    for (uint i = 0; i < ARRAY_SIZE(pdus); i++) {
+        rc = ncodec_read(nc, &pdu);
+        assert_int_equal(rc, strlen(greeting));
+        assert_int_equal(pdu.id, pdus[i].id);
+    }
+}
+
+
+void test_pdu_fbs_metadata_lazy(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    // Write and flush PDUs, with and without transport metadata.
+    NCodecPdu pdus[] = {
+        { .id = 42,
+            .swc_id = 1,
+            .transport_type = NCodecPduTransportTypeCan,
+            .transport.can_message = {
+                .frame_format = NCodecPduCanFrameFormatFdExtended,
+                .frame_type = NCodecPduCanFrameTypeRemote,
+                .interface_id = 3,
+                .network_id = 4,
+            } },
+        { .id = 43, .swc_id = 1 },
+    };
+    for (uint i = 0; i < ARRAY_SIZE(pdus); i++) {
+        pdus[i].payload = (uint8_t*)greeting;
+        pdus[i].payload_len = strlen(greeting);
+    }
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    rc = ncodec_write_batch(nc, pdus, ARRAY_SIZE(pdus));
+    assert_int_equal(rc, ARRAY_SIZE(pdus));
+    ncodec_flush(nc);
+
+    // Read with lazy metadata, the transport is decoded on demand.
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "metadata", .value = "lazy" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    NCodecPdu pdu = { .transport_type = NCodecPduTransportTypeIp };
+    assert_int_equal(ncodec_pdu_transport(nc, &pdu), -ENOMSG);
+    rc = ncodec_read(nc, &pdu);
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(pdu.id, 42);
+    assert_memory_equal(pdu.payload, greeting, strlen(greeting));
+    assert_int_equal(pdu.swc_id, 1);
+    assert_int_equal(pdu.ecu_id, 5);
+    assert_int_equal(pdu.transport_type, NCodecPduTransportTypeNone);
+    assert_int_equal(ncodec_pdu_transport(nc, &pdu), 0);
+    assert_int_equal(pdu.transport_type, NCodecPduTransportTypeCan);
+    assert_int_equal(pdu.transport.can_message.frame_format,
+        NCodecPduCanFrameFormatFdExtended);
+    assert_int_equal(
+        pdu.transport.can_message.frame_type, NCodecPduCanFrameTypeRemote);
+    assert_int_equal(pdu.transport.can_message.interface_id, 3);
+    assert_int_equal(pdu.transport.can_message.network_id, 4);
+
+    rc = ncodec_read(nc, &pdu);
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(pdu.id, 43);
+    assert_int_equal(ncodec_pdu_transport(nc, &pdu), 0);
+    assert_int_equal(pdu.transport_type, NCodecPduTransportTypeNone);
+
+    // No more PDUs, no transport.
+    assert_int_equal(ncodec_read(nc, &pdu), -ENOMSG);
+    assert_int_equal(ncodec_pdu_transport(nc, &pdu), -ENOMSG);
+    assert_int_equal(ncodec_pdu_transport(nc, NULL), -EINVAL);
+}
+
+
 int run_pdu_fbs_tests(void)
 {
     void* s = test_setup;
@@ -864,6 +1093,10 @@ int run_pdu_fbs_tests(void)
         cmocka_unit_test_setup_teardown(
             test_pdu_transport_ip__module_some_ip, s, t),
         cmocka_unit_test_setup_teardown(test_pdu_transport_struct, s, t),
+        cmocka_unit_test_setup_teardown(test_pdu_fbs_write_batch, s, t),
+        cmocka_unit_test_setup_teardown(test_pdu_fbs_write_reserve, s, t),
+        cmocka_unit_test_setup_teardown(test_pdu_fbs_subscribe, s, t),
+        cmocka_unit_test_setup_teardown(test_pdu_fbs_metadata_lazy, s, t),
     };
 
     return cmocka_run_group_tests_name("PDU FBS", pdu_fbs_tests, NULL, NULL);
@@ -0,0 +1,200 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <testing.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <dse/ncodec/codec.h>
+#include <dse/ncodec/record.h>
+#include <automotive-bus/codec.h>
+
+
+#define UNUSED(x) ((void)x)
+
+
+#define MIMETYPE                                                               \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=fbs;"                          \
+    "bus_id=1;node_id=2;interface_id=3"
+#define MIMETYPE_RX                                                            \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=fbs;"                          \
+    "bus_id=1;node_id=8;interface_id=3"
+#define MIMETYPE_BUS2                                                          \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=fbs;"                          \
+    "bus_id=2;node_id=4;interface_id=3"
+#define RECORD_PATH       "test_record.rec"
+#define RECORD_INDEX_PATH "test_record.rec.idx"
+#define STEP_SIZE         0.0005
+
+
+static int test_setup(void** state)
+{
+    UNUSED(state);
+    return 0;
+}
+
+
+static int test_teardown(void** state)
+{
+    UNUSED(state);
+    unlink(RECORD_PATH);
+    unlink(RECORD_INDEX_PATH);
+    return 0;
+}
+
+
+void test_record_replay(void** state)
+{
+    UNUSED(state);
+
+    const char* greeting = "Hello World";
+    NCodecCanMessage msg = {};
+
+    // Record a frame in each step.
+    NCodecRecordStream* stream = ncodec_record_create(RECORD_PATH, 1);
+    assert_non_null(stream);
+    NCODEC* nc = ncodec_open(MIMETYPE, (void*)stream);
+    assert_non_null(nc);
+    for (uint32_t step = 0; step < 10; step++) {
+        assert_int_equal(ncodec_record_step(stream, step * STEP_SIZE), 0);
+        ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42 + step,
+                             .buffer = (uint8_t*)greeting,
+                             .len = strlen(greeting) });
+        ncodec_flush(nc);
+    }
+    assert_int_equal(stream->header->count, 10);
+    assert_int_equal(ncodec_record_step(stream, 0.0), -EINVAL);
+    ncodec_close(nc);
+    ncodec_record_destroy(stream);
+
+    // Replay, in any order, directly from the recording.
+    stream = ncodec_record_open(RECORD_PATH);
+    assert_non_null(stream);
+    assert_int_equal(stream->header->count, 10);
+    nc = ncodec_open(MIMETYPE_RX, (void*)stream);
+    assert_non_null(nc);
+    uint32_t steps[] = { 5, 2, 9 };
+    for (size_t i = 0; i < 3; i++) {
+        assert_true(ncodec_record_seek(stream, steps[i] * STEP_SIZE, 1) > 0);
+        assert_int_equal(ncodec_read(nc, &msg), strlen(greeting));
+        assert_int_equal(msg.frame_id, 42 + steps[i]);
+        assert_memory_equal(msg.buffer, greeting, strlen(greeting));
+        assert_true(msg.buffer > stream->data);
+        assert_true(msg.buffer < stream->data + stream->header->len);
+        assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+    }
+
+    // Seek between steps, to another bus and beyond the recording.
+    assert_true(ncodec_record_seek(stream, 6.5 * STEP_SIZE, 1) > 0);
+    assert_int_equal(ncodec_read(nc, &msg), strlen(greeting));
+    assert_int_equal(msg.frame_id, 42 + 7);
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+    assert_int_equal(ncodec_record_seek(stream, 0.0, 2), -ENOMSG);
+    assert_int_equal(ncodec_record_seek(stream, 1.0, 1), -ENOMSG);
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+
+    ncodec_close(nc);
+    ncodec_record_destroy(stream);
+}
+
+
+void test_record_multi_bus(void** state)
+{
+    UNUSED(state);
+
+    const char* greeting = "Hello World";
+    NCodecCanMessage msg = {};
+
+    // Record the frames of two buses in each step.
+    NCodecRecordStream* stream = ncodec_record_create(RECORD_PATH, 1);
+    assert_non_null(stream);
+    NCODEC* nc1 = ncodec_open(MIMETYPE, (void*)stream);
+    NCODEC* nc2 = ncodec_open(MIMETYPE_BUS2, (void*)stream);
+    assert_non_null(nc1);
+    assert_non_null(nc2);
+    for (uint32_t step = 0; step < 4; step++) {
+        assert_int_equal(ncodec_record_step(stream, step * STEP_SIZE), 0);
+        assert_int_equal(ncodec_record_bus(stream, 1), 0);
+        ncodec_write(nc1, &(struct NCodecCanMessage){ .frame_id = 100 + step,
+                              .buffer = (uint8_t*)greeting,
+                              .len = strlen(greeting) });
+        ncodec_flush(nc1);
+        assert_int_equal(ncodec_record_bus(stream, 2), 0);
+        ncodec_write(nc2, &(struct NCodecCanMessage){ .frame_id = 200 + step,
+                              .buffer = (uint8_t*)greeting,
+                              .len = strlen(greeting) });
+        ncodec_flush(nc2);
+    }
+    assert_int_equal(stream->header->count, 8);
+    ncodec_close(nc1);
+    ncodec_close(nc2);
+    ncodec_record_destroy(stream);
+
+    // Replay each bus, then all buses.
+    stream = ncodec_record_open(RECORD_PATH);
+    assert_non_null(stream);
+    assert_int_equal(ncodec_record_bus(stream, 1), -EBADF);
+    NCODEC* nc = ncodec_open(MIMETYPE_RX, (void*)stream);
+    assert_non_null(nc);
+    for (uint32_t bus_id = 1; bus_id <= 2; bus_id++) {
+        assert_true(ncodec_record_seek(stream, 2 * STEP_SIZE, bus_id) > 0);
+        assert_int_equal(ncodec_read(nc, &msg), strlen(greeting));
+        assert_int_equal(msg.frame_id, bus_id * 100 + 2);
+        assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+    }
+    assert_true(ncodec_record_seek(
+                    stream, 3 * STEP_SIZE, NCODEC_RECORD_ANY_BUS) > 0);
+    assert_int_equal(ncodec_read(nc, &msg), strlen(greeting));
+    assert_int_equal(msg.frame_id, 103);
+    assert_int_equal(ncodec_read(nc, &msg), strlen(greeting));
+    assert_int_equal(msg.frame_id, 203);
+    assert_int_equal(ncodec_read(nc, &msg), -ENOMSG);
+    assert_int_equal(ncodec_record_seek(stream, 0.0, 3), -ENOMSG);
+
+    ncodec_close(nc);
+    ncodec_record_destroy(stream);
+}
+
+
+void test_record_open_fail(void** state)
+{
+    UNUSED(state);
+
+    errno = 0;
+    assert_null(ncodec_record_open(RECORD_PATH));
+    assert_int_equal(errno, ENOENT);
+
+    FILE* file = fopen(RECORD_INDEX_PATH, "w");
+    assert_non_null(file);
+    fputs("not a recording index, not a recording index", file);
+    fclose(file);
+    file = fopen(RECORD_PATH, "w");
+    assert_non_null(file);
+    fclose(file);
+    errno = 0;
+    assert_null(ncodec_record_open(RECORD_PATH));
+    assert_int_equal(errno, EPROTO);
+
+    assert_null(ncodec_record_create(NULL, 1));
+    assert_int_equal(ncodec_record_seek(NULL, 0.0, 1), -EINVAL);
+    assert_int_equal(ncodec_record_bus(NULL, 1), -EINVAL);
+}
+
+
+int run_record_tests(void)
+{
+    void* s = test_setup;
+    void* t = test_teardown;
+
+    const struct CMUnitTest record_tests[] = {
+        cmocka_unit_test_setup_teardown(test_record_replay, s, t),
+        cmocka_unit_test_setup_teardown(test_record_multi_bus, s, t),
+        cmocka_unit_test_setup_teardown(test_record_open_fail, s, t),
+    };
+
+    return cmocka_run_group_tests_name("RECORD", record_tests, NULL, NULL);
+}
@@ -0,0 +1,250 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <testing.h>
+#include <errno.h>
+#include <stdio.h>
+#include <dse/ncodec/codec.h>
+#include <dse/ncodec/trace.h>
+#include <automotive-bus/codec.h>
+
+
+#define UNUSED(x)     ((void)x)
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+
+
+extern void codec_close(NCODEC* nc);
+
+
+typedef struct Mock {
+    NCODEC*          nc;
+    NCodecTraceRing* ring;
+} Mock;
+
+extern NCodecStreamVTable mem_stream;
+
+
+#define MIMETYPE                                                               \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=fbs;"                          \
+    "bus_id=1;node_id=2;interface_id=3"
+
+
+static int test_setup(void** state)
+{
+    Mock* mock = calloc(1, sizeof(Mock));
+    assert_non_null(mock);
+
+    mock->nc = (void*)ncodec_open(MIMETYPE, (void*)&mem_stream);
+    assert_non_null(mock->nc);
+    mock->ring = ncodec_trace_ring_create(3);
+    assert_non_null(mock->ring);
+    assert_int_equal(mock->ring->capacity, 4);
+
+    *state = mock;
+    return 0;
+}
+
+
+static int test_teardown(void** state)
+{
+    Mock* mock = *state;
+    if (mock && mock->nc) codec_close((void*)mock->nc);
+    if (mock) ncodec_trace_ring_destroy(mock->ring);
+    if (mock) free(mock);
+
+    return 0;
+}
+
+
+void test_trace_ring(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting[] = { "Hello World", "Hello World, a long greeting" };
+
+    rc = ncodec_trace_attach(nc, mock->ring, NCODEC_TRACE_CAN);
+    assert_int_equal(rc, 0);
+
+    // Write and flush frames (spoof node_id), then read them back.
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42 + i,
+                                  .buffer = (uint8_t*)greeting[i],
+                                  .len = strlen(greeting[i]) });
+        assert_int_equal(rc, strlen(greeting[i]));
+    }
+    ncodec_flush(nc);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    NCodecCanMessage msg = {};
+    for (uint i = 0; i < ARRAY_SIZE(greeting); i++) {
+        rc = ncodec_read(nc, &msg);
+        assert_int_equal(rc, strlen(greeting[i]));
+    }
+
+    // Consume the trace records.
+    NCodecTraceRecord records[8];
+    size_t            count = ncodec_trace_consume(mock->ring, records, 8);
+    assert_int_equal(count, 4);
+    for (uint i = 0; i < count; i++) {
+        const char* g = greeting[i % 2];
+        assert_int_equal(records[i].direction,
+            (i < 2) ? NCODEC_TRACE_TX : NCODEC_TRACE_RX);
+        assert_int_equal(records[i].id, 42 + (i % 2));
+        assert_int_equal(records[i].len, strlen(g));
+        assert_int_equal(records[i].payload_len,
+            strlen(g) < NCODEC_TRACE_PAYLOAD_LEN ? strlen(g)
+                                                 : NCODEC_TRACE_PAYLOAD_LEN);
+        assert_memory_equal(records[i].payload, g, records[i].payload_len);
+        if (i) assert_true(records[i].timestamp >= records[i - 1].timestamp);
+    }
+    assert_int_equal(ncodec_trace_dropped(mock->ring), 0);
+    assert_int_equal(ncodec_trace_consume(mock->ring, records, 8), 0);
+}
+
+
+void test_trace_ring_overflow(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting = "Hello World";
+
+    rc = ncodec_trace_attach(nc, mock->ring, NCODEC_TRACE_CAN);
+    assert_int_equal(rc, 0);
+
+    // Overflow the ring.
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    for (uint i = 0; i < 6; i++) {
+        rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42 + i,
+                                  .buffer = (uint8_t*)greeting,
+                                  .len = strlen(greeting) });
+        assert_int_equal(rc, strlen(greeting));
+    }
+    ncodec_truncate(nc);
+    assert_int_equal(ncodec_trace_dropped(mock->ring), 2);
+
+    // Drain the ring to a file.
+    FILE* file = tmpfile();
+    assert_non_null(file);
+    assert_int_equal(ncodec_trace_drain(mock->ring, file), 4);
+    assert_int_equal(ftell(file), 4 * sizeof(NCodecTraceRecord));
+    rewind(file);
+    NCodecTraceRecord record;
+    for (uint i = 0; i < 4; i++) {
+        assert_int_equal(fread(&record, sizeof(record), 1, file), 1);
+        assert_int_equal(record.id, 42 + i);
+        assert_int_equal(record.direction, NCODEC_TRACE_TX);
+    }
+    fclose(file);
+
+    // Detach, no more records.
+    ncodec_trace_detach(nc);
+    rc = ncodec_write(nc, &(struct NCodecCanMessage){ .frame_id = 42,
+                              .buffer = (uint8_t*)greeting,
+                              .len = strlen(greeting) });
+    assert_int_equal(rc, strlen(greeting));
+    assert_int_equal(ncodec_trace_drain(mock->ring, stdout), 0);
+    assert_int_equal(ncodec_trace_dropped(mock->ring), 2);
+
+    // Bad arguments.
+    assert_int_equal(ncodec_trace_attach(nc, NULL, NCODEC_TRACE_CAN), -EINVAL);
+    assert_int_equal(ncodec_trace_attach(NULL, mock->ring, 0), -ENOSTR);
+    assert_null(ncodec_trace_ring_create(0));
+}
+
+
+void test_trace_ring_batch(void** state)
+{
+    Mock*   mock = *state;
+    NCODEC* nc = mock->nc;
+    int     rc;
+
+    const char* greeting[] = { "Hello World, a long greeting", "Hello", "Foo" };
+
+    rc = ncodec_trace_attach(nc, mock->ring, NCODEC_TRACE_CAN);
+    assert_int_equal(rc, 0);
+
+    // Write a batch, and a reserved frame (spoof node_id).
+    ncodec_seek(nc, 0, NCODEC_SEEK_RESET);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "8" });
+    NCodecCanMessage msgs[2];
+    for (uint i = 0; i < 2; i++) {
+        msgs[i] = (struct NCodecCanMessage){ .frame_id = 42 + i,
+            .buffer = (uint8_t*)greeting[i],
+            .len = strlen(greeting[i]) };
+    }
+    assert_int_equal(ncodec_write_batch(nc, msgs, 2), 2);
+    uint8_t* payload = ncodec_write_reserve(
+        nc, &(struct NCodecCanMessage){ .frame_id = 44 }, 8);
+    assert_non_null(payload);
+    memcpy(payload, greeting[2], strlen(greeting[2]));
+    rc = ncodec_write_commit(nc, strlen(greeting[2]));
+    assert_int_equal(rc, strlen(greeting[2]));
+
+    // Consume the TX records.
+    NCodecTraceRecord records[4];
+    size_t            count = ncodec_trace_consume(mock->ring, records, 4);
+    assert_int_equal(count, 3);
+    for (uint i = 0; i < count; i++) {
+        assert_int_equal(records[i].direction, NCODEC_TRACE_TX);
+        assert_int_equal(records[i].id, 42 + i);
+        assert_int_equal(records[i].len, strlen(greeting[i]));
+        assert_memory_equal(
+            records[i].payload, greeting[i], records[i].payload_len);
+    }
+
+    // Read back in a batch, the records are reused.
+    ncodec_flush(nc);
+    ncodec_config(nc, (struct NCodecConfigItem){
+                          .name = "node_id", .value = "2" });
+    ncodec_seek(nc, 0, NCODEC_SEEK_SET);
+    uint32_t              frame_id[4];
+    uint8_t*              buffer[4];
+    size_t                len[4];
+    NCodecCanMessageBatch batch = {
+        .capacity = 4,
+        .frame_id = frame_id,
+        .buffer = buffer,
+        .len = len,
+    };
+    assert_int_equal(ncodec_read_batch(nc, &batch), 3);
+    count = ncodec_trace_consume(mock->ring, records, 4);
+    assert_int_equal(count, 3);
+    uint8_t zero[NCODEC_TRACE_PAYLOAD_LEN] = {};
+    for (uint i = 0; i < count; i++) {
+        assert_int_equal(records[i].direction, NCODEC_TRACE_RX);
+        assert_int_equal(records[i].id, 42 + i);
+        assert_int_equal(records[i].len, strlen(greeting[i]));
+        assert_memory_equal(
+            records[i].payload, greeting[i], records[i].payload_len);
+        /* Remainder of the payload is cleared. */
+        assert_memory_equal(records[i].payload + records[i].payload_len,
+            zero, NCODEC_TRACE_PAYLOAD_LEN - records[i].payload_len);
+    }
+    assert_int_equal(ncodec_trace_dropped(mock->ring), 0);
+}
+
+
+int run_trace_tests(void)
+{
+    void* s = test_setup;
+    void* t = test_teardown;
+
+    const struct CMUnitTest trace_tests[] = {
+        cmocka_unit_test_setup_teardown(test_trace_ring, s, t),
+        cmocka_unit_test_setup_teardown(test_trace_ring_overflow, s, t),
+        cmocka_unit_test_setup_teardown(test_trace_ring_batch, s, t),
+    };
+
+    return cmocka_run_group_tests_name("TRACE", trace_tests, NULL, NULL);
+}
@@ -0,0 +1,604 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dse/ncodec/codec.h>
+#include <dse/ncodec/record.h>
+
+
+#define DATA_CAPACITY  (1024 * 1024)
+#define INDEX_CAPACITY 4096
+#define INDEX_PATH_EXT ".idx"
+
+
+static NCodecRecordStream* _stream(NCODEC* nc)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) return NULL;
+    return (NCodecRecordStream*)_nc->stream;
+}
+
+
+static char* _index_path(const char* path)
+{
+    size_t len = strlen(path) + strlen(INDEX_PATH_EXT) + 1;
+    char*  index_path = ncodec_alloc(NULL, len);
+    if (index_path) snprintf(index_path, len, "%s%s", path, INDEX_PATH_EXT);
+    return index_path;
+}
+
+
+/* Extend a (writable) file mapping to at least `len` bytes. The mapping may
+   move, pointers into the mapping are not preserved. */
+static int32_t _extend_map(int fd, void** map, size_t* capacity, size_t len)
+{
+    if (len <= *capacity) return 0;
+
+    size_t _capacity = *capacity ? *capacity : len;
+    while (_capacity < len) {
+        _capacity *= 2;
+    }
+    if (ftruncate(fd, _capacity)) return -errno;
+    void* _map =
+        mmap(NULL, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (_map == MAP_FAILED) return -errno;
+    munmap(*map, *capacity);
+    *map = _map;
+    *capacity = _capacity;
+    return 0;
+}
+
+
+static int32_t _extend_index(NCodecRecordStream* _s, size_t count)
+{
+    size_t  capacity = sizeof(NCodecRecordHeader) +
+                       _s->index_capacity * sizeof(NCodecRecordIndex);
+    void*   map = _s->header;
+    int32_t rc = _extend_map(_s->index_fd, &map, &capacity,
+        sizeof(NCodecRecordHeader) + count * sizeof(NCodecRecordIndex));
+    if (rc) return rc;
+    _s->header = map;
+    _s->index = (NCodecRecordIndex*)(_s->header + 1);
+    _s->index_capacity = (capacity - sizeof(NCodecRecordHeader)) /
+                         sizeof(NCodecRecordIndex);
+    return 0;
+}
+
+
+static size_t record_read(
+    NCODEC* nc, uint8_t** data, size_t* len, int32_t pos_op)
+{
+    NCodecRecordStream* _s = _stream(nc);
+    if (_s == NULL) return -ENOSTR;
+    if (data == NULL || len == NULL) return -EINVAL;
+
+    /* Check EOF (a writer has no window). */
+    if (_s->pos >= _s->end) {
+        *data = NULL;
+        *len = 0;
+        return 0;
+    }
+    /* Return the mapped window, from current pos. */
+    *data = &_s->data[_s->pos];
+    *len = _s->end - _s->pos;
+    /* Advance the position indicator. */
+    if (pos_op == NCODEC_POS_UPDATE) _s->pos = _s->end;
+
+    return *len;
+}
+
+
+static uint8_t* record_reserve(NCODEC* nc, size_t len)
+{
+    NCodecRecordStream* _s = _stream(nc);
+    if (_s == NULL || _s->writable == false) return NULL;
+
+    void*  map = _s->data;
+    size_t offset = _s->header->len;
+    if (_extend_map(_s->fd, &map, &_s->data_capacity, offset + len)) {
+        return NULL;
+    }
+    _s->data = map;
+    return &_s->data[offset];
+}
+
+
+static int32_t record_commit(NCODEC* nc, size_t len)
+{
+    NCodecRecordStream* _s = _stream(nc);
+    if (_s == NULL) return -ENOSTR;
+    if (_s->writable == false) return -EBADF;
+    if (len == 0) return 0;
+    if (_s->header->len + len > _s->data_capacity) return -EMSGSIZE;
+    if (len > UINT32_MAX) return -EMSGSIZE;
+
+    /* Index the message, then publish it (count and len). */
+    uint64_t count = _s->header->count;
+    int32_t  rc = _extend_index(_s, count + 1);
+    if (rc) return rc;
+    _s->index[count] = (NCodecRecordIndex){
+        .time = _s->time,
+        .offset = _s->header->len,
+        .len = (uint32_t)len,
+        .bus_id = _s->bus_id,
+    };
+    _s->header->len += len;
+    _s->header->count = count + 1;
+
+    return (int32_t)len;
+}
+
+
+static size_t record_write(NCODEC* nc, uint8_t* data, size_t len)
+{
+    NCodecRecordStream* _s = _stream(nc);
+    if (_s == NULL) return -ENOSTR;
+    if (_s->writable == false) return -EBADF;
+
+    uint8_t* buffer = record_reserve(nc, len);
+    if (buffer == NULL) return -EMSGSIZE;
+    memcpy(buffer, data, len);
+    int32_t rc = record_commit(nc, len);
+    if (rc < 0) return rc;
+    return len;
+}
+
+
+static int64_t record_seek(NCODEC* nc, size_t pos, int32_t op)
+{
+    NCodecRecordStream* _s = _stream(nc);
+    if (_s == NULL) return -ENOSTR;
+
+    /* Writers only append. */
+    if (_s->writable) {
+        if (op > NCODEC_SEEK_RESET) return -EINVAL;
+        return _s->header->len;
+    }
+
+    /* Readers seek within the selected window. */
+    if (op == NCODEC_SEEK_SET) {
+        pos = _s->start + pos;
+    } else if (op == NCODEC_SEEK_CUR) {
+        pos = _s->pos + pos;
+    } else if (op == NCODEC_SEEK_END) {
+        pos = _s->end;
+    } else if (op == NCODEC_SEEK_RESET) {
+        pos = _s->start;
+    } else {
+        return -EINVAL;
+    }
+    _s->pos = (pos > _s->end) ? _s->end : pos;
+    return _s->pos - _s->start;
+}
+
+
+static int64_t record_tell(NCODEC* nc)
+{
+    NCodecRecordStream* _s = _stream(nc);
+    if (_s == NULL) return -ENOSTR;
+    if (_s->writable) return _s->header->len;
+    return _s->pos - _s->start;
+}
+
+
+static int32_t record_eof(NCODEC* nc)
+{
+    NCodecRecordStream* _s = _stream(nc);
+    if (_s && _s->pos < _s->end) return 0;
+    return 1;
+}
+
+
+static int32_t record_close(NCODEC* nc)
+{
+    (void)nc;
+    return 0;
+}
+
+
+static NCodecRecordStream* _stream_alloc(bool writable)
+{
+    NCodecRecordStream* _s = ncodec_alloc(NULL, sizeof(NCodecRecordStream));
+    if (_s == NULL) return NULL;
+    _s->s = (struct NCodecStreamVTable){
+        .read = record_read,
+        .write = record_write,
+        .seek = record_seek,
+        .tell = record_tell,
+        .eof = record_eof,
+        .close = record_close,
+    };
+    if (writable) {
+        _s->s.reserve = record_reserve;
+        _s->s.commit = record_commit;
+    }
+    _s->writable = writable;
+    _s->fd = -1;
+    _s->index_fd = -1;
+    return _s;
+}
+
+
+/**
+ncodec_record_create
+====================
+
+Create a recording stream. Each message written to the stream (typically
+when a connected Network Codec is flushed) is appended to the memory mapped
+recording file, and indexed with the current simulation time (see
+`ncodec_record_step`) and the current bus id (see `ncodec_record_bus`). The
+index is stored in a second file, with the name `path` + ".idx". Existing
+files are truncated.
+
+The index header (count and length) is updated as each message is appended,
+so that a recording remains readable if the process terminates before
+`ncodec_record_destroy` is called.
+
+Parameters
+----------
+path (const char*)
+: Path of the recording file.
+
+bus_id (uint32_t)
+: Bus id stored with each message, until changed with `ncodec_record_bus`.
+
+Returns
+-------
+NCodecRecordStream (pointer)
+: The recording stream, use as the `stream` parameter of `ncodec_open`.
+
+NULL
+: The recording stream could not be created. Inspect `errno` for more details.
+*/
+NCodecRecordStream* ncodec_record_create(const char* path, uint32_t bus_id)
+{
+    if (path == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    int                 rc;
+    char*               index_path = _index_path(path);
+    NCodecRecordStream* _s = NULL;
+    if (index_path == NULL) return NULL;
+    _s = _stream_alloc(true);
+    if (_s == NULL) goto create_fail;
+    _s->bus_id = bus_id;
+
+    /* Recording. */
+    _s->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (_s->fd < 0) goto create_fail;
+    if (ftruncate(_s->fd, DATA_CAPACITY)) goto create_fail;
+    _s->data = mmap(
+        NULL, DATA_CAPACITY, PROT_READ | PROT_WRITE, MAP_SHARED, _s->fd, 0);
+    if (_s->data == MAP_FAILED) {
+        _s->data = NULL;
+        goto create_fail;
+    }
+    _s->data_capacity = DATA_CAPACITY;
+
+    /* Index. */
+    size_t index_len =
+        sizeof(NCodecRecordHeader) + INDEX_CAPACITY * sizeof(NCodecRecordIndex);
+    _s->index_fd = open(index_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (_s->index_fd < 0) goto create_fail;
+    if (ftruncate(_s->index_fd, index_len)) goto create_fail;
+    void* map = mmap(
+        NULL, index_len, PROT_READ | PROT_WRITE, MAP_SHARED, _s->index_fd, 0);
+    if (map == MAP_FAILED) goto create_fail;
+    _s->header = map;
+    _s->index = (NCodecRecordIndex*)(_s->header + 1);
+    _s->index_capacity = INDEX_CAPACITY;
+    memcpy(_s->header->magic, NCODEC_RECORD_MAGIC, sizeof(_s->header->magic));
+    _s->header->version = NCODEC_RECORD_VERSION;
+    _s->header->index_size = sizeof(NCodecRecordIndex);
+
+    ncodec_free(NULL, index_path);
+    return _s;
+
+create_fail:
+    rc = errno;
+    ncodec_free(NULL, index_path);
+    ncodec_record_destroy(_s);
+    errno = rc;
+    return NULL;
+}
+
+
+/**
+ncodec_record_open
+==================
+
+Open a recording (read only) for replay. Select the messages of a simulation
+step with `ncodec_record_seek`, these messages can then be read by a Network
+Codec connected to the stream (via `ncodec_read`). The Network Codec decodes
+the messages directly from the mapped recording file (without copying).
+
+Parameters
+----------
+path (const char*)
+: Path of the recording file (as passed to `ncodec_record_create`).
+
+Returns
+-------
+NCodecRecordStream (pointer)
+: The recording stream, use as the `stream` parameter of `ncodec_open`.
+
+NULL
+: The recording could not be opened. Inspect `errno` for more details
+  (EPROTO indicates that the index file is not valid).
+*/
+NCodecRecordStream* ncodec_record_open(const char* path)
+{
+    if (path == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    int                 rc;
+    struct stat         st;
+    char*               index_path = _index_path(path);
+    NCodecRecordStream* _s = NULL;
+    if (index_path == NULL) return NULL;
+    _s = _stream_alloc(false);
+    if (_s == NULL) goto open_fail;
+
+    /* Index. */
+    _s->index_fd = open(index_path, O_RDONLY);
+    if (_s->index_fd < 0) goto open_fail;
+    if (fstat(_s->index_fd, &st)) goto open_fail;
+    if ((size_t)st.st_size < sizeof(NCodecRecordHeader)) {
+        errno = EPROTO;
+        goto open_fail;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, _s->index_fd, 0);
+    if (map == MAP_FAILED) goto open_fail;
+    _s->header = map;
+    _s->index = (NCodecRecordIndex*)(_s->header + 1);
+    _s->index_capacity = (st.st_size - sizeof(NCodecRecordHeader)) /
+                         sizeof(NCodecRecordIndex);
+    if (memcmp(_s->header->magic, NCODEC_RECORD_MAGIC,
+            sizeof(_s->header->magic)) ||
+        _s->header->version != NCODEC_RECORD_VERSION ||
+        _s->header->index_size != sizeof(NCodecRecordIndex) ||
+        _s->header->count > _s->index_capacity) {
+        errno = EPROTO;
+        goto open_fail;
+    }
+
+    /* Recording. */
+    _s->fd = open(path, O_RDONLY);
+    if (_s->fd < 0) goto open_fail;
+    if (fstat(_s->fd, &st)) goto open_fail;
+    if ((uint64_t)st.st_size < _s->header->len) {
+        errno = EPROTO;
+        goto open_fail;
+    }
+    if (st.st_size) {
+        _s->data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, _s->fd, 0);
+        if (_s->data == MAP_FAILED) {
+            _s->data = NULL;
+            goto open_fail;
+        }
+        _s->data_capacity = st.st_size;
+    }
+
+    ncodec_free(NULL, index_path);
+    return _s;
+
+open_fail:
+    rc = errno;
+    ncodec_free(NULL, index_path);
+    ncodec_record_destroy(_s);
+    errno = rc;
+    return NULL;
+}
+
+
+/**
+ncodec_record_destroy
+=====================
+
+Release the mappings of a recording stream and close the associated files.
+The files of a recording stream created with `ncodec_record_create` are
+truncated to the length of the recording (and index).
+
+Parameters
+----------
+stream (NCodecRecordStream*)
+: Recording stream. Any connected Network Codec objects should first be
+  closed.
+*/
+void ncodec_record_destroy(NCodecRecordStream* stream)
+{
+    NCodecRecordStream* _s = stream;
+    if (_s == NULL) return;
+
+    size_t len = 0;
+    size_t index_len = sizeof(NCodecRecordHeader);
+    if (_s->header) {
+        len = _s->header->len;
+        index_len += _s->header->count * sizeof(NCodecRecordIndex);
+        munmap(_s->header, sizeof(NCodecRecordHeader) +
+                               _s->index_capacity * sizeof(NCodecRecordIndex));
+    }
+    if (_s->data) munmap(_s->data, _s->data_capacity);
+    if (_s->writable) {
+        if (_s->fd >= 0 && ftruncate(_s->fd, len)) {
+            /* Recording remains valid, though with a larger file. */
+        }
+        if (_s->index_fd >= 0 && ftruncate(_s->index_fd, index_len)) {
+            /* Index remains valid, though with a larger file. */
+        }
+    }
+    if (_s->fd >= 0) close(_s->fd);
+    if (_s->index_fd >= 0) close(_s->index_fd);
+    ncodec_free(NULL, _s);
+}
+
+
+/**
+ncodec_record_step
+==================
+
+Set the simulation time of messages which are subsequently appended to a
+recording stream.
+
+Parameters
+----------
+stream (NCodecRecordStream*)
+: Recording stream (created with `ncodec_record_create`).
+
+time (double)
+: Simulation time. The simulation time of a recording may not decrease.
+
+Returns
+-------
+0
+: The simulation time was set.
+
+-EBADF (-9)
+: The recording stream is not writable.
+
+-EINVAL (-22)
+: Bad `stream` or `time` argument.
+*/
+int32_t ncodec_record_step(NCodecRecordStream* stream, double time)
+{
+    if (stream == NULL) return -EINVAL;
+    if (stream->writable == false) return -EBADF;
+    if (stream->header->count && time < stream->time) return -EINVAL;
+
+    stream->time = time;
+    return 0;
+}
+
+
+/**
+ncodec_record_bus
+=================
+
+Set the bus id of messages which are subsequently appended to a recording
+stream. Several Network Codecs (i.e. of different buses) may then be
+connected to one recording stream, set the bus id before flushing each
+Network Codec.
+
+Parameters
+----------
+stream (NCodecRecordStream*)
+: Recording stream (created with `ncodec_record_create`).
+
+bus_id (uint32_t)
+: Bus id stored with each message.
+
+Returns
+-------
+0
+: The bus id was set.
+
+-EBADF (-9)
+: The recording stream is not writable.
+
+-EINVAL (-22)
+: Bad `stream` argument.
+*/
+int32_t ncodec_record_bus(NCodecRecordStream* stream, uint32_t bus_id)
+{
+    if (stream == NULL) return -EINVAL;
+    if (stream->writable == false) return -EBADF;
+
+    stream->bus_id = bus_id;
+    return 0;
+}
+
+
+/**
+ncodec_record_seek
+==================
+
+Select the messages of a simulation step, the first step with a simulation
+time equal to or greater than `time` (a binary search of the index). The
+consecutive messages of that step with a matching bus id are then presented
+by the stream interface of the recording stream, starting at position 0.
+Messages of a bus are selected up to the first message of another bus, a
+Network Codec should therefore be flushed once in each step (see
+`ncodec_record_bus`).
+
+A connected Network Codec should read all messages from the previously
+selected step (i.e. until `ncodec_read` returns -ENOMSG) before another
+step is selected.
+
+Parameters
+----------
+stream (NCodecRecordStream*)
+: Recording stream.
+
+time (double)
+: Simulation time.
+
+bus_id (uint32_t)
+: Bus id of the messages, or NCODEC_RECORD_ANY_BUS.
+
+Returns
+-------
++ve
+: The length of the selected messages.
+
+-ENOMSG (-42)
+: No messages were found, the stream interface presents no messages.
+
+-EINVAL (-22)
+: Bad `stream` argument.
+*/
+int64_t ncodec_record_seek(
+    NCodecRecordStream* stream, double time, uint32_t bus_id)
+{
+    NCodecRecordStream* _s = stream;
+    if (_s == NULL || _s->header == NULL) return -EINVAL;
+    _s->start = _s->end = _s->pos = 0;
+
+    /* Locate the first message of the step. */
+    const NCodecRecordIndex* index = _s->index;
+    size_t                   count = _s->header->count;
+    size_t                   lo = 0;
+    size_t                   hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index[mid].time < time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    /* Locate the first message of the bus, within the step. */
+    if (lo == count) return -ENOMSG;
+    double step = index[lo].time;
+    size_t i = lo;
+    while (i < count && index[i].time == step &&
+           bus_id != NCODEC_RECORD_ANY_BUS && index[i].bus_id != bus_id) {
+        i++;
+    }
+    if (i == count || index[i].time != step) return -ENOMSG;
+
+    /* Extend the window over consecutive (contiguous) messages. */
+    size_t start = index[i].offset;
+    size_t end = start + index[i].len;
+    for (i++; i < count && index[i].time == step; i++) {
+        if (index[i].offset != end) break;
+        if (bus_id != NCODEC_RECORD_ANY_BUS && index[i].bus_id != bus_id) {
+            break;
+        }
+        end += index[i].len;
+    }
+    if (end > _s->header->len) return -ENOMSG;
+    _s->start = _s->pos = start;
+    _s->end = end;
+
+    return end - start;
+}
@@ -0,0 +1,75 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef DSE_NCODEC_RECORD_H_
+#define DSE_NCODEC_RECORD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <dse/ncodec/codec.h>
+
+
+#define NCODEC_RECORD_MAGIC   "NCODREC"
+#define NCODEC_RECORD_VERSION 1
+#define NCODEC_RECORD_ANY_BUS 0
+
+
+/* Index entry, one for each message appended to a recording. */
+typedef struct NCodecRecordIndex {
+    double   time;   /* Simulation time. */
+    uint64_t offset; /* Offset of the message in the recording. */
+    uint32_t len;    /* Length of the message. */
+    uint32_t bus_id;
+} NCodecRecordIndex;
+
+/* Index file header, updated (in the mapping) as messages are appended. */
+typedef struct NCodecRecordHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t index_size; /* sizeof(NCodecRecordIndex) */
+    uint64_t count;      /* Number of index entries. */
+    uint64_t len;        /* Length of the recording. */
+} NCodecRecordHeader;
+
+/* Stream backed by a memory mapped, append-only, recording file (`path`)
+   and its index file (`path`.idx). */
+typedef struct NCodecRecordStream {
+    NCodecStreamVTable s;
+    bool               writable;
+
+    /* Recording (messages are stored contiguously). */
+    int      fd;
+    uint8_t* data;
+    size_t   data_capacity;
+
+    /* Index. */
+    int                 index_fd;
+    NCodecRecordHeader* header;
+    NCodecRecordIndex*  index;
+    size_t              index_capacity;
+
+    /* Writer, simulation time and bus of appended messages. */
+    double   time;
+    uint32_t bus_id;
+
+    /* Reader, window of the recording selected by ncodec_record_seek(). */
+    size_t start;
+    size_t end;
+    size_t pos;
+} NCodecRecordStream;
+
+
+/* Provided by record.c (in this package), POSIX only. */
+DLL_PUBLIC NCodecRecordStream* ncodec_record_create(
+    const char* path, uint32_t bus_id);
+DLL_PUBLIC NCodecRecordStream* ncodec_record_open(const char* path);
+DLL_PUBLIC void    ncodec_record_destroy(NCodecRecordStream* stream);
+DLL_PUBLIC int32_t ncodec_record_step(NCodecRecordStream* stream, double time);
+DLL_PUBLIC int32_t ncodec_record_bus(
+    NCodecRecordStream* stream, uint32_t bus_id);
+DLL_PUBLIC int64_t ncodec_record_seek(
+    NCodecRecordStream* stream, double time, uint32_t bus_id);
+
+#endif  // DSE_NCODEC_RECORD_H_
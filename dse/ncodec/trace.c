@@ -0,0 +1,311 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dse/ncodec/codec.h>
+#include <dse/ncodec/trace.h>
+
+
+#define DRAIN_CHUNK 64
+
+
+static void ring_push(NCodecTraceRing* ring, uint8_t direction, uint32_t id,
+    const uint8_t* data, size_t len)
+{
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if ((head - tail) >= ring->capacity) {
+        /* Ring is full, drop the record (never block the producer). */
+        __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    NCodecTraceRecord* r = &ring->records[head & ring->mask];
+    struct timespec    ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    r->timestamp = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+    r->id = id;
+    r->len = (uint32_t)len;
+    r->direction = direction;
+    r->payload_len =
+        (len < NCODEC_TRACE_PAYLOAD_LEN) ? len : NCODEC_TRACE_PAYLOAD_LEN;
+    /* Records are reused, clear the remainder of a previous payload. */
+    size_t copy_len = data ? r->payload_len : 0;
+    if (copy_len) memcpy(r->payload, data, copy_len);
+    memset(r->payload + copy_len, 0, NCODEC_TRACE_PAYLOAD_LEN - copy_len);
+
+    /* Publish the record. */
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+
+static void trace_can_write(NCODEC* nc, NCodecMessage* m)
+{
+    NCodecInstance*   _nc = (NCodecInstance*)nc;
+    NCodecCanMessage* msg = m;
+    ring_push(_nc->trace.private, NCODEC_TRACE_TX, msg->frame_id, msg->buffer,
+        msg->len);
+}
+
+static void trace_can_read(NCODEC* nc, NCodecMessage* m)
+{
+    NCodecInstance*   _nc = (NCodecInstance*)nc;
+    NCodecCanMessage* msg = m;
+    ring_push(_nc->trace.private, NCODEC_TRACE_RX, msg->frame_id, msg->buffer,
+        msg->len);
+}
+
+static void trace_pdu_write(NCODEC* nc, NCodecMessage* m)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    NCodecPdu*      pdu = m;
+    ring_push(_nc->trace.private, NCODEC_TRACE_TX, pdu->id, pdu->payload,
+        pdu->payload_len);
+}
+
+static void trace_pdu_read(NCODEC* nc, NCodecMessage* m)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    NCodecPdu*      pdu = m;
+    ring_push(_nc->trace.private, NCODEC_TRACE_RX, pdu->id, pdu->payload,
+        pdu->payload_len);
+}
+
+
+/**
+ncodec_trace_ring_create
+========================
+
+Create a trace ring, with preallocated storage for `capacity` trace records.
+The ring is lock-free for a single producer (i.e. the thread calling
+`ncodec_write`/`ncodec_read` on the attached Network Codec objects) and a
+single consumer (i.e. the thread calling `ncodec_trace_drain`). When the ring
+is full, new records are dropped (and counted).
+
+Parameters
+----------
+capacity (size_t)
+: The number of trace records, rounded up to a power of 2.
+
+Returns
+-------
+NCodecTraceRing (pointer)
+: The trace ring object.
+
+NULL
+: The trace ring could not be created. Inspect `errno` for more details.
+*/
+NCodecTraceRing* ncodec_trace_ring_create(size_t capacity)
+{
+    if (capacity == 0 || capacity > (SIZE_MAX >> 1)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    size_t _capacity = 1;
+    while (_capacity < capacity)
+        _capacity <<= 1;
+
+    NCodecTraceRing* ring = calloc(1, sizeof(NCodecTraceRing));
+    if (ring == NULL) return NULL;
+    ring->records = calloc(_capacity, sizeof(NCodecTraceRecord));
+    if (ring->records == NULL) {
+        free(ring);
+        return NULL;
+    }
+    ring->capacity = _capacity;
+    ring->mask = _capacity - 1;
+    return ring;
+}
+
+
+/**
+ncodec_trace_ring_destroy
+=========================
+
+Parameters
+----------
+ring (NCodecTraceRing*)
+: Trace ring object. Any attached Network Codec objects should first be
+  detached (or closed).
+*/
+void ncodec_trace_ring_destroy(NCodecTraceRing* ring)
+{
+    if (ring == NULL) return;
+    free(ring->records);
+    free(ring);
+}
+
+
+/**
+ncodec_trace_attach
+===================
+
+Install the ring buffer trace functions on a Network Codec object. Messages
+written to, and read from, the Network Codec are then recorded in the trace
+ring. Several Network Codec objects may share a trace ring providing that they
+are all operated from the same thread.
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object.
+
+ring (NCodecTraceRing*)
+: Trace ring object.
+
+type (NCodecTraceMessageType)
+: The message type used by the Network Codec object.
+
+Returns
+-------
+0
+: The trace functions were installed.
+
+-ENOSTR (-60)
+: The object represented by `nc` does not represent a valid stream.
+
+-EINVAL (-22)
+: Bad `ring` or `type` argument.
+*/
+int32_t ncodec_trace_attach(
+    NCODEC* nc, NCodecTraceRing* ring, NCodecTraceMessageType type)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) return -ENOSTR;
+    if (ring == NULL) return -EINVAL;
+
+    switch (type) {
+    case NCODEC_TRACE_CAN:
+        _nc->trace.write = trace_can_write;
+        _nc->trace.read = trace_can_read;
+        break;
+    case NCODEC_TRACE_PDU:
+        _nc->trace.write = trace_pdu_write;
+        _nc->trace.read = trace_pdu_read;
+        break;
+    default:
+        return -EINVAL;
+    }
+    _nc->trace.private = ring;
+    return 0;
+}
+
+
+/**
+ncodec_trace_detach
+===================
+
+Remove the trace functions from a Network Codec object.
+
+Parameters
+----------
+nc (NCODEC*)
+: Network Codec object.
+*/
+void ncodec_trace_detach(NCODEC* nc)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL) return;
+    _nc->trace = (struct NCodecTraceVTable){};
+}
+
+
+/**
+ncodec_trace_consume
+====================
+
+Remove trace records from a trace ring (consumer side).
+
+Parameters
+----------
+ring (NCodecTraceRing*)
+: Trace ring object.
+
+records (NCodecTraceRecord*)
+: (out) Array where the consumed records are stored.
+
+count (size_t)
+: The number of elements in the `records` array.
+
+Returns
+-------
+size_t
+: The number of records consumed from the trace ring.
+*/
+size_t ncodec_trace_consume(
+    NCodecTraceRing* ring, NCodecTraceRecord* records, size_t count)
+{
+    if (ring == NULL || records == NULL) return 0;
+
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t   n = (size_t)(head - tail);
+    if (n > count) n = count;
+    for (size_t i = 0; i < n; i++) {
+        records[i] = ring->records[(tail + i) & ring->mask];
+    }
+
+    /* Release the slots back to the producer. */
+    __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+
+/**
+ncodec_trace_drain
+==================
+
+Drain all available trace records from a trace ring to a file. Records are
+written in binary form (see `NCodecTraceRecord`). Intended to be called
+periodically, from a thread other than the thread operating the Network Codec
+objects, or at a convenient point in the simulation step.
+
+Parameters
+----------
+ring (NCodecTraceRing*)
+: Trace ring object.
+
+file (FILE*)
+: The file where the records are written.
+
+Returns
+-------
+size_t
+: The number of records written to the file.
+*/
+size_t ncodec_trace_drain(NCodecTraceRing* ring, FILE* file)
+{
+    if (ring == NULL || file == NULL) return 0;
+
+    NCodecTraceRecord records[DRAIN_CHUNK];
+    size_t            count = 0;
+    size_t            n;
+    while ((n = ncodec_trace_consume(ring, records, DRAIN_CHUNK)) > 0) {
+        count += fwrite(records, sizeof(NCodecTraceRecord), n, file);
+    }
+    return count;
+}
+
+
+/**
+ncodec_trace_dropped
+====================
+
+Parameters
+----------
+ring (NCodecTraceRing*)
+: Trace ring object.
+
+Returns
+-------
+uint64_t
+: The number of trace records dropped because the trace ring was full.
+*/
+uint64_t ncodec_trace_dropped(NCodecTraceRing* ring)
+{
+    if (ring == NULL) return 0;
+    return __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,64 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef DSE_NCODEC_TRACE_H_
+#define DSE_NCODEC_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <dse/ncodec/codec.h>
+
+
+#define NCODEC_TRACE_PAYLOAD_LEN 16
+
+
+typedef enum NCodecTraceDirection {
+    NCODEC_TRACE_RX = 0,
+    NCODEC_TRACE_TX = 1,
+} NCodecTraceDirection;
+
+typedef enum NCodecTraceMessageType {
+    NCODEC_TRACE_CAN = 0, /* NCodecCanMessage */
+    NCODEC_TRACE_PDU = 1, /* NCodecPdu */
+} NCodecTraceMessageType;
+
+
+/* Binary trace record, 40 bytes, written as-is by ncodec_trace_drain(). */
+typedef struct NCodecTraceRecord {
+    uint64_t timestamp; /* CLOCK_MONOTONIC, ns. */
+    uint32_t id;        /* Frame ID or PDU ID. */
+    uint32_t len;       /* Message length (not truncated). */
+    uint8_t  direction; /* NCodecTraceDirection. */
+    uint8_t  payload_len;
+    uint8_t  reserved[6];
+    uint8_t  payload[NCODEC_TRACE_PAYLOAD_LEN];
+} NCodecTraceRecord;
+
+/* Single-producer/single-consumer ring of trace records. */
+typedef struct NCodecTraceRing {
+    NCodecTraceRecord* records;
+    size_t             capacity;
+    size_t             mask;
+    /* Producer (trace functions) and consumer (drain) indexes, padded so
+       that head and tail are never on the same cache line. */
+    uint64_t head;
+    uint64_t dropped;
+    uint8_t  padding[48];
+    uint64_t tail;
+} NCodecTraceRing;
+
+
+/* Provided by trace.c (in this package). */
+DLL_PUBLIC NCodecTraceRing* ncodec_trace_ring_create(size_t capacity);
+DLL_PUBLIC void             ncodec_trace_ring_destroy(NCodecTraceRing* ring);
+DLL_PUBLIC int32_t          ncodec_trace_attach(
+    NCODEC* nc, NCodecTraceRing* ring, NCodecTraceMessageType type);
+DLL_PUBLIC void   ncodec_trace_detach(NCODEC* nc);
+DLL_PUBLIC size_t ncodec_trace_consume(
+    NCodecTraceRing* ring, NCodecTraceRecord* records, size_t count);
+DLL_PUBLIC size_t   ncodec_trace_drain(NCodecTraceRing* ring, FILE* file);
+DLL_PUBLIC uint64_t ncodec_trace_dropped(NCodecTraceRing* ring);
+
+#endif  // DSE_NCODEC_TRACE_H_
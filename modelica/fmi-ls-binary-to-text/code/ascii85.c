@@ -9,14 +9,22 @@
 #include <math.h>
 
 
-char* ascii85_encode(const char* source, size_t source_len)
+/* Length of the buffer required by ascii85_encode_to() (including the NULL
+   terminator). */
+size_t ascii85_encode_len(size_t source_len)
+{
+    return (source_len + 3) / 4 * 5 + 1;
+}
+
+
+/* Encode into `dest`, which must have (at least) the length returned by
+   ascii85_encode_len(). Returns the length of the encoded string. */
+size_t ascii85_encode_to(const char* source, size_t source_len, char* dest)
 {
-    int required = (source_len + 3) / 4 * 5;
     int padding = (source_len % 4) ? 4 - (source_len % 4) : 0;
 
     /* Encode the source. */
-    char* en = calloc(required + 1, sizeof(char));
-    char* en_save = en;
+    char* en = dest;
     while (source_len) {
         uint32_t x = 0;
         for (int chunk = 3; chunk >= 0; chunk--) {
@@ -39,11 +47,18 @@ char* ascii85_encode(const char* source, size_t source_len)
     }
 
     /* Remove (essentially) the padded characters. */
-    for (int i = 1; i <= padding; i++) {
-        en_save[strlen(en_save) - 1] = '\0';
-    }
+    size_t len = (en - dest) - padding;
+    dest[len] = '\0';
+    return len;
+}
+
 
-    return en_save;
+char* ascii85_encode(const char* source, size_t source_len)
+{
+    char* en = calloc(ascii85_encode_len(source_len), sizeof(char));
+    if (en == NULL) return NULL;
+    ascii85_encode_to(source, source_len, en);
+    return en;
 }
 
 
@@ -11,6 +11,27 @@
 
 
 #define HASH_KEY_LEN (10 + 1)
+/* The VR table is dense when its length is within this limit, or within
+   VR_TABLE_SPARSE_FACTOR times the number of indexed VRs. */
+#define VR_TABLE_MIN_LEN       1024
+#define VR_TABLE_SPARSE_FACTOR 8
+#define ARENA_BLOCK_LEN        BUFFER_LEN
+#define ARENA_ALIGN            8
+
+
+extern char*  ascii85_encode(const uint8_t* data, size_t len);
+extern size_t ascii85_encode_to(const uint8_t* data, size_t len, char* dest);
+extern size_t ascii85_encode_len(size_t len);
+
+
+/* Encoders which can encode directly into a (TX arena) buffer. */
+static const struct {
+    EncodeFunc    encode;
+    EncodeToFunc  encode_to;
+    EncodeLenFunc encode_len;
+} __encoders[] = {
+    { ascii85_encode, ascii85_encode_to, ascii85_encode_len },
+};
 
 
 /**
@@ -41,18 +62,166 @@ BusTopology* bus_topology_create(const char* model_xml_path)
     hashmap_init(&bt->tx_vr_index);
     hashmap_init(&bt->encode_func);
     hashmap_init(&bt->decode_func);
-    hashmap_init(&bt->free_list);
 
     return bt;
 }
 
 
+/**
+bus_topology_set_cache
+======================
+
+Set the path of a (binary) cache file for the parsed `modelDescription.xml`
+annotations. Must be called before the first call to `bus_topology_add()`.
+
+When the cache file was written for the same `modelDescription.xml` (i.e. the
+content hash matches), the cache file is memory mapped and the XML parsing is
+skipped entirely. Otherwise the XML is parsed and the cache file is
+(re)written.
+
+Parameters
+----------
+bt (BusTopology*)
+: A `BusTopology` object.
+
+cache_path (const char*)
+: Path of the cache file, NULL to disable the cache.
+*/
+void bus_topology_set_cache(BusTopology* bt, const char* cache_path)
+{
+    assert(bt);
+    bt->cache_path = cache_path;
+}
+
+
+static bool _parse_vr(const char* key, uint32_t* vr)
+{
+    char*         end = NULL;
+    unsigned long v = strtoul(key, &end, 10);
+    if (end == key || *end != '\0' || v > UINT32_MAX) return false;
+    *vr = (uint32_t)v;
+    return true;
+}
+
+
+static void _free_keys(char** keys, uint32_t count)
+{
+    if (keys == NULL) return;
+    for (uint32_t i = 0; i < count; i++) {
+        free(keys[i]);
+    }
+    free(keys);
+}
+
+
+static void _resolve_encoder(BusTopologyVr* e)
+{
+    e->encode_to = NULL;
+    e->encode_len = NULL;
+    if (e->encode == NULL) return;
+    for (size_t i = 0; i < ARRAY_SIZE(__encoders); i++) {
+        if (__encoders[i].encode == e->encode) {
+            e->encode_to = __encoders[i].encode_to;
+            e->encode_len = __encoders[i].encode_len;
+            return;
+        }
+    }
+}
+
+
+static void _index_vr_table(BusTopology* bt, HashMap* index, char** keys,
+    uint32_t count, BusTopologyDirection direction)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t vr;
+        if (_parse_vr(keys[i], &vr) == false) continue;
+        BusTopologyVr* e = &bt->vr_table[vr];
+        e->ncodec = hashmap_get(index, keys[i]);
+        e->direction = direction;
+        if (direction == BUS_TOPOLOGY_RX) {
+            e->decode = hashmap_get(&bt->decode_func, keys[i]);
+        } else {
+            e->encode = hashmap_get(&bt->encode_func, keys[i]);
+            _resolve_encoder(e);
+        }
+    }
+}
+
+
+static void _compile_vr_table(BusTopology* bt)
+{
+    free(bt->vr_table);
+    bt->vr_table = NULL;
+    bt->vr_count = 0;
+
+    uint32_t rx_count = hashmap_number_keys(bt->rx_vr_index);
+    uint32_t tx_count = hashmap_number_keys(bt->tx_vr_index);
+    char**   rx_keys = rx_count ? hashmap_keys(&bt->rx_vr_index) : NULL;
+    char**   tx_keys = tx_count ? hashmap_keys(&bt->tx_vr_index) : NULL;
+
+    /* Size the table from the largest VR. */
+    uint64_t len = 0;
+    for (uint32_t i = 0; i < rx_count + tx_count; i++) {
+        char*    key = (i < rx_count) ? rx_keys[i] : tx_keys[i - rx_count];
+        uint32_t vr;
+        if (_parse_vr(key, &vr) && (uint64_t)vr + 1 > len) len = vr + 1ULL;
+    }
+    uint64_t limit = (uint64_t)(rx_count + tx_count) * VR_TABLE_SPARSE_FACTOR;
+    if (limit < VR_TABLE_MIN_LEN) limit = VR_TABLE_MIN_LEN;
+    if (len == 0 || len > limit) goto sparse;
+
+    bt->vr_table = calloc(len, sizeof(BusTopologyVr));
+    if (bt->vr_table == NULL) goto sparse;
+    bt->vr_count = (uint32_t)len;
+    _index_vr_table(bt, &bt->rx_vr_index, rx_keys, rx_count, BUS_TOPOLOGY_RX);
+    _index_vr_table(bt, &bt->tx_vr_index, tx_keys, tx_count, BUS_TOPOLOGY_TX);
+
+sparse:
+    _free_keys(rx_keys, rx_count);
+    _free_keys(tx_keys, tx_count);
+}
+
+
+static BusTopologyVr* _lookup_vr(BusTopology* bt, uint32_t vr,
+    BusTopologyDirection direction, BusTopologyVr* entry)
+{
+    if (bt->vr_table) {
+        if (vr >= bt->vr_count) return NULL;
+        BusTopologyVr* e = &bt->vr_table[vr];
+        return (e->direction == direction) ? e : NULL;
+    }
+
+    /* Sparse VRs, locate the codec from the hashmap indexes. */
+    char key[HASH_KEY_LEN];
+    snprintf(key, HASH_KEY_LEN, "%u", vr);
+    *entry = (BusTopologyVr){ .direction = direction };
+    if (direction == BUS_TOPOLOGY_RX) {
+        entry->ncodec = hashmap_get(&bt->rx_vr_index, key);
+        entry->decode = hashmap_get(&bt->decode_func, key);
+    } else {
+        entry->ncodec = hashmap_get(&bt->tx_vr_index, key);
+        entry->encode = hashmap_get(&bt->encode_func, key);
+        _resolve_encoder(entry);
+    }
+    return entry->ncodec ? entry : NULL;
+}
+
+
 /**
 bus_topology_add
 ================
 
 Add a Bus Topology for the specified `bus_id` and `ncodec`.
 
+The `modelDescription.xml` file is parsed once, by the first call, and the
+parsed annotations are retained for subsequent calls (i.e. other busses). When
+a cache is configured (see `bus_topology_set_cache()`) the annotations may
+instead be loaded from the cache file. The parsed annotations are shared (read
+only) with other `BusTopology` objects, in the same process, which are created
+for the same (unchanged) `modelDescription.xml` file.
+The topology (of all added busses) is then compiled into a VR indexed table
+which is used by `bus_topology_rx()` and `bus_topology_tx()`.
+
 Parameters
 ----------
 bt (BusTopology*)
@@ -67,10 +236,13 @@ ncodec (void*)
 void bus_topology_add(BusTopology* bt, const char* bus_id, void* ncodec)
 {
     hashmap_set(&bt->bus_ncodec, bus_id, ncodec);
-    parse_bus_topology(
-        bt->model_xml_path, bus_id, ncodec, &bt->rx_vr_index, &bt->tx_vr_index);
-    parse_binary_to_text(
-        bt->model_xml_path, &bt->encode_func, &bt->decode_func);
+    if (bt->model == NULL) {
+        bt->model = cache_acquire(bt->model_xml_path, bt->cache_path);
+        index_binary_to_text(bt->model, &bt->encode_func, &bt->decode_func);
+    }
+    index_bus_topology(
+        bt->model, bus_id, ncodec, &bt->rx_vr_index, &bt->tx_vr_index);
+    _compile_vr_table(bt);
 }
 
 
@@ -85,6 +257,9 @@ of the indexed Network Codec.
 If a `binary-to-text` encoder is configured, the text is decoded during the
 copy operation.
 
+Any asynchronous flush operations of the Network Codec are completed before
+the `stream` object is accessed.
+
 Parameters
 ----------
 bt (BusTopology*)
@@ -98,32 +273,110 @@ data (uint8_t*)
 
 len (size_t)
 : Length of the data being exchanged.
+
+Returns
+-------
+0
+: The data was written to the `stream` object (or no index entry exists).
+
+-EMSGSIZE (-90)
+: The `stream` object overflowed, the data was not written.
 */
-void bus_topology_rx(BusTopology* bt, uint32_t vr, uint8_t* data, size_t len)
+int32_t bus_topology_rx(
+    BusTopology* bt, uint32_t vr, uint8_t* data, size_t len)
 {
     assert(bt);
 
     /* Locate the codec. */
-    char key[HASH_KEY_LEN];
-    snprintf(key, HASH_KEY_LEN, "%u", vr);
-    NCodecInstance* ncodec = hashmap_get(&bt->rx_vr_index, key);
-    if (ncodec == NULL || ncodec->stream == NULL) return;
+    BusTopologyVr  _e;
+    BusTopologyVr* e = _lookup_vr(bt, vr, BUS_TOPOLOGY_RX, &_e);
+    if (e == NULL) return 0;
+    NCodecInstance* ncodec = e->ncodec;
+    if (ncodec == NULL || ncodec->stream == NULL) return 0;
     NCodecStreamVTable* stream = (NCodecStreamVTable*)ncodec->stream;
+    ncodec_sync((NCODEC*)ncodec);
 
     /* Write (append) the RX data directly to the underlying stream. */
-    DecodeFunc df = hashmap_get(&bt->decode_func, key);
+    size_t     rc;
+    DecodeFunc df = e->decode;
     if (df) {
         /* Use encoder if configured. */
         data = df((char*)data, &len);
         stream->seek((NCODEC*)ncodec, 0, NCODEC_SEEK_END);
-        stream->write((NCODEC*)ncodec, data, len);
+        rc = stream->write((NCODEC*)ncodec, data, len);
         stream->seek((NCODEC*)ncodec, 0, NCODEC_SEEK_SET);
         free(data);
     } else {
         stream->seek((NCODEC*)ncodec, 0, NCODEC_SEEK_END);
-        stream->write((NCODEC*)ncodec, data, len);
+        rc = stream->write((NCODEC*)ncodec, data, len);
         stream->seek((NCODEC*)ncodec, 0, NCODEC_SEEK_SET);
     }
+    return (rc == len) ? 0 : -EMSGSIZE;
+}
+
+
+static BusTopologyArenaBlock* _arena_block(size_t capacity)
+{
+    BusTopologyArenaBlock* block =
+        malloc(sizeof(BusTopologyArenaBlock) + capacity);
+    if (block == NULL) return NULL;
+    block->next = NULL;
+    block->capacity = capacity;
+    block->len = 0;
+    return block;
+}
+
+
+static void* _arena_alloc(BusTopology* bt, size_t len)
+{
+    len = (len + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    BusTopologyArenaBlock* block = bt->arena;
+    if (block == NULL || block->capacity - block->len < len) {
+        /* Add a block, previous blocks are retained until the reset. */
+        size_t capacity = block ? block->capacity * 2 : ARENA_BLOCK_LEN;
+        if (capacity < len) capacity = len;
+        BusTopologyArenaBlock* _ = _arena_block(capacity);
+        if (_ == NULL) return NULL;
+        _->next = block;
+        bt->arena = block = _;
+    }
+    void* p = &block->data[block->len];
+    block->len += len;
+    return p;
+}
+
+
+static void _arena_reset(BusTopology* bt)
+{
+    BusTopologyArenaBlock* block = bt->arena;
+    if (block == NULL) return;
+    if (block->next == NULL) {
+        block->len = 0;
+        return;
+    }
+
+    /* The step needed several blocks, replace them with one block which
+       can hold the entire step. */
+    size_t capacity = 0;
+    while (block) {
+        BusTopologyArenaBlock* next = block->next;
+        capacity += block->capacity;
+        free(block);
+        block = next;
+    }
+    bt->arena = _arena_block(capacity);
+}
+
+
+static void _arena_destroy(BusTopology* bt)
+{
+    BusTopologyArenaBlock* block = bt->arena;
+    while (block) {
+        BusTopologyArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    bt->arena = NULL;
 }
 
 
@@ -138,6 +391,12 @@ Network Codec to the Variable .
 If a `binary-to-text` encoder is configured, the text is encoded during the
 copy operation.
 
+The returned data is allocated from an arena owned by the `BusTopology`
+object, and remains valid until the next call to `bus_topology_reset()`.
+
+Any asynchronous flush operations of the Network Codec are completed before
+the `stream` object is accessed.
+
 Parameters
 ----------
 bt (BusTopology*)
@@ -158,36 +417,39 @@ void bus_topology_tx(BusTopology* bt, uint32_t vr, uint8_t** data, size_t* len)
     bt->reset_called = false; /* Indicate that reset is pending. */
 
     /* Locate the codec. */
-    char key[HASH_KEY_LEN];
-    snprintf(key, HASH_KEY_LEN, "%u", vr);
-    NCodecInstance* ncodec = hashmap_get(&bt->tx_vr_index, key);
+    BusTopologyVr  _e;
+    BusTopologyVr* e = _lookup_vr(bt, vr, BUS_TOPOLOGY_TX, &_e);
+    if (e == NULL) return;
+    NCodecInstance* ncodec = e->ncodec;
     if (ncodec == NULL || ncodec->stream == NULL) return;
     NCodecStreamVTable* stream = (NCodecStreamVTable*)ncodec->stream;
 
-    /* Read the TX data directly from the underlying stream. */
+    /* Wait for any asynchronous flush (flush=async) to complete, then read
+       the TX data directly from the underlying stream. */
+    ncodec_sync((NCODEC*)ncodec);
     uint8_t* _ = NULL;
     uint8_t* tx_data = NULL;
     size_t   tx_len = 0;
     stream->seek((NCODEC*)ncodec, 0, NCODEC_SEEK_SET);
     stream->read((NCODEC*)ncodec, &_, &tx_len, NCODEC_POS_UPDATE);
-    tx_data = malloc(tx_len);
-    memcpy(tx_data, _, tx_len);
 
-    /* Return the data. */
-    EncodeFunc ef = hashmap_get(&bt->encode_func, key);
-    if (ef) {
-        /* Use encoder if configured. */
-        void* _ = tx_data;
-        tx_data = (uint8_t*)ef(_, tx_len);
-        tx_len = strlen((char*)tx_data);
-        free(_);
+    /* Copy (or encode) the data into the arena. */
+    if (e->encode_to) {
+        /* Encode directly from the stream. */
+        tx_data = _arena_alloc(bt, e->encode_len(tx_len));
+        if (tx_data) tx_len = e->encode_to(_, tx_len, (char*)tx_data);
+    } else if (e->encode) {
+        char* text = e->encode(_, tx_len);
+        tx_len = text ? strlen(text) : 0;
+        tx_data = text ? _arena_alloc(bt, tx_len + 1) : NULL;
+        if (tx_data) memcpy(tx_data, text, tx_len + 1);
+        free(text);
+    } else {
+        tx_data = _arena_alloc(bt, tx_len);
+        if (tx_data) memcpy(tx_data, _, tx_len);
     }
     *data = tx_data;
-    *len = tx_len;
-
-    /* Save reference for later free. */
-    snprintf(key, HASH_KEY_LEN, "%lu", bt->free_list.used_nodes);
-    hashmap_set_alt(&bt->free_list, key, tx_data);
+    *len = tx_data ? tx_len : 0;
 }
 
 
@@ -203,8 +465,8 @@ static int _reset_ncodec(void* map_item, void* data)
 bus_topology_reset
 ==================
 
-Reset the underlying binary streams and free any memory allocated for
-the FMI Variable interface (e.g. during TX operations).
+Reset the underlying binary streams and release any memory allocated for
+the FMI Variable interface (i.e. the TX arena, in bulk).
 
 This method is called at the beginning of a Rx cycle. Internally it maintains
 state so that the resources are only reset once-per-Rx-cycle.
@@ -220,7 +482,7 @@ void bus_topology_reset(BusTopology* bt)
     if (bt->reset_called) return;
 
     hashmap_iterator(&bt->bus_ncodec, _reset_ncodec, true, NULL);
-    hashmap_clear(&bt->free_list);
+    _arena_reset(bt);
     bt->reset_called = true;
 }
 
@@ -254,7 +516,9 @@ void bus_topology_destroy(BusTopology* bt)
     hashmap_destroy(&bt->tx_vr_index);
     hashmap_destroy(&bt->encode_func);
     hashmap_destroy(&bt->decode_func);
-    hashmap_destroy(&bt->free_list);
+    _arena_destroy(bt);
+    cache_release(bt->model);
+    free(bt->vr_table);
 
     free(bt);
 }
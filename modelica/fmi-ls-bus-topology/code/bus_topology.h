@@ -11,50 +11,139 @@
 #include <dse/ncodec/codec.h>
 
 
-#define UNUSED(x)     ((void)x)
-#define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
-#define BUFFER_LEN    (1024 * 4)
+#define UNUSED(x)      ((void)x)
+#define ARRAY_SIZE(x)  (sizeof(x) / sizeof(x[0]))
+#define BUFFER_LEN     (1024 * 4)
+#define BUFFER_MAX_LEN (1024 * 1024 * 4)
 
 
+typedef char* (*EncodeFunc)(const uint8_t* data, size_t len);
+typedef uint8_t* (*DecodeFunc)(const char* source, size_t* len);
+typedef size_t (*EncodeToFunc)(const uint8_t* data, size_t len, char* dest);
+typedef size_t (*EncodeLenFunc)(size_t len);
+
+typedef enum BusTopologyDirection {
+    BUS_TOPOLOGY_NONE = 0, /* No index entry for the VR. */
+    BUS_TOPOLOGY_RX,
+    BUS_TOPOLOGY_TX,
+} BusTopologyDirection;
+
+/* Annotations of a ScalarVariable (with causality input or output). */
+typedef struct BusTopologyAnnotation {
+    uint32_t             vr;
+    BusTopologyDirection direction; /* Causality input (RX), output (TX). */
+    char*                bus_id;    /* dse.standards.fmi-ls-bus-topology */
+    char*                encoding;  /* dse.standards.fmi-ls-binary-to-text */
+} BusTopologyAnnotation;
+
+/* Annotated ScalarVariables of a modelDescription.xml file. */
+typedef struct BusTopologyModel {
+    BusTopologyAnnotation* annotations;
+    size_t                 count;
+    size_t                 capacity;
+    /* Cache file mapping (see cache_load()), when set the annotation strings
+       reference the mapping. */
+    void*                  map;
+    size_t                 map_len;
+} BusTopologyModel;
+
+/* Compiled index entry of a VR (FMI Value Reference). */
+typedef struct BusTopologyVr {
+    NCodecInstance*      ncodec;
+    BusTopologyDirection direction;
+    EncodeFunc           encode;
+    DecodeFunc           decode;
+    /* Encode directly into a buffer (of encode_len() bytes), when supported
+       by the encoder. */
+    EncodeToFunc         encode_to;
+    EncodeLenFunc        encode_len;
+} BusTopologyVr;
+
+/* Block of the per-step TX arena, see bus_topology_tx(). */
+typedef struct BusTopologyArenaBlock {
+    struct BusTopologyArenaBlock* next;
+    size_t                        capacity;
+    size_t                        len;
+    uint8_t                       data[];
+} BusTopologyArenaBlock;
+
 typedef struct BusTopology {
-    const char* model_xml_path;
-    HashMap     bus_ncodec;
-    HashMap     rx_vr_index;
-    HashMap     tx_vr_index;
-    HashMap     encode_func;
-    HashMap     decode_func;
-    HashMap     free_list;
-    bool        reset_called;
+    const char*            model_xml_path;
+    const char*            cache_path;
+    HashMap                bus_ncodec;
+    HashMap                rx_vr_index;
+    HashMap                tx_vr_index;
+    HashMap                encode_func;
+    HashMap                decode_func;
+    bool                   reset_called;
+    /* Arena for the TX data of a step, released by bus_topology_reset(). */
+    BusTopologyArenaBlock* arena;
+    /* Annotations parsed (once) by the first call to bus_topology_add(),
+       shared with other BusTopology objects (see cache_acquire()). */
+    BusTopologyModel*      model;
+    /* Index compiled by bus_topology_add(), indexed by VR. NULL when the
+       VRs are too sparse, the hashmap indexes are used instead. */
+    BusTopologyVr*         vr_table;
+    uint32_t               vr_count;
 } BusTopology;
 
 typedef struct BufferStream {
     NCodecStreamVTable s;
-    uint8_t            buffer[BUFFER_LEN];
+    uint8_t*           buffer;
     size_t             buffer_len;
+    size_t             buffer_max_len;
     size_t             len;
     size_t             pos;
+    /* Position up to which the stream was consumed by stream_read() (with
+       NCODEC_POS_UPDATE), this region may be compacted when the buffer is at
+       its maximum length. */
+    size_t             read_pos;
+    /* A reader references the buffer (stream_read() with NCODEC_POS_NC), the
+       buffer is not moved or compacted until the stream is reset
+       (NCODEC_SEEK_RESET). Instead, the buffer grows into a new buffer and
+       the previous buffer is retired (and released at the reset). */
+    bool               reading;
+    uint8_t**          retired;
+    size_t             retired_count;
+    /* Count of writes which did not fit the buffer (-EMSGSIZE). */
+    size_t             overflow_count;
 } BufferStream;
 
-typedef char* (*EncodeFunc)(const uint8_t* data, size_t len);
-typedef uint8_t* (*DecodeFunc)(const char* source, size_t* len);
-
 
 /* bus_topology.c */
 BusTopology* bus_topology_create(const char* model_xml_path);
+void bus_topology_set_cache(BusTopology* bt, const char* cache_path);
 void bus_topology_add(BusTopology* bt, const char* bus_id, void* bus_ncodec);
-void bus_topology_rx(BusTopology* bt, uint32_t vr, uint8_t* data, size_t len);
+int32_t bus_topology_rx(
+    BusTopology* bt, uint32_t vr, uint8_t* data, size_t len);
 void bus_topology_tx(BusTopology* bt, uint32_t vr, uint8_t** data, size_t* len);
 void bus_topology_reset(BusTopology* bt);
 void bus_topology_destroy(BusTopology* bt);
 
 /* parser.c */
+BusTopologyModel* parse_model_description(const char* model_description_path);
+void parse_model_free(BusTopologyModel* model);
+void index_bus_topology(BusTopologyModel* model, const char* bus_id,
+    void* bus_object, HashMap* rx, HashMap* tx);
+void index_binary_to_text(
+    BusTopologyModel* model, HashMap* encode_func, HashMap* decode_func);
 void parse_bus_topology(const char* model_description_path, const char* bus_id,
     void* bus_object, HashMap* rx, HashMap* tx);
 void parse_binary_to_text(const char* model_description_path,
     HashMap* encode_func, HashMap* decode_func);
 
+/* cache.c */
+int32_t cache_hash_file(const char* path, uint64_t* hash);
+BusTopologyModel* cache_load(const char* cache_path, uint64_t hash);
+int32_t cache_store(
+    const char* cache_path, uint64_t hash, BusTopologyModel* model);
+BusTopologyModel* cache_acquire(
+    const char* model_xml_path, const char* cache_path);
+void cache_release(BusTopologyModel* model);
+
 /* stream.c */
-void* stream_create(void);
+void* stream_create(size_t max_len);
+void  stream_destroy(void* stream);
 
 
 #endif  // MODELICA_FMI_LS_BUS_TOPOLOGY_CODE_BUS_TOPOLOGY_H_
@@ -0,0 +1,458 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <bus_topology.h>
+
+
+#define CACHE_MAGIC   "BUSTOPO"
+#define CACHE_VERSION 1
+#define CACHE_NO_STR  UINT32_MAX
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME        0x100000001b3ULL
+
+
+/* Cache file layout:
+       CacheHeader
+       CacheRecord[count]
+       char strings[strings_len]  (NUL terminated strings)
+*/
+typedef struct CacheHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t hash; /* Content hash of the modelDescription.xml file. */
+    uint32_t count;
+    uint32_t strings_len;
+} CacheHeader;
+
+typedef struct CacheRecord {
+    uint32_t vr;
+    uint32_t direction;
+    uint32_t bus_id;   /* Offset in strings, or CACHE_NO_STR. */
+    uint32_t encoding; /* Offset in strings, or CACHE_NO_STR. */
+} CacheRecord;
+
+/* Process wide list of shared (read only) models, see cache_acquire(). */
+typedef struct CacheEntry {
+    char*              model_xml_path;
+    uint64_t           hash;
+    BusTopologyModel*  model;
+    size_t             ref_count;
+    struct CacheEntry* next;
+} CacheEntry;
+
+static CacheEntry*     __entries = NULL;
+static pthread_mutex_t __entries_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/**
+cache_hash_file
+===============
+
+Calculate the content hash (FNV-1a, 64 bit) of a file.
+
+Parameters
+----------
+path (const char*)
+: Path of the file to hash.
+
+hash (uint64_t*)
+: (out) The content hash.
+
+Returns
+-------
+0
+: The hash was calculated.
+
+-errno
+: The file could not be read.
+*/
+int32_t cache_hash_file(const char* path, uint64_t* hash)
+{
+    if (path == NULL || hash == NULL) return -EINVAL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -errno;
+    struct stat st;
+    if (fstat(fd, &st)) {
+        int32_t rc = -errno;
+        close(fd);
+        return rc;
+    }
+
+    uint64_t h = FNV_OFFSET_BASIS;
+    if (st.st_size > 0) {
+        uint8_t* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            int32_t rc = -errno;
+            close(fd);
+            return rc;
+        }
+        for (off_t i = 0; i < st.st_size; i++) {
+            h ^= data[i];
+            h *= FNV_PRIME;
+        }
+        munmap(data, st.st_size);
+    }
+    close(fd);
+    *hash = h;
+    return 0;
+}
+
+
+static const char* _cache_str(
+    const char* strings, uint32_t strings_len, uint32_t offset, bool* valid)
+{
+    if (offset == CACHE_NO_STR) return NULL;
+    if (offset >= strings_len) *valid = false;
+    return *valid ? &strings[offset] : NULL;
+}
+
+
+/**
+cache_load
+==========
+
+Load a model from a cache file (written by `cache_store()`). The cache file
+is memory mapped, and the annotation strings of the returned model reference
+the mapping directly.
+
+Parameters
+----------
+cache_path (const char*)
+: Path of the cache file.
+
+hash (uint64_t)
+: Content hash of the `modelDescription.xml` file (see `cache_hash_file()`).
+
+Returns
+-------
+BusTopologyModel*
+: The cached model, release with `parse_model_free()`.
+
+NULL
+: The cache file does not exist, is invalid, or was written for a different
+  `modelDescription.xml` file (hash mismatch). Inspect `errno` for details.
+*/
+BusTopologyModel* cache_load(const char* cache_path, uint64_t hash)
+{
+    if (cache_path == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    int fd = open(cache_path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(CacheHeader)) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    size_t map_len = st.st_size;
+    void*  map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    /* Validate the header. */
+    const CacheHeader* header = map;
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) ||
+        header->version != CACHE_VERSION ||
+        header->record_size != sizeof(CacheRecord)) {
+        errno = EINVAL;
+        goto load_fail;
+    }
+    if (header->hash != hash) {
+        errno = ESTALE;
+        goto load_fail;
+    }
+    if (map_len != sizeof(CacheHeader) +
+                       (size_t)header->count * sizeof(CacheRecord) +
+                       header->strings_len ||
+        (header->strings_len &&
+            ((char*)map)[map_len - 1] != '\0')) {
+        errno = EINVAL;
+        goto load_fail;
+    }
+
+    /* Build the model, strings reference the mapping. */
+    const CacheRecord* records = (const CacheRecord*)(header + 1);
+    const char*        strings = (const char*)(records + header->count);
+    BusTopologyModel*  model = calloc(1, sizeof(BusTopologyModel));
+    if (model == NULL) goto load_fail;
+    model->map = map;
+    model->map_len = map_len;
+    if (header->count) {
+        model->annotations =
+            calloc(header->count, sizeof(BusTopologyAnnotation));
+        if (model->annotations == NULL) {
+            parse_model_free(model);
+            errno = ENOMEM;
+            return NULL;
+        }
+        model->capacity = header->count;
+    }
+    bool valid = true;
+    for (uint32_t i = 0; i < header->count; i++) {
+        const CacheRecord* r = &records[i];
+        model->annotations[i] = (BusTopologyAnnotation){
+            .vr = r->vr,
+            .direction = r->direction,
+            .bus_id = (char*)_cache_str(
+                strings, header->strings_len, r->bus_id, &valid),
+            .encoding = (char*)_cache_str(
+                strings, header->strings_len, r->encoding, &valid),
+        };
+    }
+    model->count = header->count;
+    if (valid == false) {
+        parse_model_free(model);
+        errno = EINVAL;
+        return NULL;
+    }
+    return model;
+
+load_fail:
+    munmap(map, map_len);
+    return NULL;
+}
+
+
+static uint32_t _store_str(
+    FILE* f, const char* s, size_t* strings_len, bool write)
+{
+    if (s == NULL) return CACHE_NO_STR;
+    size_t offset = *strings_len;
+    size_t len = strlen(s) + 1;
+    if (write) fwrite(s, 1, len, f);
+    *strings_len += len;
+    return (uint32_t)offset;
+}
+
+
+/**
+cache_store
+===========
+
+Store a model in a cache file. The cache file is first written to a
+temporary file and then renamed, so that concurrent readers (other FMU
+instances) only see a complete cache file.
+
+Parameters
+----------
+cache_path (const char*)
+: Path of the cache file.
+
+hash (uint64_t)
+: Content hash of the `modelDescription.xml` file (see `cache_hash_file()`).
+
+model (BusTopologyModel*)
+: Model returned by `parse_model_description()`.
+
+Returns
+-------
+0
+: The cache file was written.
+
+-errno
+: The cache file could not be written.
+*/
+int32_t cache_store(
+    const char* cache_path, uint64_t hash, BusTopologyModel* model)
+{
+    if (cache_path == NULL || model == NULL) return -EINVAL;
+    if (model->count > UINT32_MAX) return -EOVERFLOW;
+
+    size_t tmp_path_len = strlen(cache_path) + 32;
+    char*  tmp_path = malloc(tmp_path_len);
+    if (tmp_path == NULL) return -ENOMEM;
+    snprintf(tmp_path, tmp_path_len, "%s.%ld.tmp", cache_path, (long)getpid());
+    FILE* f = fopen(tmp_path, "wb");
+    if (f == NULL) {
+        int32_t rc = -errno;
+        free(tmp_path);
+        return rc;
+    }
+
+    /* Header (strings_len is calculated from the annotations). */
+    size_t strings_len = 0;
+    for (size_t i = 0; i < model->count; i++) {
+        BusTopologyAnnotation* a = &model->annotations[i];
+        _store_str(f, a->bus_id, &strings_len, false);
+        _store_str(f, a->encoding, &strings_len, false);
+    }
+    if (strings_len >= CACHE_NO_STR) {
+        fclose(f);
+        unlink(tmp_path);
+        free(tmp_path);
+        return -EOVERFLOW;
+    }
+    CacheHeader header = {
+        .version = CACHE_VERSION,
+        .record_size = sizeof(CacheRecord),
+        .hash = hash,
+        .count = (uint32_t)model->count,
+        .strings_len = (uint32_t)strings_len,
+    };
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    fwrite(&header, sizeof(CacheHeader), 1, f);
+
+    /* Records. */
+    strings_len = 0;
+    for (size_t i = 0; i < model->count; i++) {
+        BusTopologyAnnotation* a = &model->annotations[i];
+        CacheRecord            r = { .vr = a->vr };
+        r.direction = a->direction;
+        r.bus_id = _store_str(f, a->bus_id, &strings_len, false);
+        r.encoding = _store_str(f, a->encoding, &strings_len, false);
+        fwrite(&r, sizeof(CacheRecord), 1, f);
+    }
+
+    /* Strings. */
+    strings_len = 0;
+    for (size_t i = 0; i < model->count; i++) {
+        BusTopologyAnnotation* a = &model->annotations[i];
+        _store_str(f, a->bus_id, &strings_len, true);
+        _store_str(f, a->encoding, &strings_len, true);
+    }
+
+    int32_t rc = 0;
+    if (ferror(f)) rc = -EIO;
+    if (fclose(f) && rc == 0) rc = -errno;
+    if (rc == 0 && rename(tmp_path, cache_path)) rc = -errno;
+    if (rc) unlink(tmp_path);
+    free(tmp_path);
+    return rc;
+}
+
+
+static BusTopologyModel* _load_model(
+    const char* model_xml_path, const char* cache_path, uint64_t hash)
+{
+    if (cache_path == NULL) return parse_model_description(model_xml_path);
+
+    BusTopologyModel* model = cache_load(cache_path, hash);
+    if (model) return model;
+    model = parse_model_description(model_xml_path);
+    /* Write the cache (best effort, the cache location may be read-only). */
+    if (model) cache_store(cache_path, hash, model);
+    return model;
+}
+
+
+/**
+cache_acquire
+=============
+
+Acquire the (read only) model of a `modelDescription.xml` file. The model is
+shared by all callers, in the same process, which acquire a model for the
+same `model_xml_path` and file content (hash). The first caller loads the
+model, either from the cache file (when configured) or by parsing the
+`modelDescription.xml` file. Each call must be paired with a call to
+`cache_release()`.
+
+Parameters
+----------
+model_xml_path (const char*)
+: Path of `modelDescription.xml` file.
+
+cache_path (const char*)
+: Path of the cache file, or NULL (see `cache_load()` and `cache_store()`).
+
+Returns
+-------
+BusTopologyModel*
+: The shared model, release with `cache_release()`.
+
+NULL
+: The model could not be loaded, inspect `errno` for details.
+*/
+BusTopologyModel* cache_acquire(
+    const char* model_xml_path, const char* cache_path)
+{
+    if (model_xml_path == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    uint64_t hash;
+    int32_t  rc = cache_hash_file(model_xml_path, &hash);
+    if (rc) {
+        errno = -rc;
+        return NULL;
+    }
+
+    pthread_mutex_lock(&__entries_lock);
+    for (CacheEntry* e = __entries; e; e = e->next) {
+        if (e->hash == hash && strcmp(e->model_xml_path, model_xml_path) == 0) {
+            e->ref_count++;
+            pthread_mutex_unlock(&__entries_lock);
+            return e->model;
+        }
+    }
+
+    /* Load the model (with the lock held, so concurrent callers wait for
+       this model rather than also loading it). */
+    BusTopologyModel* model = NULL;
+    CacheEntry*       e = calloc(1, sizeof(CacheEntry));
+    if (e == NULL) goto acquire_unlock;
+    e->model_xml_path = strdup(model_xml_path);
+    e->model = _load_model(model_xml_path, cache_path, hash);
+    if (e->model_xml_path == NULL || e->model == NULL) {
+        parse_model_free(e->model);
+        free(e->model_xml_path);
+        free(e);
+        goto acquire_unlock;
+    }
+    e->hash = hash;
+    e->ref_count = 1;
+    e->next = __entries;
+    __entries = e;
+    model = e->model;
+
+acquire_unlock:
+    pthread_mutex_unlock(&__entries_lock);
+    return model;
+}
+
+
+/**
+cache_release
+=============
+
+Release a model acquired with `cache_acquire()`. The model is freed when it
+is released by all callers.
+
+Parameters
+----------
+model (BusTopologyModel*)
+: The model to release.
+*/
+void cache_release(BusTopologyModel* model)
+{
+    if (model == NULL) return;
+
+    pthread_mutex_lock(&__entries_lock);
+    for (CacheEntry** _e = &__entries; *_e; _e = &(*_e)->next) {
+        CacheEntry* e = *_e;
+        if (e->model != model) continue;
+        if (--e->ref_count == 0) {
+            *_e = e->next;
+            parse_model_free(e->model);
+            free(e->model_xml_path);
+            free(e);
+        }
+        break;
+    }
+    pthread_mutex_unlock(&__entries_lock);
+}
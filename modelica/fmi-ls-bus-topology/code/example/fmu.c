@@ -83,6 +83,7 @@ typedef struct Fmu2InstanceData {
     /* Bus Topology. */
     BusTopology* bus_topology;
     NCODEC*      bus_ncodec;
+    void*        bus_stream;
 } Fmu2InstanceData;
 
 fmi2Component fmi2Instantiate(fmi2String instance_name, fmi2Type fmu_type,
@@ -144,7 +145,8 @@ fmi2Status fmi2ExitInitializationMode(fmi2Component c)
     /* Setup the Bus Topology. */
     _log("Create BusTopology object");
     fmu->bus_topology = bus_topology_create(fmu->instance.model_xml_path);
-    fmu->bus_ncodec = ncodec_open(MIMETYPE, stream_create());
+    fmu->bus_stream = stream_create(BUFFER_MAX_LEN);
+    fmu->bus_ncodec = ncodec_open(MIMETYPE, fmu->bus_stream);
     char* bus_id = __get_ncodec_bus_id(fmu->bus_ncodec);
     if (bus_id) {
         _log("Configure Bus/Network : %s", bus_id);
@@ -181,12 +183,18 @@ fmi2Status fmi2SetString(fmi2Component c, const fmi2ValueReference vr[],
     assert(bt);
 
     /* Set is Bus RX (FMI String -> ncodec/stream). */
+    fmi2Status status = fmi2OK;
     bus_topology_reset(bt);
     for (size_t i = 0; i < nvr; i++) {
         if (value[i] == NULL) continue;
-        bus_topology_rx(bt, vr[i], (uint8_t*)value[i], strlen(value[i]));
+        int32_t rc = bus_topology_rx(
+            bt, vr[i], (uint8_t*)value[i], strlen(value[i]));
+        if (rc) {
+            _log("Bus RX overflow (vr=%u), data dropped", vr[i]);
+            status = fmi2Warning;
+        }
     }
-    return fmi2OK;
+    return status;
 }
 
 // TODO Relocate this to a FMI String Variable (parameter).
@@ -219,7 +227,10 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint,
     ncodec_write(ncodec, &(struct NCodecCanMessage){ .frame_id = 42,
                              .buffer = (uint8_t*)GREETING,
                              .len = strlen(GREETING) });
-    ncodec_flush(ncodec);
+    if (ncodec_flush(ncodec) < 0) {
+        _log("Bus TX overflow, data dropped");
+        return fmi2Warning;
+    }
 
     return fmi2OK;
 }
@@ -230,6 +241,7 @@ void fmi2FreeInstance(fmi2Component c)
     Fmu2InstanceData* fmu = (Fmu2InstanceData*)c;
 
     bus_topology_destroy(fmu->bus_topology);
+    stream_destroy(fmu->bus_stream);
     free(fmu->instance.name);
     free(fmu->instance.guid);
     free(fmu->instance.save_resource_location);
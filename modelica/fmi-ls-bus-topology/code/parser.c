@@ -3,81 +3,343 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <assert.h>
+#include <errno.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <libxml/xpath.h>
+#include <sys/mman.h>
+#include <libxml/xmlreader.h>
 #include <dse/clib/collections/hashmap.h>
+#include <bus_topology.h>
+
+
+#define HASH_KEY_LEN        (10 + 1)
+#define ANNOTATION_CAPACITY 64
+
+#define TOOL_BUS_TOPOLOGY   "dse.standards.fmi-ls-bus-topology"
+#define TOOL_BINARY_TO_TEXT "dse.standards.fmi-ls-binary-to-text"
 
 
 extern char*    ascii85_encode(const uint8_t* data, size_t len);
 extern uint8_t* ascii85_decode(const char* source, size_t* len);
 
 
+/* Parser state, the ScalarVariable (and Tool) being parsed. */
+typedef struct ParseState {
+    bool                  root;      /* Root is fmiModelDescription. */
+    bool                  variables; /* In ModelVariables (of the root). */
+    int                   var_depth; /* -1, not in a ScalarVariable. */
+    BusTopologyAnnotation var;
+    xmlChar*              tool;
+} ParseState;
+
+
+static bool _name_equal(const xmlChar* name, const char* value)
+{
+    return name && strcmp((const char*)name, value) == 0;
+}
+
+
+static void _begin_variable(
+    xmlTextReaderPtr reader, ParseState* state, int depth)
+{
+    xmlChar* vr = xmlTextReaderGetAttribute(reader, (xmlChar*)"valueReference");
+    xmlChar* causality =
+        xmlTextReaderGetAttribute(reader, (xmlChar*)"causality");
+    xmlChar* name = xmlTextReaderGetAttribute(reader, (xmlChar*)"name");
+
+    state->var = (BusTopologyAnnotation){ 0 };
+    state->var_depth = -1;
+    if (name == NULL || vr == NULL || causality == NULL) goto next;
+
+    char*         end = NULL;
+    unsigned long v = strtoul((char*)vr, &end, 10);
+    if (end == (char*)vr || *end != '\0' || v > UINT32_MAX) goto next;
+    state->var.vr = (uint32_t)v;
+    if (_name_equal(causality, "input")) {
+        state->var.direction = BUS_TOPOLOGY_RX;
+    } else if (_name_equal(causality, "output")) {
+        state->var.direction = BUS_TOPOLOGY_TX;
+    } else {
+        goto next;
+    }
+    state->var_depth = depth;
+
+next:
+    xmlFree(name);
+    xmlFree(vr);
+    xmlFree(causality);
+}
+
+
+static int _end_variable(BusTopologyModel* model, ParseState* state)
+{
+    BusTopologyAnnotation* var = &state->var;
+    state->var_depth = -1;
+    xmlFree(state->tool);
+    state->tool = NULL;
+    if (var->bus_id == NULL && var->encoding == NULL) return 0;
+
+    /* Append the annotations of this variable to the model. */
+    if (model->count == model->capacity) {
+        size_t capacity =
+            model->capacity ? model->capacity * 2 : ANNOTATION_CAPACITY;
+        void* _ = realloc(
+            model->annotations, capacity * sizeof(BusTopologyAnnotation));
+        if (_ == NULL) {
+            free(var->bus_id);
+            free(var->encoding);
+            return -ENOMEM;
+        }
+        model->annotations = _;
+        model->capacity = capacity;
+    }
+    model->annotations[model->count++] = *var;
+    *var = (BusTopologyAnnotation){ 0 };
+    return 0;
+}
+
+
+static char* _read_annotation(xmlTextReaderPtr reader)
+{
+    /* Consolidated text of the (Annotation) element. */
+    xmlChar* text = xmlTextReaderReadString(reader);
+    if (text == NULL) return NULL;
+    char* value = strdup((char*)text);
+    xmlFree(text);
+    return value;
+}
+
+
+static void _parse_annotation(xmlTextReaderPtr reader, ParseState* state)
+{
+    xmlChar* name = xmlTextReaderGetAttribute(reader, (xmlChar*)"name");
+    char**   value = NULL;
+    if (_name_equal(state->tool, TOOL_BUS_TOPOLOGY) &&
+        _name_equal(name, "bus_id")) {
+        value = &state->var.bus_id;
+    } else if (_name_equal(state->tool, TOOL_BINARY_TO_TEXT) &&
+               _name_equal(name, "encoding")) {
+        value = &state->var.encoding;
+    }
+    if (value && *value == NULL) *value = _read_annotation(reader);
+    xmlFree(name);
+}
+
+
 /**
-parse_tool_anno
-===============
+parse_model_description
+=======================
+
+Parse the bus annotations of all ScalarVariables from the FMU
+`modelDescription.xml` file, in a single (streaming) pass over the file.
 
-Parse a specific tool annotation by `Tool name` and `name`.
+Only ScalarVariables with causality `input` or `output`, and with either a
+`dse.standards.fmi-ls-bus-topology` or `dse.standards.fmi-ls-binary-to-text`
+annotation, are included in the returned model.
 
 Parameters
 ----------
-node (xmlNode*)
-: Node (ScalarVariable) from where to search for the tool annotation.
-
-tool (const char*)
-: The name of the tool annotations container.
-
-name (const char*)
-: The name of the annotation to return.
+model_description_path (const char*)
+: Path of `modelDescription.xml` file to be parsed.
 
 Returns
 -------
-xmlChar*
-: Annotation text (consolidated `XmlElement` text).
+BusTopologyModel*
+: The parsed model, release with `parse_model_free()`.
 
 NULL
-: The annotation was not found.
+: The file could not be parsed, inspect `errno` for details.
 */
-static xmlChar* parse_tool_anno(
-    xmlNode* node, const char* tool, const char* name)
+BusTopologyModel* parse_model_description(const char* model_description_path)
 {
-    xmlChar* result = NULL;
-
-    /* Build the XPath query. */
-    size_t query_len =
-        snprintf(NULL, 0, "Annotations/Tool[@name='%s']/Annotation", tool) + 1;
-    char* query = calloc(query_len, sizeof(char));
-    snprintf(query, query_len, "Annotations/Tool[@name='%s']/Annotation", tool);
-    xmlXPathContext* ctx = xmlXPathNewContext(node->doc);
-    ctx->node = node;
-    xmlXPathObject* obj = xmlXPathEvalExpression((xmlChar*)query, ctx);
-
-    /* Locate the annotation value (if present). */
-    if (obj->type == XPATH_NODESET && obj->nodesetval) {
-        /* Annotation */
-        for (int i = 0; i < obj->nodesetval->nodeNr; i++) {
-            xmlNode* a_node = obj->nodesetval->nodeTab[i];
-            xmlChar* a_name = xmlGetProp(a_node, (xmlChar*)"name");
-            xmlChar* a_value =
-                xmlNodeListGetString(a_node->doc, a_node->xmlChildrenNode, 1);
-            if (strcmp((char*)a_name, name) == 0) {
-                result = a_value;
-                xmlFree(a_name);
-                break;
-            } else {
-                xmlFree(a_name);
-                xmlFree(a_value);
+    assert(model_description_path);
+
+    xmlInitParser();
+    xmlTextReaderPtr reader =
+        xmlReaderForFile(model_description_path, NULL, XML_PARSE_NONET);
+    if (reader == NULL) {
+        errno = ENOENT;
+        return NULL;
+    }
+    BusTopologyModel* model = calloc(1, sizeof(BusTopologyModel));
+    if (model == NULL) {
+        xmlFreeTextReader(reader);
+        errno = ENOMEM;
+        return NULL;
+    }
+    ParseState state = { .var_depth = -1 };
+
+    /* Visit each node, Annotations are collected while in a ScalarVariable:
+           /fmiModelDescription/ModelVariables/ScalarVariable
+               ScalarVariable/Annotations/Tool/Annotation
+    */
+    int rc;
+    while ((rc = xmlTextReaderRead(reader)) == 1) {
+        int            type = xmlTextReaderNodeType(reader);
+        int            depth = xmlTextReaderDepth(reader);
+        const xmlChar* name = xmlTextReaderConstLocalName(reader);
+
+        if (type == XML_READER_TYPE_ELEMENT) {
+            if (depth == 0) {
+                state.root = _name_equal(name, "fmiModelDescription");
+            } else if (depth == 1) {
+                state.variables =
+                    state.root && _name_equal(name, "ModelVariables");
+            } else if (depth == 2 && state.variables &&
+                       _name_equal(name, "ScalarVariable")) {
+                _begin_variable(reader, &state, depth);
+                if (xmlTextReaderIsEmptyElement(reader)) {
+                    if (_end_variable(model, &state)) break;
+                }
+            } else if (state.var_depth < 0) {
+                continue;
+            } else if (depth == state.var_depth + 2 &&
+                       _name_equal(name, "Tool")) {
+                xmlFree(state.tool);
+                state.tool =
+                    xmlTextReaderGetAttribute(reader, (xmlChar*)"name");
+            } else if (depth == state.var_depth + 3 && state.tool &&
+                       _name_equal(name, "Annotation")) {
+                _parse_annotation(reader, &state);
+            }
+        } else if (type == XML_READER_TYPE_END_ELEMENT) {
+            if (state.var_depth < 0) continue;
+            if (depth == state.var_depth) {
+                if (_end_variable(model, &state)) break;
+            } else if (depth == state.var_depth + 2) {
+                xmlFree(state.tool);
+                state.tool = NULL;
             }
         }
     }
 
-    /* Cleanup and return the result. */
-    free(query);
-    xmlXPathFreeObject(obj);
-    xmlXPathFreeContext(ctx);
-    return result;
+    /* Cleanup. */
+    xmlFree(state.tool);
+    free(state.var.bus_id);
+    free(state.var.encoding);
+    xmlFreeTextReader(reader);
+    if (rc != 0) {
+        parse_model_free(model);
+        errno = (rc < 0) ? EINVAL : ENOMEM;
+        return NULL;
+    }
+    return model;
+}
+
+
+/**
+parse_model_free
+================
+
+Release a model returned by `parse_model_description()` (or `cache_load()`).
+
+Parameters
+----------
+model (BusTopologyModel*)
+: The model to release.
+*/
+void parse_model_free(BusTopologyModel* model)
+{
+    if (model == NULL) return;
+
+    if (model->map) {
+        /* Loaded from a cache file, the strings reference the mapping. */
+        munmap(model->map, model->map_len);
+    } else {
+        for (size_t i = 0; i < model->count; i++) {
+            free(model->annotations[i].bus_id);
+            free(model->annotations[i].encoding);
+        }
+    }
+    free(model->annotations);
+    free(model);
+}
+
+
+/**
+index_bus_topology
+==================
+
+Index the Bus Topology, of the specified `bus_id`, from a parsed model in the
+provided `HashMap` objects.
+
+Parameters
+----------
+model (BusTopologyModel*)
+: Model returned by `parse_model_description()`.
+
+bus_id (const char*)
+: The Bus Identifier for the bus being indexed.
+
+bus_object (void*)
+: This object will be indexed in the `rx`/`tx` maps.
+
+rx (HashMap*)
+: Map {`vr`:`bus_object`}.
+
+tx (HashMap*)
+: Map {`vr`:`bus_object`}.
+*/
+void index_bus_topology(BusTopologyModel* model, const char* bus_id,
+    void* bus_object, HashMap* rx, HashMap* tx)
+{
+    if (model == NULL || bus_id == NULL) return;
+
+    for (size_t i = 0; i < model->count; i++) {
+        BusTopologyAnnotation* a = &model->annotations[i];
+        if (a->bus_id == NULL || strcmp(a->bus_id, bus_id) != 0) continue;
+
+        char key[HASH_KEY_LEN];
+        snprintf(key, HASH_KEY_LEN, "%u", a->vr);
+        if (a->direction == BUS_TOPOLOGY_RX) {
+            hashmap_set(rx, key, bus_object);
+        } else if (a->direction == BUS_TOPOLOGY_TX) {
+            hashmap_set(tx, key, bus_object);
+        }
+    }
+}
+
+
+/**
+index_binary_to_text
+====================
+
+Index all Binary-to-Text configurations from a parsed model in the provided
+`HashMap` objects.
+
+Parameters
+----------
+model (BusTopologyModel*)
+: Model returned by `parse_model_description()`.
+
+encode_func (HashMap*)
+: Map {`vr`:`EncodeFunc`}.
+
+decode_func (HashMap*)
+: Map {`vr`:`DecodeFunc`}.
+*/
+void index_binary_to_text(
+    BusTopologyModel* model, HashMap* encode_func, HashMap* decode_func)
+{
+    if (model == NULL) return;
+
+    for (size_t i = 0; i < model->count; i++) {
+        BusTopologyAnnotation* a = &model->annotations[i];
+        if (a->encoding == NULL || strcmp(a->encoding, "ascii85") != 0) {
+            continue;
+        }
+
+        char key[HASH_KEY_LEN];
+        snprintf(key, HASH_KEY_LEN, "%u", a->vr);
+        if (a->direction == BUS_TOPOLOGY_RX) {
+            hashmap_set(decode_func, key, ascii85_decode);
+        } else if (a->direction == BUS_TOPOLOGY_TX) {
+            hashmap_set(encode_func, key, ascii85_encode);
+        }
+    }
 }
 
 
@@ -108,45 +370,9 @@ tx (HashMap*)
 void parse_bus_topology(const char* model_description_path, const char* bus_id,
     void* bus_object, HashMap* rx, HashMap* tx)
 {
-    xmlInitParser();
-    xmlDoc* doc = xmlParseFile(model_description_path);
-
-    /* Search all Scalar Variables for bus annotations. */
-    xmlXPathContext* ctx = xmlXPathNewContext(doc);
-    xmlXPathObject*  obj = xmlXPathEvalExpression(
-         (xmlChar*)"/fmiModelDescription/ModelVariables/ScalarVariable", ctx);
-    for (int i = 0; i < obj->nodesetval->nodeNr; i++) {
-        /* ScalarVariable */
-        xmlChar* a_bus_id = NULL;
-        xmlNode* node = obj->nodesetval->nodeTab[i];
-        xmlChar* name = xmlGetProp(node, (xmlChar*)"name");
-        xmlChar* vr = xmlGetProp(node, (xmlChar*)"valueReference");
-        xmlChar* causality = xmlGetProp(node, (xmlChar*)"causality");
-        if (name == NULL || vr == NULL || causality == NULL) goto next;
-
-        /* Look for the bus_id annotation. */
-        a_bus_id = parse_tool_anno(
-            node, "dse.standards.fmi-ls-bus-topology", "bus_id");
-        if (a_bus_id == NULL) goto next;
-        if (strcmp(bus_id, (char*)a_bus_id) == 0) {
-            if (strcmp((char*)causality, "input") == 0) {
-                hashmap_set(rx, (char*)vr, bus_object);
-            } else if (strcmp((char*)causality, "output") == 0) {
-                hashmap_set(tx, (char*)vr, bus_object);
-            }
-        }
-    next:
-        /* Cleanup. */
-        xmlFree(a_bus_id);
-        xmlFree(name);
-        xmlFree(vr);
-        xmlFree(causality);
-    }
-
-    /* Cleanup. */
-    xmlXPathFreeObject(obj);
-    xmlXPathFreeContext(ctx);
-    xmlFreeDoc(doc);
+    BusTopologyModel* model = parse_model_description(model_description_path);
+    index_bus_topology(model, bus_id, bus_object, rx, tx);
+    parse_model_free(model);
 }
 
 
@@ -171,43 +397,7 @@ decode_func (HashMap*)
 void parse_binary_to_text(const char* model_description_path,
     HashMap* encode_func, HashMap* decode_func)
 {
-    xmlInitParser();
-    xmlDoc* doc = xmlParseFile(model_description_path);
-
-    /* Search all Scalar Variables for bus annotations. */
-    xmlXPathContext* ctx = xmlXPathNewContext(doc);
-    xmlXPathObject*  obj = xmlXPathEvalExpression(
-         (xmlChar*)"/fmiModelDescription/ModelVariables/ScalarVariable", ctx);
-    for (int i = 0; i < obj->nodesetval->nodeNr; i++) {
-        /* ScalarVariable */
-        xmlChar* encoding = NULL;
-        xmlNode* node = obj->nodesetval->nodeTab[i];
-        xmlChar* name = xmlGetProp(node, (xmlChar*)"name");
-        xmlChar* vr = xmlGetProp(node, (xmlChar*)"valueReference");
-        xmlChar* causality = xmlGetProp(node, (xmlChar*)"causality");
-        if (name == NULL || vr == NULL || causality == NULL) goto next;
-
-        /* Look for the encoding annotation. */
-        encoding = parse_tool_anno(
-            node, "dse.standards.fmi-ls-binary-to-text", "encoding");
-        if (encoding == NULL) goto next;
-        if (strcmp((char*)encoding, "ascii85") == 0) {
-            if (strcmp((char*)causality, "input") == 0) {
-                hashmap_set(decode_func, (char*)vr, ascii85_decode);
-            } else if (strcmp((char*)causality, "output") == 0) {
-                hashmap_set(encode_func, (char*)vr, ascii85_encode);
-            }
-        }
-    next:
-        /* Cleanup. */
-        xmlFree(encoding);
-        xmlFree(name);
-        xmlFree(vr);
-        xmlFree(causality);
-    }
-
-    /* Cleanup. */
-    xmlXPathFreeObject(obj);
-    xmlXPathFreeContext(ctx);
-    xmlFreeDoc(doc);
+    BusTopologyModel* model = parse_model_description(model_description_path);
+    index_binary_to_text(model, encode_func, decode_func);
+    parse_model_free(model);
 }
@@ -9,6 +9,78 @@
 #include <bus_topology.h>
 
 
+/* Grow the buffer. While a reader references the buffer, the content is
+   copied to a new buffer and the current buffer is retired (it remains valid
+   until the stream is reset). */
+static bool _stream_grow(BufferStream* _s, size_t required)
+{
+    if (required > _s->buffer_max_len) return false;
+
+    size_t buffer_len = _s->buffer_len ? _s->buffer_len : BUFFER_LEN;
+    while (buffer_len < required) {
+        buffer_len *= 2;
+    }
+    if (buffer_len > _s->buffer_max_len) buffer_len = _s->buffer_max_len;
+    if (_s->reading == false) {
+        uint8_t* buffer = ncodec_realloc(NULL, _s->buffer, buffer_len);
+        if (buffer == NULL) return false;
+        _s->buffer = buffer;
+        _s->buffer_len = buffer_len;
+        return true;
+    }
+
+    uint8_t** retired = ncodec_realloc(
+        NULL, _s->retired, (_s->retired_count + 1) * sizeof(uint8_t*));
+    if (retired == NULL) return false;
+    _s->retired = retired;
+    uint8_t* buffer = ncodec_alloc(NULL, buffer_len);
+    if (buffer == NULL) return false;
+    memcpy(buffer, _s->buffer, _s->len);
+    _s->retired[_s->retired_count++] = _s->buffer;
+    _s->buffer = buffer;
+    _s->buffer_len = buffer_len;
+    return true;
+}
+
+
+static void _stream_release_retired(BufferStream* _s)
+{
+    for (size_t i = 0; i < _s->retired_count; i++) {
+        ncodec_free(NULL, _s->retired[i]);
+    }
+    _s->retired_count = 0;
+}
+
+
+/* Ensure that `len` bytes can be written at the current position. The buffer
+   grows (up to its maximum length), and when that is not sufficient, the
+   region already consumed by stream_read() is compacted (unless a reader
+   references the buffer). */
+static int32_t _stream_extend(BufferStream* _s, size_t len)
+{
+    size_t required = _s->pos + len;
+    if (required <= _s->buffer_len) return 0;
+
+    /* Grow. */
+    if (_stream_grow(_s, required)) return 0;
+
+    /* Compact. */
+    size_t consumed = _s->read_pos < _s->pos ? _s->read_pos : _s->pos;
+    if (_s->reading) consumed = 0;
+    if (consumed && (required - consumed) <= _s->buffer_len) {
+        memmove(_s->buffer, &_s->buffer[consumed], _s->len - consumed);
+        _s->len -= consumed;
+        _s->pos -= consumed;
+        _s->read_pos -= consumed;
+        return 0;
+    }
+
+    /* Overflow. */
+    _s->overflow_count++;
+    return -EMSGSIZE;
+}
+
+
 size_t stream_read(NCODEC* nc, uint8_t** data, size_t* len, int32_t pos_op)
 {
     NCodecInstance* _nc = (NCodecInstance*)nc;
@@ -25,8 +97,13 @@ size_t stream_read(NCODEC* nc, uint8_t** data, size_t* len, int32_t pos_op)
     /* Return buffer, from current pos. */
     *data = &_s->buffer[_s->pos];
     *len = _s->len - _s->pos;
-    /* Advance the position indicator. */
-    if (pos_op == NCODEC_POS_UPDATE) _s->pos = _s->len;
+    /* Advance the position indicator, otherwise the caller continues to
+       reference the buffer. */
+    if (pos_op == NCODEC_POS_UPDATE) {
+        _s->pos = _s->read_pos = _s->len;
+    } else {
+        _s->reading = true;
+    }
 
     return *len;
 }
@@ -38,13 +115,38 @@ size_t stream_write(NCODEC* nc, uint8_t* data, size_t len)
 
     BufferStream* _s = (BufferStream*)_nc->stream;
 
-    if ((_s->pos + len) > BUFFER_LEN) return -EMSGSIZE;
+    int32_t rc = _stream_extend(_s, len);
+    if (rc) return rc;
     memcpy(&_s->buffer[_s->pos], data, len);
     _s->pos += len;
     if (_s->pos > _s->len) _s->len = _s->pos;
     return len;
 }
 
+uint8_t* stream_reserve(NCODEC* nc, size_t len)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL || _nc->stream == NULL) return NULL;
+
+    BufferStream* _s = (BufferStream*)_nc->stream;
+
+    if (_stream_extend(_s, len)) return NULL;
+    return &_s->buffer[_s->pos];
+}
+
+int32_t stream_commit(NCODEC* nc, size_t len)
+{
+    NCodecInstance* _nc = (NCodecInstance*)nc;
+    if (_nc == NULL || _nc->stream == NULL) return -ENOSTR;
+
+    BufferStream* _s = (BufferStream*)_nc->stream;
+
+    if ((_s->pos + len) > _s->buffer_len) return -EMSGSIZE;
+    _s->pos += len;
+    if (_s->pos > _s->len) _s->len = _s->pos;
+    return len;
+}
+
 int64_t stream_seek(NCODEC* nc, size_t pos, int32_t op)
 {
     NCodecInstance* _nc = (NCodecInstance*)nc;
@@ -66,7 +168,9 @@ int64_t stream_seek(NCODEC* nc, size_t pos, int32_t op)
         } else if (op == NCODEC_SEEK_END) {
             _s->pos = _s->len;
         } else if (op == NCODEC_SEEK_RESET) {
-            _s->pos = _s->len = 0;
+            _s->pos = _s->len = _s->read_pos = 0;
+            _s->reading = false;
+            _stream_release_retired(_s);
         } else if (op == 42) {
             _s->pos = _s->len = _s->buffer_len;
         } else {
@@ -104,9 +208,15 @@ int32_t stream_close(NCODEC* nc)
     return 0;
 }
 
-void* stream_create(void)
+void* stream_create(size_t max_len)
 {
-    BufferStream* stream = calloc(1, sizeof(BufferStream));
+    BufferStream* stream = ncodec_alloc(NULL, sizeof(BufferStream));
+    if (stream == NULL) return NULL;
+    stream->buffer = ncodec_alloc(NULL, BUFFER_LEN);
+    if (stream->buffer == NULL) {
+        ncodec_free(NULL, stream);
+        return NULL;
+    }
     stream->s = (struct NCodecStreamVTable){
         .read = stream_read,
         .write = stream_write,
@@ -114,7 +224,24 @@ void* stream_create(void)
         .tell = stream_tell,
         .eof = stream_eof,
         .close = stream_close,
+        .reserve = stream_reserve,
+        .commit = stream_commit,
     };
     stream->buffer_len = BUFFER_LEN;
+    stream->buffer_max_len = max_len ? max_len : BUFFER_MAX_LEN;
+    if (stream->buffer_max_len < BUFFER_LEN) {
+        stream->buffer_max_len = BUFFER_LEN;
+    }
     return stream;
 }
+
+void stream_destroy(void* stream)
+{
+    BufferStream* _s = (BufferStream*)stream;
+    if (_s == NULL) return;
+
+    _stream_release_retired(_s);
+    ncodec_free(NULL, _s->retired);
+    ncodec_free(NULL, _s->buffer);
+    ncodec_free(NULL, _s);
+}
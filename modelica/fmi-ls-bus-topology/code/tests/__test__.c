@@ -6,6 +6,7 @@
 
 
 extern int run_parser_tests(void);
+extern int run_cache_tests(void);
 extern int run_bus_topology_tests(void);
 extern int run_ncodec_tests(void);
 
@@ -14,6 +15,7 @@ int main()
 {
     int rc = 0;
     rc |= run_parser_tests();
+    rc |= run_cache_tests();
     rc |= run_bus_topology_tests();
     rc |= run_ncodec_tests();
     return rc;
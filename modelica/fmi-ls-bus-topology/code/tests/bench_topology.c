@@ -0,0 +1,193 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dse/ncodec/codec.h>
+#include <bus_topology.h>
+
+
+/* Startup benchmark of the Bus Topology. Each configuration writes a
+   synthetic modelDescription.xml (N ScalarVariables, distributed over B
+   busses), then measures bus_topology_create() and bus_topology_add() for
+   each bus (i.e. FMU startup) and bus_topology_destroy().
+
+   Usage: bench_topology [CSV file] [repeat]
+*/
+
+
+#define CSV_FILE "bench_topology.csv"
+#define XML_FILE "bench_topology.xml"
+#define REPEAT   5
+
+#define MIMETYPE                                                               \
+    "application/x-automotive-bus; "                                           \
+    "interface=stream;type=frame;bus=can;schema=fbs;"                          \
+    "bus_id=%u;node_id=2;interface_id=3"
+
+
+typedef struct BenchResult {
+    uint64_t first_add_ns; /* Includes parsing of the XML. */
+    uint64_t startup_ns;   /* Create and add all busses. */
+    uint64_t destroy_ns;
+    size_t   rx_count;
+    size_t   tx_count;
+} BenchResult;
+
+
+static uint64_t _now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+static int _write_xml(const char* path, size_t variables, uint32_t busses)
+{
+    FILE* f = fopen(path, "w");
+    if (f == NULL) return -errno;
+
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<fmiModelDescription fmiVersion=\"2.0\" modelName=\"bench\">\n"
+               "    <ModelVariables>\n");
+    for (size_t i = 0; i < variables; i++) {
+        /* Every 4th variable is a plain (not annotated) variable. */
+        uint32_t    vr = (uint32_t)i + 1;
+        const char* causality = (i % 2) ? "output" : "input";
+        fprintf(f,
+            "        <ScalarVariable name=\"var_%u\" valueReference=\"%u\" "
+            "causality=\"%s\">\n",
+            vr, vr, causality);
+        if (i % 4 == 3) {
+            fprintf(f, "            <Real start=\"0\"/>\n");
+        } else {
+            fprintf(f,
+                "            <String/>\n"
+                "            <Annotations>\n"
+                "                <Tool name=\"dse.standards.fmi-ls-binary-to-"
+                "text\">\n"
+                "                    <Annotation name=\"encoding\">ascii85"
+                "</Annotation>\n"
+                "                </Tool>\n"
+                "                <Tool name=\"dse.standards.fmi-ls-bus-"
+                "topology\">\n"
+                "                    <Annotation name=\"bus_id\">%u"
+                "</Annotation>\n"
+                "                </Tool>\n"
+                "            </Annotations>\n",
+                (uint32_t)((i / 2) % busses) + 1);
+        }
+        fprintf(f, "        </ScalarVariable>\n");
+    }
+    fprintf(f, "    </ModelVariables>\n"
+               "</fmiModelDescription>\n");
+    fclose(f);
+    return 0;
+}
+
+
+static int _bench_run(const char* path, uint32_t busses, BenchResult* r)
+{
+    void** stream = calloc(busses, sizeof(void*));
+    void** ncodec = calloc(busses, sizeof(void*));
+    char   bus_id[16];
+    char   mime_type[sizeof(MIMETYPE) + 16];
+    int    rc = 0;
+
+    /* Codec objects are created in advance (not part of the measurement). */
+    for (uint32_t b = 0; b < busses; b++) {
+        snprintf(mime_type, sizeof(mime_type), MIMETYPE, b + 1);
+        stream[b] = stream_create(0);
+        ncodec[b] = ncodec_open(mime_type, stream[b]);
+        if (ncodec[b] == NULL) rc = -EINVAL;
+    }
+    if (rc) goto cleanup;
+
+    /* Startup. */
+    uint64_t     t0 = _now_ns();
+    BusTopology* bt = bus_topology_create(path);
+    for (uint32_t b = 0; b < busses; b++) {
+        snprintf(bus_id, sizeof(bus_id), "%u", b + 1);
+        bus_topology_add(bt, bus_id, ncodec[b]);
+        if (b == 0) r->first_add_ns = _now_ns() - t0;
+    }
+    r->startup_ns = _now_ns() - t0;
+    r->rx_count = hashmap_number_keys(bt->rx_vr_index);
+    r->tx_count = hashmap_number_keys(bt->tx_vr_index);
+
+    /* Destroy (also closes the codec objects). */
+    t0 = _now_ns();
+    bus_topology_destroy(bt);
+    r->destroy_ns = _now_ns() - t0;
+
+cleanup:
+    for (uint32_t b = 0; b < busses; b++) {
+        if (rc && ncodec[b]) ncodec_close(ncodec[b]);
+        stream_destroy(stream[b]);
+    }
+    free(stream);
+    free(ncodec);
+    return rc;
+}
+
+
+int main(int argc, char** argv)
+{
+    const char* csv_file = (argc > 1) ? argv[1] : CSV_FILE;
+    size_t      repeat = (argc > 2) ? strtoul(argv[2], NULL, 10) : REPEAT;
+    if (repeat == 0) repeat = REPEAT;
+
+    FILE* csv = fopen(csv_file, "w");
+    if (csv == NULL) {
+        fprintf(stderr, "Could not open %s (%s)\n", csv_file, strerror(errno));
+        return 1;
+    }
+    fprintf(csv, "variables,busses,xml_bytes,repeat,first_add_ms,startup_ms,"
+                 "destroy_ms,rx_count,tx_count\n");
+
+    /* Sweep parameters. */
+    size_t   variables[] = { 1000, 10000, 100000 };
+    uint32_t busses[] = { 1, 10, 50 };
+
+    int rc = 0;
+    for (size_t v = 0; v < ARRAY_SIZE(variables); v++) {
+        for (size_t b = 0; b < ARRAY_SIZE(busses); b++) {
+            if (_write_xml(XML_FILE, variables[v], busses[b])) {
+                fprintf(stderr, "Could not write %s\n", XML_FILE);
+                rc = 1;
+                break;
+            }
+            FILE* f = fopen(XML_FILE, "r");
+            fseek(f, 0, SEEK_END);
+            long xml_bytes = ftell(f);
+            fclose(f);
+
+            /* Best of repeat (the file is in the page cache). */
+            BenchResult best = { 0 };
+            for (size_t i = 0; i < repeat; i++) {
+                BenchResult r = { 0 };
+                if (_bench_run(XML_FILE, busses[b], &r)) {
+                    rc = 1;
+                    break;
+                }
+                if (i == 0 || r.startup_ns < best.startup_ns) best = r;
+            }
+            fprintf(csv, "%zu,%u,%ld,%zu,%.3f,%.3f,%.3f,%zu,%zu\n",
+                variables[v], busses[b], xml_bytes, repeat,
+                best.first_add_ns / 1e6, best.startup_ns / 1e6,
+                best.destroy_ns / 1e6, best.rx_count, best.tx_count);
+            fflush(csv);
+        }
+    }
+    unlink(XML_FILE);
+    fclose(csv);
+
+    return rc;
+}
@@ -26,7 +26,7 @@ int test_setup(void** state)
                       "interface=stream;type=frame;bus=can;schema=fbs;"
                       "bus_id=1;node_id=2;interface_id=3";
     mock->bus_id = "1";
-    mock->stream = stream_create();
+    mock->stream = stream_create(0);
     mock->ncodec = ncodec_open(mock->mime_type, mock->stream);
     *state = mock;
     return 0;
@@ -37,7 +37,7 @@ int test_teardown(void** state)
 {
     BT_Mock* mock = *state;
     if (mock) {
-        free(mock->stream);
+        stream_destroy(mock->stream);
         free(mock);
     }
     return 0;
@@ -103,6 +103,27 @@ void test_bt_add(void** state)
     assert_ptr_equal(hashmap_get(&bt->decode_func, "4"), ascii85_decode);
     assert_ptr_equal(hashmap_get(&bt->decode_func, "6"), ascii85_decode);
 
+    /* Compiled VR table. */
+    assert_non_null(bt->vr_table);
+    assert_int_equal(bt->vr_count, 8);
+    for (uint32_t vr = 0; vr < bt->vr_count; vr++) {
+        BusTopologyVr* e = &bt->vr_table[vr];
+        if (vr < 2) {
+            assert_int_equal(e->direction, BUS_TOPOLOGY_NONE);
+            assert_null(e->ncodec);
+        } else if (vr % 2) {
+            assert_int_equal(e->direction, BUS_TOPOLOGY_TX);
+            assert_ptr_equal(e->ncodec, mock->ncodec);
+            assert_ptr_equal(e->encode, ascii85_encode);
+            assert_null(e->decode);
+        } else {
+            assert_int_equal(e->direction, BUS_TOPOLOGY_RX);
+            assert_ptr_equal(e->ncodec, mock->ncodec);
+            assert_ptr_equal(e->decode, ascii85_decode);
+            assert_null(e->encode);
+        }
+    }
+
     bus_topology_destroy(bt);
 }
 
@@ -192,19 +213,164 @@ void test_bt_reset(void** state)
     data = NULL;
     len = 0;
     bus_topology_tx(bt, 3, &data, &len);
+    uint8_t* data_3 = data;
     bus_topology_tx(bt, 5, &data, &len);
     bus_topology_tx(bt, 7, &data, &len);
-    assert_int_equal(hashmap_number_keys(bt->free_list), 3);
+    assert_non_null(bt->arena);
+    assert_true(bt->arena->len > 0);
+    assert_true(data != data_3);
+    assert_memory_equal(data_3, ASCII85_MESSAGE, strlen(ASCII85_MESSAGE));
+    assert_memory_equal(data, ASCII85_MESSAGE, strlen(ASCII85_MESSAGE));
 
     /* Free used memory. */
     bus_topology_reset(bt);
-    assert_int_equal(hashmap_number_keys(bt->free_list), 0);
+    assert_non_null(bt->arena);
+    assert_int_equal(bt->arena->len, 0);
 
     /* Produce to entire topology, destroy will free. */
     bus_topology_tx(bt, 3, &data, &len);
     bus_topology_tx(bt, 5, &data, &len);
     bus_topology_tx(bt, 7, &data, &len);
-    assert_int_equal(hashmap_number_keys(bt->free_list), 3);
+    assert_true(bt->arena->len > 0);
+
+    bus_topology_destroy(bt);
+}
+
+
+void test_bt_stream_grow(void** state)
+{
+    UNUSED(state);
+
+    BufferStream*  stream = stream_create(BUFFER_LEN * 2);
+    NCodecInstance nc = { .stream = (NCodecStreamVTable*)stream };
+    NCODEC*        _nc = (NCODEC*)&nc;
+    uint8_t        data[BUFFER_LEN / 2];
+    assert_non_null(stream);
+    assert_int_equal(stream->buffer_len, BUFFER_LEN);
+
+    /* Grow, up to the maximum length. */
+    for (size_t i = 0; i < 4; i++) {
+        memset(data, (int)i, sizeof(data));
+        assert_int_equal(
+            stream->s.write(_nc, data, sizeof(data)), sizeof(data));
+    }
+    assert_int_equal(stream->buffer_len, BUFFER_LEN * 2);
+    assert_int_equal(stream->len, BUFFER_LEN * 2);
+    assert_int_equal(stream->buffer[BUFFER_LEN * 2 - 1], 3);
+
+    /* Overflow is reported. */
+    assert_int_equal(stream->s.write(_nc, data, sizeof(data)), -EMSGSIZE);
+    assert_null(stream->s.reserve(_nc, sizeof(data)));
+    assert_int_equal(stream->overflow_count, 2);
+    assert_int_equal(stream->len, BUFFER_LEN * 2);
+
+    /* Consumed regions are compacted. */
+    uint8_t* _ = NULL;
+    size_t   len = 0;
+    stream->s.seek(_nc, 0, NCODEC_SEEK_SET);
+    stream->s.read(_nc, &_, &len, NCODEC_POS_UPDATE);
+    assert_int_equal(len, BUFFER_LEN * 2);
+    memset(data, 4, sizeof(data));
+    assert_int_equal(stream->s.write(_nc, data, sizeof(data)), sizeof(data));
+    assert_int_equal(stream->s.tell(_nc), sizeof(data));
+    assert_int_equal(stream->len, sizeof(data));
+    assert_int_equal(stream->buffer[0], 4);
+    assert_int_equal(stream->buffer_len, BUFFER_LEN * 2);
+
+    stream_destroy(stream);
+}
+
+
+void test_bt_stream_grow_reading(void** state)
+{
+    UNUSED(state);
+
+    BufferStream*  stream = stream_create(BUFFER_LEN * 4);
+    NCodecInstance nc = { .stream = (NCodecStreamVTable*)stream };
+    NCODEC*        _nc = (NCODEC*)&nc;
+    uint8_t        data[BUFFER_LEN / 2];
+    memset(data, 1, sizeof(data));
+    assert_non_null(stream);
+
+    /* A reader references the buffer. */
+    stream->s.write(_nc, data, sizeof(data));
+    stream->s.write(_nc, data, sizeof(data));
+    uint8_t* buffer = stream->buffer;
+    uint8_t* _ = NULL;
+    size_t   len = 0;
+    stream->s.seek(_nc, 0, NCODEC_SEEK_SET);
+    stream->s.read(_nc, &_, &len, NCODEC_POS_NC);
+    assert_ptr_equal(_, buffer);
+    assert_true(stream->reading);
+
+    /* The buffer grows into a new buffer while reading, the referenced
+       buffer remains valid. */
+    stream->s.seek(_nc, 0, NCODEC_SEEK_END);
+    memset(data, 2, sizeof(data));
+    assert_int_equal(stream->s.write(_nc, data, sizeof(data)), sizeof(data));
+    assert_ptr_not_equal(stream->buffer, buffer);
+    assert_int_equal(stream->buffer_len, BUFFER_LEN * 2);
+    assert_int_equal(stream->retired_count, 1);
+    assert_int_equal(stream->overflow_count, 0);
+    assert_int_equal(_[0], 1);
+    assert_int_equal(stream->buffer[0], 1);
+    assert_int_equal(stream->buffer[BUFFER_LEN], 2);
+
+    /* Without compaction (while reading), the maximum length overflows. */
+    for (size_t i = 0; i < 6; i++) {
+        stream->s.write(_nc, data, sizeof(data));
+    }
+    assert_int_equal(stream->len, BUFFER_LEN * 4);
+    assert_int_equal(stream->retired_count, 2);
+    assert_int_equal(stream->overflow_count, 1);
+
+    /* Retired buffers are released when the stream is reset. */
+    stream->s.seek(_nc, 0, NCODEC_SEEK_RESET);
+    assert_false(stream->reading);
+    assert_int_equal(stream->retired_count, 0);
+    assert_int_equal(stream->buffer_len, BUFFER_LEN * 4);
+
+    stream_destroy(stream);
+}
+
+
+void test_bt_tx_arena(void** state)
+{
+    BT_Mock* mock = *state;
+
+    BusTopology* bt = bus_topology_create(mock->xml_path);
+    bus_topology_add(bt, mock->bus_id, mock->ncodec);
+
+    uint8_t* data = NULL;
+    size_t   len = 0;
+    bus_topology_reset(bt);
+    bus_topology_rx(bt, 2, (void*)ASCII85_MESSAGE, strlen(ASCII85_MESSAGE));
+
+    /* Exceed the first arena block, earlier data remains valid. */
+    size_t   count = BUFFER_LEN / 8 + 1;
+    uint8_t* first = NULL;
+    for (size_t i = 0; i < count; i++) {
+        bus_topology_tx(bt, 3, &data, &len);
+        assert_int_equal(len, strlen(ASCII85_MESSAGE));
+        if (first == NULL) first = data;
+    }
+    assert_non_null(bt->arena->next);
+    assert_memory_equal(first, ASCII85_MESSAGE, strlen(ASCII85_MESSAGE));
+    assert_memory_equal(data, ASCII85_MESSAGE, strlen(ASCII85_MESSAGE));
+
+    /* Reset, the blocks are replaced by one (larger) block. */
+    size_t capacity = bt->arena->capacity + bt->arena->next->capacity;
+    bus_topology_reset(bt);
+    assert_non_null(bt->arena);
+    assert_null(bt->arena->next);
+    assert_int_equal(bt->arena->capacity, capacity);
+
+    /* The next step fits in the one block. */
+    bus_topology_rx(bt, 2, (void*)ASCII85_MESSAGE, strlen(ASCII85_MESSAGE));
+    for (size_t i = 0; i < count; i++) {
+        bus_topology_tx(bt, 3, &data, &len);
+    }
+    assert_null(bt->arena->next);
 
     bus_topology_destroy(bt);
 }
@@ -221,6 +387,9 @@ int run_bus_topology_tests(void)
         cmocka_unit_test_setup_teardown(test_bt_rx, s, t),
         cmocka_unit_test_setup_teardown(test_bt_tx, s, t),
         cmocka_unit_test_setup_teardown(test_bt_reset, s, t),
+        cmocka_unit_test_setup_teardown(test_bt_tx_arena, s, t),
+        cmocka_unit_test_setup_teardown(test_bt_stream_grow, s, t),
+        cmocka_unit_test_setup_teardown(test_bt_stream_grow_reading, s, t),
     };
 
     return cmocka_run_group_tests_name("BUS_TOPOLOGY", _tests, NULL, NULL);
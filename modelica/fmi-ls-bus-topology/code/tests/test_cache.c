@@ -0,0 +1,232 @@
+// Copyright 2026 Robert Bosch GmbH
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <testing.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <dse/clib/collections/hashmap.h>
+#include <bus_topology.h>
+
+
+#define XML_PATH   "../../example/modelDescription.xml"
+#define CACHE_PATH "test_cache.bin"
+#define COPY_PATH  "test_cache.xml"
+
+
+typedef struct Mock {
+    uint64_t          hash;
+    BusTopologyModel* model;
+} Mock;
+
+
+static int test_setup(void** state)
+{
+    Mock* mock = calloc(1, sizeof(Mock));
+    assert_non_null(mock);
+    assert_int_equal(cache_hash_file(XML_PATH, &mock->hash), 0);
+    mock->model = parse_model_description(XML_PATH);
+    assert_non_null(mock->model);
+    unlink(CACHE_PATH);
+    *state = mock;
+    return 0;
+}
+
+
+static int test_teardown(void** state)
+{
+    Mock* mock = *state;
+    if (mock) {
+        parse_model_free(mock->model);
+        free(mock);
+    }
+    unlink(CACHE_PATH);
+    unlink(COPY_PATH);
+    return 0;
+}
+
+
+static void _copy_file(const char* from, const char* to, const char* append)
+{
+    FILE* in = fopen(from, "rb");
+    FILE* out = fopen(to, "wb");
+    assert_non_null(in);
+    assert_non_null(out);
+    char   buffer[1024];
+    size_t len;
+    while ((len = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        fwrite(buffer, 1, len, out);
+    }
+    if (append) fputs(append, out);
+    fclose(in);
+    fclose(out);
+}
+
+
+void test_cache_store_load(void** state)
+{
+    Mock* mock = *state;
+
+    assert_int_equal(cache_store(CACHE_PATH, mock->hash, mock->model), 0);
+    BusTopologyModel* model = cache_load(CACHE_PATH, mock->hash);
+    assert_non_null(model);
+    assert_non_null(model->map);
+
+    assert_int_equal(model->count, mock->model->count);
+    for (size_t i = 0; i < model->count; i++) {
+        BusTopologyAnnotation* a = &model->annotations[i];
+        BusTopologyAnnotation* e = &mock->model->annotations[i];
+        assert_int_equal(a->vr, e->vr);
+        assert_int_equal(a->direction, e->direction);
+        assert_string_equal(a->bus_id, e->bus_id);
+        assert_string_equal(a->encoding, e->encoding);
+    }
+
+    parse_model_free(model);
+}
+
+
+void test_cache_hash_mismatch(void** state)
+{
+    Mock* mock = *state;
+
+    assert_int_equal(cache_store(CACHE_PATH, mock->hash, mock->model), 0);
+    errno = 0;
+    assert_null(cache_load(CACHE_PATH, mock->hash + 1));
+    assert_int_equal(errno, ESTALE);
+}
+
+
+void test_cache_invalid(void** state)
+{
+    Mock* mock = *state;
+
+    /* Missing. */
+    assert_null(cache_load(CACHE_PATH, mock->hash));
+
+    /* Truncated. */
+    assert_int_equal(cache_store(CACHE_PATH, mock->hash, mock->model), 0);
+    assert_int_equal(truncate(CACHE_PATH, 40), 0);
+    assert_null(cache_load(CACHE_PATH, mock->hash));
+
+    /* Not a cache file. */
+    FILE* f = fopen(CACHE_PATH, "wb");
+    assert_non_null(f);
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fclose(f);
+    errno = 0;
+    assert_null(cache_load(CACHE_PATH, mock->hash));
+    assert_int_equal(errno, EINVAL);
+}
+
+
+void test_cache_bus_topology(void** state)
+{
+    Mock* mock = *state;
+    UNUSED(mock);
+    int bus_1_object = 1;
+
+    /* First create, the cache is written. */
+    BusTopology* bt = bus_topology_create(XML_PATH);
+    bus_topology_set_cache(bt, CACHE_PATH);
+    bus_topology_add(bt, "1", &bus_1_object);
+    assert_non_null(bt->model);
+    assert_null(bt->model->map);
+    assert_int_equal(access(CACHE_PATH, R_OK), 0);
+    hashmap_clear(&bt->bus_ncodec);
+    bus_topology_destroy(bt);
+
+    /* Second create, the cache is loaded. */
+    bt = bus_topology_create(XML_PATH);
+    bus_topology_set_cache(bt, CACHE_PATH);
+    bus_topology_add(bt, "1", &bus_1_object);
+    assert_non_null(bt->model);
+    assert_non_null(bt->model->map);
+    assert_int_equal(hashmap_number_keys(bt->rx_vr_index), 3);
+    assert_int_equal(hashmap_number_keys(bt->tx_vr_index), 3);
+    assert_int_equal(hashmap_number_keys(bt->encode_func), 3);
+    assert_int_equal(hashmap_number_keys(bt->decode_func), 3);
+    assert_ptr_equal(hashmap_get(&bt->tx_vr_index, "5"), &bus_1_object);
+    hashmap_clear(&bt->bus_ncodec);
+    bus_topology_destroy(bt);
+}
+
+
+void test_cache_acquire_shared(void** state)
+{
+    Mock* mock = *state;
+    UNUSED(mock);
+    int bus_1_object = 1;
+    int bus_2_object = 2;
+
+    /* Two objects for the same model share the parsed annotations. */
+    BusTopology* bt1 = bus_topology_create(XML_PATH);
+    BusTopology* bt2 = bus_topology_create(XML_PATH);
+    bus_topology_add(bt1, "1", &bus_1_object);
+    bus_topology_add(bt2, "1", &bus_2_object);
+    assert_non_null(bt1->model);
+    assert_ptr_equal(bt1->model, bt2->model);
+
+    /* The codec bindings are per object. */
+    assert_ptr_equal(hashmap_get(&bt1->rx_vr_index, "2"), &bus_1_object);
+    assert_ptr_equal(hashmap_get(&bt2->rx_vr_index, "2"), &bus_2_object);
+
+    /* The shared model remains valid until released by all objects. */
+    hashmap_clear(&bt1->bus_ncodec);
+    bus_topology_destroy(bt1);
+    assert_int_equal(bt2->model->count, 6);
+    assert_string_equal(bt2->model->annotations[0].bus_id, "1");
+    hashmap_clear(&bt2->bus_ncodec);
+    bus_topology_destroy(bt2);
+}
+
+
+void test_cache_acquire_changed(void** state)
+{
+    Mock* mock = *state;
+    UNUSED(mock);
+
+    /* Different path, different model. */
+    _copy_file(XML_PATH, COPY_PATH, NULL);
+    BusTopologyModel* m1 = cache_acquire(XML_PATH, NULL);
+    BusTopologyModel* m2 = cache_acquire(COPY_PATH, NULL);
+    assert_non_null(m1);
+    assert_non_null(m2);
+    assert_true(m1 != m2);
+    assert_ptr_equal(cache_acquire(COPY_PATH, NULL), m2);
+    cache_release(m2);
+
+    /* Same path, changed content (hash), different model. */
+    _copy_file(XML_PATH, COPY_PATH, "\n");
+    BusTopologyModel* m3 = cache_acquire(COPY_PATH, NULL);
+    assert_non_null(m3);
+    assert_true(m2 != m3);
+    assert_int_equal(m3->count, m2->count);
+
+    cache_release(m1);
+    cache_release(m2);
+    cache_release(m3);
+
+    /* Missing file. */
+    assert_null(cache_acquire("missing.xml", NULL));
+}
+
+
+int run_cache_tests(void)
+{
+    void* s = test_setup;
+    void* t = test_teardown;
+
+    const struct CMUnitTest _tests[] = {
+        cmocka_unit_test_setup_teardown(test_cache_store_load, s, t),
+        cmocka_unit_test_setup_teardown(test_cache_hash_mismatch, s, t),
+        cmocka_unit_test_setup_teardown(test_cache_invalid, s, t),
+        cmocka_unit_test_setup_teardown(test_cache_bus_topology, s, t),
+        cmocka_unit_test_setup_teardown(test_cache_acquire_shared, s, t),
+        cmocka_unit_test_setup_teardown(test_cache_acquire_changed, s, t),
+    };
+
+    return cmocka_run_group_tests_name("CACHE", _tests, NULL, NULL);
+}
@@ -4,6 +4,7 @@
 
 #include <testing.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <dse/clib/collections/hashmap.h>
 #include <bus_topology.h>
 
@@ -101,6 +102,81 @@ void test_xml_parse_binary_to_text(void** state)
 }
 
 
+void test_xml_parse_model_description(void** state)
+{
+    Mock* mock = *state;
+    UNUSED(mock);
+
+    BusTopologyModel* model =
+        parse_model_description("../../example/modelDescription.xml");
+    assert_non_null(model);
+
+    /* Annotated variables only, in document order. */
+    assert_int_equal(model->count, 6);
+    for (size_t i = 0; i < model->count; i++) {
+        BusTopologyAnnotation* a = &model->annotations[i];
+        assert_int_equal(a->vr, i + 2);
+        assert_int_equal(
+            a->direction, (i % 2) ? BUS_TOPOLOGY_TX : BUS_TOPOLOGY_RX);
+        assert_string_equal(a->bus_id, "1");
+        assert_string_equal(a->encoding, "ascii85");
+    }
+
+    /* Index two busses from the one parsed model. */
+    HashMap rx;
+    HashMap tx;
+    hashmap_init(&rx);
+    hashmap_init(&tx);
+    int bus_1_object = 1;
+    index_bus_topology(model, "1", &bus_1_object, &rx, &tx);
+    index_bus_topology(model, "2", NULL, &rx, &tx);
+    assert_int_equal(hashmap_number_keys(rx), 3);
+    assert_int_equal(hashmap_number_keys(tx), 3);
+    assert_ptr_equal(hashmap_get(&rx, "4"), &bus_1_object);
+    assert_ptr_equal(hashmap_get(&tx, "5"), &bus_1_object);
+
+    hashmap_destroy(&rx);
+    hashmap_destroy(&tx);
+    parse_model_free(model);
+
+    /* Missing file. */
+    assert_null(parse_model_description("../../example/missing.xml"));
+}
+
+
+void test_xml_parse_model_variables_only(void** state)
+{
+    Mock* mock = *state;
+    UNUSED(mock);
+
+    /* ScalarVariables outside of /fmiModelDescription/ModelVariables are
+       ignored. */
+    const char* path = "test_parse_model_variables.xml";
+    FILE*       f = fopen(path, "w");
+    assert_non_null(f);
+    fputs("<fmiModelDescription><ModelVariables>"
+          "<ScalarVariable name=\"a\" valueReference=\"1\" causality=\"input\">"
+          "<Annotations><Tool name=\"dse.standards.fmi-ls-bus-topology\">"
+          "<Annotation name=\"bus_id\">1</Annotation>"
+          "</Tool></Annotations></ScalarVariable>"
+          "</ModelVariables><VendorAnnotations>"
+          "<ScalarVariable name=\"b\" valueReference=\"2\" causality=\"input\">"
+          "<Annotations><Tool name=\"dse.standards.fmi-ls-bus-topology\">"
+          "<Annotation name=\"bus_id\">1</Annotation>"
+          "</Tool></Annotations></ScalarVariable>"
+          "</VendorAnnotations></fmiModelDescription>",
+        f);
+    fclose(f);
+
+    BusTopologyModel* model = parse_model_description(path);
+    assert_non_null(model);
+    assert_int_equal(model->count, 1);
+    assert_int_equal(model->annotations[0].vr, 1);
+    parse_model_free(model);
+    remove(path);
+}
+
+
 int run_parser_tests(void)
 {
     void* s = test_setup;
@@ -109,6 +185,9 @@ int run_parser_tests(void)
     const struct CMUnitTest _tests[] = {
         cmocka_unit_test_setup_teardown(test_xml_parse_bus_topology, s, t),
         cmocka_unit_test_setup_teardown(test_xml_parse_binary_to_text, s, t),
+        cmocka_unit_test_setup_teardown(test_xml_parse_model_description, s, t),
+        cmocka_unit_test_setup_teardown(
+            test_xml_parse_model_variables_only, s, t),
     };
 
     return cmocka_run_group_tests_name("PARSER", _tests, NULL, NULL);